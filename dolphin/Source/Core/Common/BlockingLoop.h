@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <thread>
 
@@ -118,6 +120,17 @@ public:
     m_may_sleep.Set();
   }
 
+  // Spin-then-park. Without new work, the loop polls for at most the spin time before it sleeps,
+  // even if AllowSleep() wasn't called. The spin time adapts between max_spin / 16 and max_spin:
+  // it doubles when new work arrived sooner than the loop would have spun, and halves when the
+  // loop slept longer.
+  // 0, the default, keeps polling until AllowSleep() is called. Call this before Run().
+  void SetMaxSpinTime(std::chrono::microseconds max_spin)
+  {
+    m_max_spin = max_spin;
+    m_spin = max_spin;
+  }
+
   // Main loop of this object.
   // The payload callback is called at least as often as it's needed to match the Wakeup()
   // requirements.
@@ -130,6 +143,9 @@ public:
     // But a good implementation should call this before already.
     Prepare();
 
+    bool spinning = false;
+    std::chrono::steady_clock::time_point spin_start;
+
     while (!m_shutdown.IsSet())
     {
       payload();
@@ -143,6 +159,7 @@ public:
         // remaining tasks.
         // To process this tasks, we call the payload again within the STATE_LAST_EXECUTION state.
         m_running_state--;
+        spinning = false;
         break;
 
       case STATE_LAST_EXECUTION:
@@ -151,6 +168,7 @@ public:
         // execution of the payload. This means we should be ready now.
         // But bad luck, Wakeup may have been called right now. So break and rerun the payload
         // if the state was touched.
+        spinning = false;
         if (m_running_state-- != STATE_LAST_EXECUTION)
           break;
 
@@ -162,7 +180,7 @@ public:
       case STATE_DONE:
         // We're done now. So time to check if we want to sleep or if we want to stay in a busy
         // loop.
-        if (m_may_sleep.TestAndClear())
+        if (m_may_sleep.TestAndClear() || SpinTimeElapsed(&spinning, &spin_start))
         {
           // Try to set the sleeping state.
           if (m_running_state-- != STATE_DONE)
@@ -175,7 +193,9 @@ public:
         }
 
       case STATE_SLEEPING:
+      {
         // Just relax
+        const auto sleep_start = std::chrono::steady_clock::now();
         if (timeout > 0)
         {
           m_new_work_event.WaitFor(std::chrono::milliseconds(timeout));
@@ -184,8 +204,12 @@ public:
         {
           m_new_work_event.Wait();
         }
+        if (m_max_spin.count() > 0)
+          AdaptSpinTime(std::chrono::steady_clock::now() - sleep_start);
+        spinning = false;
         break;
       }
+      }
     }
 
     // Shutdown down, so get a safe state
@@ -232,6 +256,32 @@ public:
   void AllowSleep() { m_may_sleep.Set(); }
 
 private:
+  // Only called by the loop thread.
+  bool SpinTimeElapsed(bool* spinning, std::chrono::steady_clock::time_point* spin_start)
+  {
+    if (m_max_spin.count() <= 0)
+      return false;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (!*spinning)
+    {
+      *spinning = true;
+      *spin_start = now;
+      return false;
+    }
+    return now - *spin_start >= m_spin;
+  }
+
+  void AdaptSpinTime(std::chrono::steady_clock::duration slept)
+  {
+    const std::chrono::microseconds min_spin =
+        std::max(m_max_spin / 16, std::chrono::microseconds(1));
+    if (slept < m_spin)
+      m_spin = std::min(m_spin * 2, m_max_spin);
+    else
+      m_spin = std::max(m_spin / 2, min_spin);
+  }
+
   std::mutex m_wait_lock;
   std::mutex m_prepare_lock;
 
@@ -252,5 +302,9 @@ private:
 
   Flag m_may_sleep;  // If this is set, we fall back from the busy loop to an event based
                      // synchronization.
+
+  // Spin-then-park, see SetMaxSpinTime().
+  std::chrono::microseconds m_max_spin{0};
+  std::chrono::microseconds m_spin{0};
 };
 }  // namespace Common
@@ -85,6 +85,8 @@ const Info<int> GFX_COMMAND_BUFFER_EXECUTE_INTERVAL{
 const Info<bool> GFX_SHADER_CACHE{{System::GFX, "Settings", "ShaderCache"}, true};
 const Info<bool> GFX_WAIT_FOR_SHADERS_BEFORE_STARTING{
     {System::GFX, "Settings", "WaitForShadersBeforeStarting"}, false};
+const Info<bool> GFX_PRECOMPILE_LIBRARY_SHADERS{
+    {System::GFX, "Settings", "PrecompileLibraryShaders"}, false};
 const Info<ShaderCompilationMode> GFX_SHADER_COMPILATION_MODE{
     {System::GFX, "Settings", "ShaderCompilationMode"}, ShaderCompilationMode::Synchronous};
 const Info<int> GFX_SHADER_COMPILER_THREADS{{System::GFX, "Settings", "ShaderCompilerThreads"}, 1};
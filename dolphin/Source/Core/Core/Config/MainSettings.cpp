@@ -106,6 +106,16 @@ const Info<bool> MAIN_CUSTOM_RTC_ENABLE{{System::Main, "Core", "EnableCustomRTC"
 const Info<u32> MAIN_CUSTOM_RTC_VALUE{{System::Main, "Core", "CustomRTCValue"}, 946684800};
 const Info<bool> MAIN_AUTO_DISC_CHANGE{{System::Main, "Core", "AutoDiscChange"}, false};
 const Info<bool> MAIN_ALLOW_SD_WRITES{{System::Main, "Core", "WiiSDCardAllowWrites"}, true};
+const Info<bool> MAIN_REWIND_ENABLE{{System::Main, "Core", "Rewind"}, false};
+// frames between two snapshots
+const Info<int> MAIN_REWIND_INTERVAL{{System::Main, "Core", "RewindInterval"}, 30};
+// MiB for the compressed snapshots
+const Info<int> MAIN_REWIND_BUFFER_SIZE{{System::Main, "Core", "RewindBufferSize"}, 256};
+// 32-byte blocks the GPU thread decodes before it hands back FIFO space (dual core)
+const Info<int> MAIN_GPU_FIFO_BATCH{{System::Main, "Core", "GPUFifoBatch"}, 8};
+// Longest the idle GPU thread polls before it sleeps, in microseconds. 0 polls until the next
+// 1 kHz throttle tick, as before.
+const Info<int> MAIN_GPU_SPIN_TIME{{System::Main, "Core", "GPUSpinTime"}, 200};
 
 // Main.Display
 
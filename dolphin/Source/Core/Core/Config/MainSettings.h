@@ -87,6 +87,11 @@ extern const Info<bool> MAIN_CUSTOM_RTC_ENABLE;
 extern const Info<u32> MAIN_CUSTOM_RTC_VALUE;
 extern const Info<bool> MAIN_AUTO_DISC_CHANGE;
 extern const Info<bool> MAIN_ALLOW_SD_WRITES;
+extern const Info<bool> MAIN_REWIND_ENABLE;
+extern const Info<int> MAIN_REWIND_INTERVAL;
+extern const Info<int> MAIN_REWIND_BUFFER_SIZE;
+extern const Info<int> MAIN_GPU_FIFO_BATCH;
+extern const Info<int> MAIN_GPU_SPIN_TIME;
 
 // Main.DSP
 
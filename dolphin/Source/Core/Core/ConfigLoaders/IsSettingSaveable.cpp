@@ -32,7 +32,7 @@ bool IsSettingSaveable(const Config::Location& config_location)
     }
   }
 
-  static constexpr std::array<const Config::Location*, 13> s_setting_saveable = {
+  static constexpr std::array<const Config::Location*, 18> s_setting_saveable = {
       // Main.Core
 
       &Config::MAIN_DEFAULT_ISO.location,
@@ -46,6 +46,11 @@ bool IsSettingSaveable(const Config::Location& config_location)
       &Config::MAIN_MEM1_SIZE.location,
       &Config::MAIN_MEM2_SIZE.location,
       &Config::MAIN_GFX_BACKEND.location,
+      &Config::MAIN_REWIND_ENABLE.location,
+      &Config::MAIN_REWIND_INTERVAL.location,
+      &Config::MAIN_REWIND_BUFFER_SIZE.location,
+      &Config::MAIN_GPU_FIFO_BATCH.location,
+      &Config::MAIN_GPU_SPIN_TIME.location,
 
       // Main.Interface
 
@@ -62,6 +62,7 @@
 #include "Core/PatchEngine.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PowerPC.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "Core/WiiRoot.h"
 
@@ -92,6 +93,7 @@ static bool s_wants_determinism;
 static Common::Timer s_timer;
 static std::atomic<u32> s_drawn_frame;
 static std::atomic<u32> s_drawn_video;
+static std::atomic<u64> s_presented_frames;
 
 static bool s_is_stopping = false;
 static bool s_hardware_initialized = false;
@@ -146,6 +148,7 @@ void OnFrameEnd()
   if (s_memory_watcher)
     s_memory_watcher->Step();
 #endif
+  Rewind::FrameUpdate();
 }
 
 // Display messages and return values
@@ -239,6 +242,7 @@ bool Init(std::unique_ptr<BootParameters> boot, const WindowSystemInfo& wsi)
   g_video_backend->PrepareWindow(prepared_wsi);
 
   // Start the emu thread
+  s_presented_frames.store(0);
   s_done_booting.Reset();
   s_is_booting.Set();
   s_emu_thread = std::thread(EmuThread, std::move(boot), prepared_wsi);
@@ -860,9 +864,15 @@ void VideoThrottle()
 void Callback_FramePresented()
 {
   s_drawn_frame++;
+  s_presented_frames++;
   s_stop_frame_step.store(true);
 }
 
+u64 GetPresentedFrameCount()
+{
+  return s_presented_frames.load();
+}
+
 // Called from VideoInterface::Update (CPU thread) at emulated field boundaries
 void Callback_NewField()
 {
@@ -28,6 +28,9 @@ void SetIsThrottlerTempDisabled(bool disable);
 void Callback_FramePresented();
 void Callback_NewField();
 
+// Frames presented to the host screen since the last Init(), for time to first frame measurements
+u64 GetPresentedFrameCount();
+
 enum class State
 {
   Uninitialized,
@@ -24,6 +24,7 @@
 #include "Core/HW/VideoInterface.h"
 #include "Core/HW/WII_IPC.h"
 #include "Core/IOS/IOS.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "Core/WiiRoot.h"
 
@@ -57,10 +58,14 @@ void Init()
     IOS::Init();
     IOS::HLE::Init();  // Depends on Memory
   }
+
+  Rewind::Init();
 }
 
 void Shutdown()
 {
+  Rewind::Shutdown();
+
   // IOS should always be shut down regardless of bWii because it can be running in GC mode (MIOS).
   IOS::HLE::Shutdown();  // Depends on Memory
   IOS::Shutdown();
@@ -0,0 +1,359 @@
+// Copyright 2021 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "Core/Rewind.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <zstd.h>
+
+#include "Common/Config/Config.h"
+#include "Common/Logging/Log.h"
+#include "Common/Thread.h"
+#include "Core/Config/MainSettings.h"
+#include "Core/Core.h"
+#include "Core/NetPlayProto.h"
+#include "Core/State.h"
+
+namespace Rewind
+{
+// Fast is what matters here, the deltas are mostly zeroes anyway.
+constexpr int COMPRESSION_LEVEL = 1;
+constexpr size_t COMPRESSION_CHUNK_SIZE = 1024 * 1024;
+
+struct Snapshot
+{
+  // zstd frames of this capture XOR the capture before it
+  std::vector<u8> delta;
+};
+
+static std::atomic<bool> s_enabled{false};
+static u32 s_interval;
+static size_t s_budget;
+
+// CPU thread
+static u32 s_frames_since_capture;
+static std::atomic<bool> s_capture_queued{false};
+// Incremented by StepBack(), captures queued before are dropped.
+static std::atomic<u32> s_generation{0};
+static std::atomic<u64> s_frames{0};
+
+// Held by a capture in progress (host thread), so Shutdown() can wait for it.
+static std::mutex s_capture_mutex;
+
+// Held by the worker while it works on a capture, and by StepBack().
+// s_newest is only changed with both mutexes held.
+static std::mutex s_worker_mutex;
+
+// Protects everything below.
+static std::mutex s_mutex;
+static std::condition_variable s_cv;
+static bool s_quit;
+static std::vector<u8> s_pending;  // captured, waiting for the worker
+static bool s_pending_valid;
+static std::vector<u8> s_newest;  // uncompressed
+static std::deque<Snapshot> s_ring;
+static size_t s_ring_bytes;
+static Stats s_stats;
+
+static std::thread s_worker;
+
+static void XorInto(u8* dst, const u8* src, size_t size)
+{
+  size_t i = 0;
+  for (; i + sizeof(u64) <= size; i += sizeof(u64))
+  {
+    u64 a, b;
+    std::memcpy(&a, dst + i, sizeof(u64));
+    std::memcpy(&b, src + i, sizeof(u64));
+    a ^= b;
+    std::memcpy(dst + i, &a, sizeof(u64));
+  }
+  for (; i < size; i++)
+    dst[i] ^= src[i];
+}
+
+// Compresses in chunks, which saves a scratch buffer of the size of a state.
+// ZSTD_decompress() reads the concatenated frames in one go.
+static bool Compress(ZSTD_CCtx* cctx, const std::vector<u8>& data, std::vector<u8>* out)
+{
+  out->clear();
+  for (size_t offset = 0; offset < data.size(); offset += COMPRESSION_CHUNK_SIZE)
+  {
+    const size_t length = std::min(COMPRESSION_CHUNK_SIZE, data.size() - offset);
+    const size_t out_offset = out->size();
+    out->resize(out_offset + ZSTD_compressBound(length));
+    const size_t result = ZSTD_compressCCtx(cctx, out->data() + out_offset, out->size() - out_offset,
+                                            data.data() + offset, length, COMPRESSION_LEVEL);
+    if (ZSTD_isError(result))
+      return false;
+    out->resize(out_offset + result);
+  }
+  out->shrink_to_fit();
+  return true;
+}
+
+// Worker thread, with s_worker_mutex held. state is left in an unspecified state.
+static void AddSnapshot(ZSTD_CCtx* cctx, std::vector<u8>& state)
+{
+  if (s_newest.size() != state.size())
+  {
+    // The first capture, or the size of the state changed (e.g. a different game mode).
+    // Older snapshots cannot be rebuilt from this one.
+    std::lock_guard<std::mutex> lk(s_mutex);
+    s_ring.clear();
+    s_ring_bytes = 0;
+    s_newest.swap(state);
+    return;
+  }
+
+  // state becomes the delta, and the delta turns s_newest into the new capture
+  XorInto(state.data(), s_newest.data(), state.size());
+  Snapshot snapshot;
+  const bool compressed = Compress(cctx, state, &snapshot.delta);
+
+  std::lock_guard<std::mutex> lk(s_mutex);
+  XorInto(s_newest.data(), state.data(), state.size());
+  if (!compressed)
+  {
+    ERROR_LOG(CORE, "Rewind: compression failed, older snapshots are dropped");
+    s_ring.clear();
+    s_ring_bytes = 0;
+    return;
+  }
+
+  s_ring_bytes += snapshot.delta.size();
+  s_ring.push_back(std::move(snapshot));
+  while (s_ring_bytes > s_budget && !s_ring.empty())
+  {
+    s_ring_bytes -= s_ring.front().delta.size();
+    s_ring.pop_front();
+  }
+}
+
+static void WorkerThread()
+{
+  Common::SetCurrentThreadName("Rewind worker");
+
+  ZSTD_CCtx* cctx = ZSTD_createCCtx();
+  std::vector<u8> state;
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lk(s_mutex);
+      s_cv.wait(lk, [] { return s_pending_valid || s_quit; });
+      if (s_quit)
+        break;
+    }
+
+    std::lock_guard<std::mutex> worker_lock(s_worker_mutex);
+    {
+      std::lock_guard<std::mutex> lk(s_mutex);
+      // StepBack() drops captures taken after the snapshot it loads
+      if (!s_pending_valid)
+        continue;
+      state.swap(s_pending);
+      s_pending_valid = false;
+    }
+    AddSnapshot(cctx, state);
+  }
+  ZSTD_freeCCtx(cctx);
+}
+
+// Host thread
+static void Capture(u32 generation)
+{
+  s_capture_queued = false;
+
+  std::lock_guard<std::mutex> capture_lock(s_capture_mutex);
+  if (!s_enabled || generation != s_generation || Core::GetState() != Core::State::Running ||
+      NetPlay::IsNetPlayRunning())
+  {
+    return;
+  }
+
+  std::vector<u8> state;
+  {
+    std::lock_guard<std::mutex> lk(s_mutex);
+    if (s_pending_valid)
+    {
+      s_stats.skipped_captures++;
+      return;
+    }
+    // reuses the memory of the capture before
+    state.swap(s_pending);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  State::SaveToBuffer(state);
+  const u64 us = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+  std::lock_guard<std::mutex> lk(s_mutex);
+  s_stats.captures++;
+  s_stats.capture_us += us;
+  s_stats.max_capture_us = std::max(s_stats.max_capture_us, us);
+  if (state.empty())
+    return;
+  s_pending.swap(state);
+  s_pending_valid = true;
+  s_cv.notify_one();
+}
+
+void Init()
+{
+  {
+    std::lock_guard<std::mutex> lk(s_mutex);
+    s_stats = Stats{};
+    s_quit = false;
+    s_pending_valid = false;
+  }
+  s_frames = 0;
+  s_frames_since_capture = 0;
+  s_capture_queued = false;
+
+  if (!Config::Get(Config::MAIN_REWIND_ENABLE))
+    return;
+
+  s_interval = static_cast<u32>(std::max(Config::Get(Config::MAIN_REWIND_INTERVAL), 1));
+  s_budget = static_cast<size_t>(std::max(Config::Get(Config::MAIN_REWIND_BUFFER_SIZE), 1)) << 20;
+  INFO_LOG(CORE, "Rewind: a snapshot every %u frames, %zu MiB", s_interval, s_budget >> 20);
+
+  s_worker = std::thread(WorkerThread);
+  s_enabled = true;
+}
+
+void Shutdown()
+{
+  if (!s_enabled)
+    return;
+  s_enabled = false;
+
+  // wait for a capture in progress, later ones see s_enabled
+  {
+    std::lock_guard<std::mutex> capture_lock(s_capture_mutex);
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(s_mutex);
+    s_quit = true;
+    s_cv.notify_one();
+  }
+  s_worker.join();
+
+  std::lock_guard<std::mutex> lk(s_mutex);
+  s_stats.snapshots = static_cast<u32>(s_ring.size() + (s_newest.empty() ? 0 : 1));
+  s_stats.ring_bytes = s_ring_bytes;
+  s_stats.state_bytes = s_newest.size();
+  s_stats.frames = s_frames;
+
+  // swapping with empty vectors frees the memory right now
+  std::vector<u8>().swap(s_pending);
+  std::vector<u8>().swap(s_newest);
+  std::deque<Snapshot>().swap(s_ring);
+  s_ring_bytes = 0;
+  s_pending_valid = false;
+}
+
+bool IsEnabled()
+{
+  return s_enabled;
+}
+
+void FrameUpdate()
+{
+  if (!s_enabled)
+    return;
+
+  s_frames++;
+  if (++s_frames_since_capture < s_interval || s_capture_queued)
+    return;
+  s_frames_since_capture = 0;
+
+  // Captures run where State::Save() does, between two CPU slices. A savestate taken
+  // right here, in the middle of a CoreTiming event, would miss the VI event.
+  s_capture_queued = true;
+  Core::QueueHostJob([generation = s_generation.load()] { Capture(generation); });
+}
+
+bool StepBack()
+{
+  if (!s_enabled || !Core::IsRunningAndStarted())
+    return false;
+
+  std::vector<u8> state;
+  size_t steps_left;
+  {
+    std::lock_guard<std::mutex> worker_lock(s_worker_mutex);
+    std::lock_guard<std::mutex> lk(s_mutex);
+
+    s_generation++;
+    s_pending_valid = false;
+    if (s_newest.empty())
+    {
+      Core::DisplayMessage("Rewind: no older state", 1500);
+      return false;
+    }
+
+    state.swap(s_newest);
+    if (!s_ring.empty())
+    {
+      // rebuild the capture before the one being loaded
+      const Snapshot& snapshot = s_ring.back();
+      s_newest.resize(state.size());
+      const size_t result = ZSTD_decompress(s_newest.data(), s_newest.size(),
+                                            snapshot.delta.data(), snapshot.delta.size());
+      if (ZSTD_isError(result) || result != s_newest.size())
+      {
+        ERROR_LOG(CORE, "Rewind: decompression failed, older snapshots are dropped");
+        s_newest.clear();
+        s_ring.clear();
+        s_ring_bytes = 0;
+      }
+      else
+      {
+        XorInto(s_newest.data(), state.data(), state.size());
+        s_ring_bytes -= snapshot.delta.size();
+        s_ring.pop_back();
+      }
+    }
+    steps_left = s_ring.size() + (s_newest.empty() ? 0 : 1);
+  }
+
+  State::LoadFromBuffer(state);
+  Core::DisplayMessage(fmt::format("Rewind: {} older states", steps_left), 1000);
+
+  // nothing is pending, the buffer can be reused for the next capture
+  {
+    std::lock_guard<std::mutex> lk(s_mutex);
+    if (!s_pending_valid)
+      s_pending.swap(state);
+  }
+  return true;
+}
+
+Stats GetStats()
+{
+  std::lock_guard<std::mutex> lk(s_mutex);
+  if (!s_enabled)
+    return s_stats;
+
+  Stats stats = s_stats;
+  stats.snapshots = static_cast<u32>(s_ring.size() + (s_newest.empty() ? 0 : 1));
+  stats.ring_bytes = s_ring_bytes;
+  stats.state_bytes = s_newest.size();
+  stats.frames = s_frames;
+  return stats;
+}
+}  // namespace Rewind
@@ -0,0 +1,50 @@
+// Copyright 2021 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// In-memory rewind.
+//
+// Every few frames, a savestate is captured into RAM. A worker thread XORs it with the
+// previous capture and compresses the difference with zstd. The compressed deltas are kept
+// in a ring bounded by a memory budget; the oldest ones are dropped first.
+// Only the newest capture is kept uncompressed. Stepping back loads it and rebuilds the
+// capture before it from its delta, so every step goes one capture further back.
+//
+// Besides the budget, three uncompressed states are in memory: the newest capture, the one
+// waiting for the worker and the one being compressed.
+
+#pragma once
+
+#include <cstddef>
+
+#include "Common/CommonTypes.h"
+
+namespace Rewind
+{
+struct Stats
+{
+  u32 snapshots = 0;      // states that can be stepped back to
+  size_t ring_bytes = 0;  // compressed deltas
+  size_t state_bytes = 0;
+  u64 frames = 0;
+  u64 captures = 0;
+  u64 skipped_captures = 0;  // the worker was still busy with the previous one
+  u64 capture_us = 0;        // emulation paused for captures, in total
+  u64 max_capture_us = 0;
+};
+
+// Reads the settings (MAIN_REWIND_*) and starts the worker if rewind is enabled.
+void Init();
+void Shutdown();
+bool IsEnabled();
+
+// Called on the CPU thread at the end of every frame, schedules a capture every
+// MAIN_REWIND_INTERVAL frames. The capture itself runs as a host job.
+void FrameUpdate();
+
+// Host thread. Loads the newest snapshot, returns false if there is none.
+bool StepBack();
+
+// Kept after Shutdown() until the next Init().
+Stats GetStats();
+}  // namespace Rewind
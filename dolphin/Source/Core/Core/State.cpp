@@ -4,6 +4,8 @@
 
 #include "Core/State.h"
 
+#include <algorithm>
+#include <atomic>
 #include <lzo/lzo1x.h>
 #include <map>
 #include <mutex>
@@ -12,6 +14,8 @@
 #include <utility>
 #include <vector>
 
+#include <zstd.h>
+
 #include <fmt/format.h>
 
 #include "Common/ChunkFile.h"
@@ -55,10 +59,15 @@ static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
 
 static unsigned char __LZO_MMODEL out[OUT_LEN];
 
-#define HEAP_ALLOC(var, size)                                                                      \
-  lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
-
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);
+// States are written with zstd in chunks that are compressed and decompressed in parallel.
+// After the StateHeader, a compressed state holds the magic, the chunk size, the number
+// of chunks and the compressed size of every chunk, followed by the chunks.
+// States written with LZO start with the length of their first chunk instead, which is
+// never larger than OUT_LEN, so they can still be loaded.
+constexpr u32 ZSTD_STATE_MAGIC = 0x5A545344;  // "DSTZ"
+constexpr u32 ZSTD_STATE_CHUNK_SIZE = 1024 * 1024;
+constexpr int ZSTD_STATE_LEVEL = 3;
+constexpr size_t MAX_STATE_THREADS = 8;
 
 static AfterLoadCallbackFunc s_on_after_load_callback;
 
@@ -301,6 +310,115 @@ static std::map<double, int> GetSavedStates()
   return m;
 }
 
+// Calls func(i) for every i in [0, count), spread over up to MAX_STATE_THREADS threads
+// including the calling one.
+template <typename Func>
+static void ParallelFor(size_t count, const Func& func)
+{
+  const size_t num_threads = std::min<size_t>(
+      {count, std::max<size_t>(std::thread::hardware_concurrency(), 1), MAX_STATE_THREADS});
+  std::atomic<size_t> next{0};
+  const auto worker = [&] {
+    for (size_t i = next++; i < count; i = next++)
+      func(i);
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; i++)
+    threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+static bool CompressZstd(const u8* data, size_t size, std::vector<std::vector<u8>>* chunks)
+{
+  const size_t chunk_count = (size + ZSTD_STATE_CHUNK_SIZE - 1) / ZSTD_STATE_CHUNK_SIZE;
+  std::atomic<bool> failed{false};
+
+  chunks->resize(chunk_count);
+  ParallelFor(chunk_count, [&](size_t i) {
+    const size_t offset = i * ZSTD_STATE_CHUNK_SIZE;
+    const size_t length = std::min<size_t>(ZSTD_STATE_CHUNK_SIZE, size - offset);
+    std::vector<u8>& chunk = (*chunks)[i];
+
+    chunk.resize(ZSTD_compressBound(length));
+    const size_t result =
+        ZSTD_compress(chunk.data(), chunk.size(), data + offset, length, ZSTD_STATE_LEVEL);
+    if (ZSTD_isError(result))
+    {
+      failed = true;
+      return;
+    }
+    chunk.resize(result);
+  });
+  return !failed;
+}
+
+static void WriteZstd(File::IOFile& f, const std::vector<std::vector<u8>>& chunks)
+{
+  const u32 chunk_count = static_cast<u32>(chunks.size());
+  std::vector<u32> chunk_sizes;
+  chunk_sizes.reserve(chunks.size());
+  for (const std::vector<u8>& chunk : chunks)
+    chunk_sizes.push_back(static_cast<u32>(chunk.size()));
+
+  f.WriteArray(&ZSTD_STATE_MAGIC, 1);
+  f.WriteArray(&ZSTD_STATE_CHUNK_SIZE, 1);
+  f.WriteArray(&chunk_count, 1);
+  f.WriteArray(chunk_sizes.data(), chunk_sizes.size());
+  for (const std::vector<u8>& chunk : chunks)
+    f.WriteBytes(chunk.data(), chunk.size());
+}
+
+// Reads the chunks following ZSTD_STATE_MAGIC, the buffer has the size from the StateHeader.
+static bool DecompressZstd(File::IOFile& f, std::vector<u8>& buffer)
+{
+  u32 chunk_size = 0;
+  u32 chunk_count = 0;
+  if (!f.ReadArray(&chunk_size, 1) || !f.ReadArray(&chunk_count, 1) || chunk_size == 0)
+    return false;
+  if (chunk_count != (buffer.size() + chunk_size - 1) / chunk_size)
+    return false;
+
+  std::vector<u32> chunk_sizes(chunk_count);
+  if (!f.ReadArray(chunk_sizes.data(), chunk_sizes.size()))
+    return false;
+
+  // The sizes come from the file, a damaged state must not make us allocate gigabytes.
+  const u64 file_size = f.GetSize();
+  const u64 position = f.Tell();
+  if (position > file_size)
+    return false;
+  const u64 bytes_left = file_size - position;
+  std::vector<size_t> chunk_offsets(chunk_count);
+  u64 compressed_size = 0;
+  for (u32 i = 0; i < chunk_count; i++)
+  {
+    if (chunk_sizes[i] > ZSTD_compressBound(chunk_size))
+      return false;
+    chunk_offsets[i] = compressed_size;
+    compressed_size += chunk_sizes[i];
+  }
+  if (compressed_size > bytes_left)
+    return false;
+
+  std::vector<u8> compressed(compressed_size);
+  if (!f.ReadBytes(compressed.data(), compressed.size()))
+    return false;
+
+  std::atomic<bool> failed{false};
+  ParallelFor(chunk_count, [&](size_t i) {
+    const size_t offset = i * chunk_size;
+    const size_t length = std::min<size_t>(chunk_size, buffer.size() - offset);
+    const size_t result = ZSTD_decompress(&buffer[offset], length, &compressed[chunk_offsets[i]],
+                                          chunk_sizes[i]);
+    if (ZSTD_isError(result) || result != length)
+      failed = true;
+  });
+  return !failed;
+}
+
 struct CompressAndDumpState_args
 {
   std::vector<u8>* buffer_vector;
@@ -359,43 +477,25 @@ static void CompressAndDumpState(CompressAndDumpState_args save_args)
     return;
   }
 
+  std::vector<std::vector<u8>> chunks;
+  bool compressed = g_use_compression && buffer_size != 0;
+  if (compressed && !CompressZstd(buffer_data, buffer_size, &chunks))
+  {
+    PanicAlertT("Internal zstd Error - compression failed, the state is saved uncompressed");
+    compressed = false;
+  }
+
   // Setting up the header
   StateHeader header{};
   SConfig::GetInstance().GetGameID().copy(header.gameID, std::size(header.gameID));
-  header.size = g_use_compression ? (u32)buffer_size : 0;
+  header.size = compressed ? (u32)buffer_size : 0;
   header.time = Common::Timer::GetDoubleTime();
 
   f.WriteArray(&header, 1);
 
   if (header.size != 0)  // non-zero header size means the state is compressed
   {
-    lzo_uint i = 0;
-    while (true)
-    {
-      lzo_uint32 cur_len = 0;
-      lzo_uint out_len = 0;
-
-      if ((i + IN_LEN) >= buffer_size)
-      {
-        cur_len = (lzo_uint32)(buffer_size - i);
-      }
-      else
-      {
-        cur_len = IN_LEN;
-      }
-
-      if (lzo1x_1_compress(buffer_data + i, cur_len, out, &out_len, wrkmem) != LZO_E_OK)
-        PanicAlertT("Internal LZO Error - compression failed");
-
-      // The size of the data to write is 'out_len'
-      f.WriteArray((lzo_uint32*)&out_len, 1);
-      f.WriteBytes(out, out_len);
-
-      if (cur_len != IN_LEN)
-        break;
-
-      i += cur_len;
-    }
+    WriteZstd(f, chunks);
   }
   else  // uncompressed
   {
@@ -511,27 +611,48 @@ static void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_
 
     buffer.resize(header.size);
 
-    lzo_uint i = 0;
-    while (true)
+    u32 cur_len = 0;  // number of bytes to read, or ZSTD_STATE_MAGIC
+    if (!f.ReadArray(&cur_len, 1))
     {
-      lzo_uint32 cur_len = 0;  // number of bytes to read
-      lzo_uint new_len = 0;    // number of bytes to write
-
-      if (!f.ReadArray(&cur_len, 1))
-        break;
+      Core::DisplayMessage("The savestate is truncated", 2000);
+      return;
+    }
 
-      f.ReadBytes(out, cur_len);
-      const int res = lzo1x_decompress(out, cur_len, &buffer[i], &new_len, nullptr);
-      if (res != LZO_E_OK)
+    if (cur_len == ZSTD_STATE_MAGIC)
+    {
+      if (!DecompressZstd(f, buffer))
       {
-        // This doesn't seem to happen anymore.
-        PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
-                    "Try loading the state again",
-                    res, i, new_len);
+        PanicAlertT("Internal zstd Error - decompression failed\n"
+                    "Try loading the state again");
         return;
       }
+    }
+    else  // written with LZO by an older version
+    {
+      lzo_uint i = 0;
+      do
+      {
+        lzo_uint new_len = 0;  // number of bytes to write
+
+        if (cur_len > OUT_LEN || !f.ReadBytes(out, cur_len))
+        {
+          PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
+                      "Try loading the state again",
+                      LZO_E_INPUT_OVERRUN, i, new_len);
+          return;
+        }
+        const int res = lzo1x_decompress(out, cur_len, &buffer[i], &new_len, nullptr);
+        if (res != LZO_E_OK)
+        {
+          // This doesn't seem to happen anymore.
+          PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
+                      "Try loading the state again",
+                      res, i, new_len);
+          return;
+        }
 
-      i += new_len;
+        i += new_len;
+      } while (f.ReadArray(&cur_len, 1));
     }
   }
   else  // uncompressed
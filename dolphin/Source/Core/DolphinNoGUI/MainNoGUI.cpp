@@ -16,10 +16,13 @@
 #include <Windows.h>
 #endif
 
+#include "Common/Config/Config.h"
 #include "Common/StringUtil.h"
 #include "Core/Analytics.h"
 #include "Core/Boot/Boot.h"
 #include "Core/BootManager.h"
+#include "Core/Config/GraphicsSettings.h"
+#include "Core/Config/MainSettings.h"
 #include "Core/Core.h"
 #include "Core/Host.h"
 
@@ -132,6 +135,14 @@ static std::unique_ptr<Platform> GetPlatform(const optparse::Values& options)
 }
 #warning "JC: modfied"
 extern bool requestShutdown_;
+// Warm start: UICommon stays initialised between games (the launcher keeps it for the
+// wiimotes anyway), a new game only reloads the settings.
+bool dolphin_warm_start = true;
+// Keeps the last minutes of the game in memory, Backspace steps back (see Core/Rewind.h).
+bool dolphin_rewind = false;
+// Compiles the pipelines of all games played before, ahead of the game start
+// (see ShaderCache::LoadLibraryPipelineUIDs()).
+bool dolphin_precompile_shaders = false;
 int dolphin_main(int argc, char* argv[])
 {
   requestShutdown_ = false;
@@ -198,10 +209,22 @@ int dolphin_main(int argc, char* argv[])
     return 0;
   }
 
-  std::string user_directory = gBaseDir;
-  user_directory += "dolphin-emu";
-  UICommon::SetUserDirectory(user_directory);
-  UICommon::Init();
+  if (dolphin_warm_start && UICommon::IsInitialized())
+  {
+    UICommon::ReloadSettings();
+  }
+  else
+  {
+    std::string user_directory = gBaseDir;
+    user_directory += "dolphin-emu";
+    UICommon::SetUserDirectory(user_directory);
+    UICommon::Init();
+  }
+  // for this run only, not written to Dolphin.ini
+  if (dolphin_rewind)
+    Config::SetCurrent(Config::MAIN_REWIND_ENABLE, true);
+  if (dolphin_precompile_shaders)
+    Config::SetCurrent(Config::GFX_PRECOMPILE_LIBRARY_SHADERS, true);
 
   s_platform = GetPlatform(options);
   if (!s_platform || !s_platform->Init())
@@ -10,6 +10,7 @@
 #include "Core/Config/MainSettings.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 
 #include <climits>
@@ -213,6 +214,9 @@ void PlatformX11::ProcessEvents()
         if(event.type==SDL_KEYDOWN&&event.key.keysym.sym==SDLK_F7)
             State::Load(0);
         
+        if(event.type==SDL_KEYDOWN&&event.key.keysym.sym==SDLK_BACKSPACE)
+            Rewind::StepBack();
+        
         if(event.type==SDL_KEYDOWN&&event.key.keysym.sym==SDLK_F9)
             Core::SaveScreenShot();
         
@@ -87,6 +87,8 @@ static void InitCustomPaths()
     File::SetUserPath(F_WIISDCARD_IDX, sd_path);
 }
 
+static bool s_initialized = false;
+
 void Init()
 {
   Core::RestoreWiiSettings(Core::RestoreReason::CrashRecovery);
@@ -102,6 +104,24 @@ void Init()
   GCAdapter::Init();
   VideoBackendBase::ActivateBackend(Config::Get(Config::MAIN_GFX_BACKEND));
 
+  Common::SetEnableAlert(SConfig::GetInstance().bUsePanicHandlers);
+  s_initialized = true;
+}
+
+bool IsInitialized()
+{
+  return s_initialized;
+}
+
+// Same settings as a new SConfig instance. The config layers, the log manager,
+// the video backend list and the GC adapter thread stay as they are.
+void ReloadSettings()
+{
+  SConfig::GetInstance().LoadDefaults();
+  SConfig::GetInstance().LoadSettings();
+  WiimoteReal::LoadSettings();
+  VideoBackendBase::ActivateBackend(Config::Get(Config::MAIN_GFX_BACKEND));
+
   Common::SetEnableAlert(SConfig::GetInstance().bUsePanicHandlers);
 }
 
@@ -114,6 +134,7 @@ void Shutdown()
   Discord::Shutdown();
   SConfig::Shutdown();
   Config::Shutdown();
+  s_initialized = false;
 }
 
 void SetLocale(std::string locale_name)
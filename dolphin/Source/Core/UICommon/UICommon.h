@@ -12,6 +12,9 @@ namespace UICommon
 {
 void Init();
 void Shutdown();
+bool IsInitialized();
+// Reloads the settings for the next game without running Init() again.
+void ReloadSettings();
 
 #if defined(HAVE_XRANDR) && HAVE_XRANDR
 void EnableScreenSaver(unsigned long win, bool enable);
@@ -4,18 +4,22 @@
 
 #include "VideoCommon/Fifo.h"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstring>
 
 #include "Common/Assert.h"
 #include "Common/Atomic.h"
 #include "Common/BlockingLoop.h"
 #include "Common/ChunkFile.h"
+#include "Common/Config/Config.h"
 #include "Common/Event.h"
 #include "Common/FPURoundMode.h"
 #include "Common/MemoryUtil.h"
 #include "Common/MsgHandler.h"
 
+#include "Core/Config/MainSettings.h"
 #include "Core/ConfigManager.h"
 #include "Core/CoreTiming.h"
 #include "Core/HW/Memmap.h"
@@ -34,9 +38,23 @@ namespace Fifo
 {
 static constexpr u32 FIFO_SIZE = 2 * 1024 * 1024;
 static constexpr int GPU_TIME_SLOT_SIZE = 1000;
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+// The variables the CPU and the GPU thread both write get a cache line each, otherwise every
+// update of one thread invalidates the line the other one is polling.
+template <typename T>
+struct alignas(CACHE_LINE_SIZE) CacheLinePadded
+{
+  T value{};
+};
 
 static Common::BlockingLoop s_gpu_mainloop;
 
+// Dual core: the GPU thread decodes up to this many 32-byte blocks before it publishes the read
+// pointer and the distance, instead of one atomic update per block. See RunGpuLoop().
+static u32 s_batch_blocks = 1;
+static std::chrono::microseconds s_spin_time{0};
+
 static Common::Flag s_emu_running_state;
 
 // Most of this array is unlikely to be faulted in...
@@ -53,8 +71,10 @@ static CoreTiming::EventType* s_event_sync_gpu;
 // STATE_TO_SAVE
 static u8* s_video_buffer;
 static u8* s_video_buffer_read_ptr;
-static std::atomic<u8*> s_video_buffer_write_ptr;
-static std::atomic<u8*> s_video_buffer_seen_ptr;
+static CacheLinePadded<std::atomic<u8*>> s_video_buffer_write_ptr_line;
+static CacheLinePadded<std::atomic<u8*>> s_video_buffer_seen_ptr_line;
+static std::atomic<u8*>& s_video_buffer_write_ptr = s_video_buffer_write_ptr_line.value;
+static std::atomic<u8*>& s_video_buffer_seen_ptr = s_video_buffer_seen_ptr_line.value;
 static u8* s_video_buffer_pp_read_ptr;
 // The read_ptr is always owned by the GPU thread.  In normal mode, so is the
 // write_ptr, despite it being atomic.  In deterministic GPU thread mode,
@@ -68,7 +88,8 @@ static u8* s_video_buffer_pp_read_ptr;
 // polls, it's just atomic.
 // - The pp_read_ptr is the CPU preprocessing version of the read_ptr.
 
-static std::atomic<int> s_sync_ticks;
+static CacheLinePadded<std::atomic<int>> s_sync_ticks_line;
+static std::atomic<int>& s_sync_ticks = s_sync_ticks_line.value;
 static bool s_syncing_suspended;
 static Common::Event s_sync_wakeup_event;
 
@@ -115,6 +136,9 @@ void Init()
   // Padded so that SIMD overreads in the vertex loader are safe
   s_video_buffer = static_cast<u8*>(Common::AllocateMemoryPages(FIFO_SIZE + 4));
   ResetVideoBuffer();
+  s_batch_blocks = static_cast<u32>(std::clamp(Config::Get(Config::MAIN_GPU_FIFO_BATCH), 1, 64));
+  s_spin_time = std::chrono::microseconds(std::max(Config::Get(Config::MAIN_GPU_SPIN_TIME), 0));
+  s_gpu_mainloop.SetMaxSpinTime(s_spin_time);
   if (SConfig::GetInstance().bCPUThread)
     s_gpu_mainloop.Prepare();
   s_sync_ticks.store(0);
@@ -324,6 +348,9 @@ void RunGpuLoop()
           CommandProcessor::SCPFifoStruct& fifo = CommandProcessor::fifo;
           CommandProcessor::SetCPStatusFromGPU();
 
+          // With SyncGPU, every block is accounted on its own.
+          const u32 max_blocks = param.bSyncGPU ? 1 : s_batch_blocks;
+
           // check if we are able to run this buffer
           while (!CommandProcessor::IsInterruptWaiting() && fifo.bFF_GPReadEnable &&
                  fifo.CPReadWriteDistance && !AtBreakpoint())
@@ -331,26 +358,40 @@ void RunGpuLoop()
             if (param.bSyncGPU && s_sync_ticks.load() < param.iSyncGpuMinDistance)
               break;
 
+            // The distance is read once per batch. The CPU thread only adds to it, so the blocks
+            // counted here are there. The batch still stops at every block that raised an
+            // interrupt or reached the breakpoint, as the loop condition does.
+            const u32 available_blocks = Common::AtomicLoad(fifo.CPReadWriteDistance) / 32;
             u32 cyclesExecuted = 0;
+            u32 blocks = 0;
             u32 readPtr = fifo.CPReadPointer;
-            ReadDataFromFifo(readPtr);
-
-            if (readPtr == fifo.CPEnd)
-              readPtr = fifo.CPBase;
-            else
-              readPtr += 32;
-
-            ASSERT_MSG(COMMANDPROCESSOR, (s32)fifo.CPReadWriteDistance - 32 >= 0,
+            u8* write_ptr;
+            do
+            {
+              ReadDataFromFifo(readPtr);
+
+              if (readPtr == fifo.CPEnd)
+                readPtr = fifo.CPBase;
+              else
+                readPtr += 32;
+
+              u32 cycles = 0;
+              write_ptr = s_video_buffer_write_ptr;
+              s_video_buffer_read_ptr = OpcodeDecoder::Run(
+                  DataReader(s_video_buffer_read_ptr, write_ptr), &cycles, false);
+              cyclesExecuted += cycles;
+              blocks++;
+            } while (blocks < max_blocks && blocks < available_blocks &&
+                     !CommandProcessor::IsInterruptWaiting() && fifo.bFF_GPReadEnable &&
+                     !(fifo.bFF_BPEnable && readPtr == fifo.CPBreakpoint));
+
+            ASSERT_MSG(COMMANDPROCESSOR, (s32)fifo.CPReadWriteDistance - (s32)(blocks * 32) >= 0,
                        "Negative fifo.CPReadWriteDistance = %i in FIFO Loop !\nThat can produce "
                        "instability in the game. Please report it.",
-                       fifo.CPReadWriteDistance - 32);
-
-            u8* write_ptr = s_video_buffer_write_ptr;
-            s_video_buffer_read_ptr = OpcodeDecoder::Run(
-                DataReader(s_video_buffer_read_ptr, write_ptr), &cyclesExecuted, false);
+                       fifo.CPReadWriteDistance - blocks * 32);
 
             Common::AtomicStore(fifo.CPReadPointer, readPtr);
-            Common::AtomicAdd(fifo.CPReadWriteDistance, static_cast<u32>(-32));
+            Common::AtomicAdd(fifo.CPReadWriteDistance, static_cast<u32>(-(s32)(blocks * 32)));
             if ((write_ptr - s_video_buffer_read_ptr) == 0)
               Common::AtomicStore(fifo.SafeCPReadPointer, fifo.CPReadPointer);
 
@@ -551,9 +592,19 @@ static int WaitForGpuThread(int ticks)
   if (now < param.iSyncGpuMinDistance)
     return GPU_TIME_SLOT_SIZE + param.iSyncGpuMinDistance - now;
 
-  // Wait for GPU
+  // Wait for GPU. It usually catches up within a few microseconds, so poll before sleeping.
   if (now >= param.iSyncGpuMaxDistance)
-    s_sync_wakeup_event.Wait();
+  {
+    const auto spin_end = std::chrono::steady_clock::now() + s_spin_time;
+    while (s_sync_ticks.load() >= param.iSyncGpuMaxDistance &&
+           std::chrono::steady_clock::now() < spin_end)
+    {
+    }
+    if (s_sync_ticks.load() >= param.iSyncGpuMaxDistance)
+      s_sync_wakeup_event.Wait();
+    else
+      s_sync_wakeup_event.Reset();
+  }
 
   return GPU_TIME_SLOT_SIZE;
 }
@@ -24,6 +24,7 @@
 #include "VideoCommon/CommandProcessor.h"
 #include "VideoCommon/DataReader.h"
 #include "VideoCommon/Fifo.h"
+#include "VideoCommon/PipelineTimings.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VertexLoaderManager.h"
 #include "VideoCommon/XFMemory.h"
@@ -84,6 +85,10 @@ void Init()
 template <bool is_preprocess>
 u8* Run(DataReader src, u32* cycles, bool in_display_list)
 {
+  // display lists are timed as part of the call that reaches them
+  PipelineTimings::ScopedTimer timer(PipelineTimings::Stage::OpcodeDecoding,
+                                     !is_preprocess && !in_display_list);
+
   u32 total_cycles = 0;
   u8* opcode_start = nullptr;
 
@@ -0,0 +1,86 @@
+// Copyright 2021 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include "VideoCommon/PipelineTimings.h"
+
+#include <mutex>
+
+#include "Common/Logging/Log.h"
+
+namespace PipelineTimings
+{
+// about half an hour at 60 fps, later frames are dropped
+constexpr size_t MAX_FRAMES = 128 * 1024;
+
+static constexpr std::array<const char*, NUM_STAGES> s_stage_names = {
+    "opcode_decoding",
+    "vertex_loading",
+    "texture_decoding",
+};
+
+std::atomic<bool> g_enabled{false};
+
+// video thread
+static std::array<std::atomic<u64>, NUM_STAGES> s_current;
+
+static std::atomic<u32> s_frame_count{0};
+static std::mutex s_mutex;
+static std::vector<Frame> s_frames;
+
+void SetEnabled(bool enabled)
+{
+  std::lock_guard<std::mutex> lk(s_mutex);
+  if (enabled && !g_enabled)
+  {
+    for (auto& ns : s_current)
+      ns = 0;
+    s_frames.clear();
+    s_frame_count = 0;
+  }
+  g_enabled = enabled;
+}
+
+const char* GetStageName(Stage stage)
+{
+  return s_stage_names[static_cast<size_t>(stage)];
+}
+
+void EndFrame()
+{
+  if (!g_enabled.load(std::memory_order_relaxed))
+    return;
+
+  Frame frame;
+  for (size_t i = 0; i < NUM_STAGES; i++)
+    frame[i] = s_current[i].exchange(0, std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lk(s_mutex);
+  if (s_frames.size() >= MAX_FRAMES)
+    return;
+  s_frames.push_back(frame);
+  s_frame_count = static_cast<u32>(s_frames.size());
+  if (s_frames.size() == MAX_FRAMES)
+    WARN_LOG(VIDEO, "Pipeline timings: %zu frames recorded, later ones are dropped", MAX_FRAMES);
+}
+
+u32 GetFrameCount()
+{
+  return s_frame_count;
+}
+
+std::vector<Frame> GetFrames()
+{
+  std::lock_guard<std::mutex> lk(s_mutex);
+  return s_frames;
+}
+
+void ScopedTimer::Stop()
+{
+  const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - m_start)
+                      .count();
+  s_current[static_cast<size_t>(m_stage)].fetch_add(static_cast<u64>(ns),
+                                                     std::memory_order_relaxed);
+}
+}  // namespace PipelineTimings
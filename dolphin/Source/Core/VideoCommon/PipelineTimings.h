@@ -0,0 +1,77 @@
+// Copyright 2021 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Per-frame CPU time of the stages of the video pipeline, for benchmarks (tests/fifoplayer).
+//
+// The timers run on the thread that decodes the FIFO, the GPU thread in dual core. A frame ends
+// in Renderer::Swap(), with the same frames as the statistics. Opcode decoding is the whole time
+// spent on the command stream, so it includes the other stages and the draws.
+// Off by default, a timer then costs a flag check.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace PipelineTimings
+{
+enum class Stage
+{
+  OpcodeDecoding,
+  VertexLoading,
+  TextureDecoding,
+  Count
+};
+
+constexpr size_t NUM_STAGES = static_cast<size_t>(Stage::Count);
+
+// nanoseconds per stage
+using Frame = std::array<u64, NUM_STAGES>;
+
+extern std::atomic<bool> g_enabled;
+
+// Enabling drops the frames recorded before.
+void SetEnabled(bool enabled);
+const char* GetStageName(Stage stage);
+
+// Called on the video thread at the end of every frame.
+void EndFrame();
+
+u32 GetFrameCount();
+std::vector<Frame> GetFrames();
+
+class ScopedTimer
+{
+public:
+  // An inactive timer counts nothing, for scopes that are only timed on some paths.
+  explicit ScopedTimer(Stage stage, bool active = true) : m_stage(stage)
+  {
+    if (active && g_enabled.load(std::memory_order_relaxed))
+    {
+      m_running = true;
+      m_start = std::chrono::steady_clock::now();
+    }
+  }
+  ~ScopedTimer()
+  {
+    if (m_running)
+      Stop();
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+  void Stop();
+
+  Stage m_stage;
+  bool m_running = false;
+  std::chrono::steady_clock::time_point m_start;
+};
+}  // namespace PipelineTimings
@@ -69,6 +69,7 @@
 #include "VideoCommon/NetPlayGolfUI.h"
 #include "VideoCommon/OnScreenDisplay.h"
 #include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/PipelineTimings.h"
 #include "VideoCommon/PixelEngine.h"
 #include "VideoCommon/PixelShaderManager.h"
 #include "VideoCommon/PostProcessing.h"
@@ -1290,6 +1291,7 @@ void Renderer::Swap(u32 xfb_addr, u32 fb_width, u32 fb_stride, u32 fb_height, u6
         // Begin new frame
         m_frame_count++;
         g_stats.ResetFrame();
+        PipelineTimings::EndFrame();
       }
 
       g_shader_cache->RetrieveAsyncShaders();
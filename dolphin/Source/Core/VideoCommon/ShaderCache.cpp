@@ -5,6 +5,7 @@
 #include "VideoCommon/ShaderCache.h"
 
 #include "Common/Assert.h"
+#include "Common/FileSearch.h"
 #include "Common/FileUtil.h"
 #include "Common/MsgHandler.h"
 #include "Core/ConfigManager.h"
@@ -24,6 +25,9 @@ std::unique_ptr<VideoCommon::ShaderCache> g_shader_cache;
 
 namespace VideoCommon
 {
+constexpr u32 UID_CACHE_FILE_MAGIC = 0x44495550;  // PUID
+constexpr size_t UID_CACHE_HEADER_SIZE = sizeof(u32) + sizeof(u32);
+
 ShaderCache::ShaderCache() : m_api_type{APIType::Nothing}
 {
 }
@@ -54,6 +58,8 @@ void ShaderCache::InitializeShaderCache()
   {
     LoadCaches();
     LoadPipelineUIDCache();
+    if (g_ActiveConfig.bPrecompileLibraryShaders)
+      LoadLibraryPipelineUIDs();
   }
 
   // Queue ubershader precompiling if required.
@@ -62,7 +68,7 @@ void ShaderCache::InitializeShaderCache()
 
   // Compile all known UIDs.
   CompileMissingPipelines();
-  if (g_ActiveConfig.bWaitForShadersBeforeStarting)
+  if (g_ActiveConfig.bWaitForShadersBeforeStarting || g_ActiveConfig.bPrecompileLibraryShaders)
     WaitForAsyncCompiler();
 
   // Switch to the runtime shader compiler thread configuration.
@@ -88,7 +94,7 @@ void ShaderCache::Reload()
   // UIDs are still be in the map. Therefore, when these are rebuilt, the shaders will also
   // be recompiled.
   CompileMissingPipelines();
-  if (g_ActiveConfig.bWaitForShadersBeforeStarting)
+  if (g_ActiveConfig.bWaitForShadersBeforeStarting || g_ActiveConfig.bPrecompileLibraryShaders)
     WaitForAsyncCompiler();
   m_async_shader_compiler->ResizeWorkerThreads(g_ActiveConfig.GetShaderCompilerThreads());
 }
@@ -106,14 +112,22 @@ void ShaderCache::Shutdown()
     m_async_shader_compiler->StopWorkerThreads();
 
   ClosePipelineUIDCache();
+
+  NOTICE_LOG(VIDEO, "Pipeline stutters this session: %u (%u of %u library pipelines used)",
+             m_session_stats.stutters, m_session_stats.library_hits,
+             m_session_stats.library_pipelines);
 }
 
 const AbstractPipeline* ShaderCache::GetPipelineForUid(const GXPipelineUid& uid)
 {
   auto it = m_gx_pipeline_cache.find(uid);
+  if (it != m_gx_pipeline_cache.end() && it->second.library)
+    OnLibraryPipelineUsed(uid, it->second);
   if (it != m_gx_pipeline_cache.end() && !it->second.second)
     return it->second.first.get();
 
+  // The GPU thread waits for the compile.
+  m_session_stats.stutters++;
   const bool exists_in_cache = it != m_gx_pipeline_cache.end();
   std::unique_ptr<AbstractPipeline> pipeline;
   std::optional<AbstractPipelineConfig> pipeline_config = GetGXPipelineConfig(uid);
@@ -129,6 +143,9 @@ std::optional<const AbstractPipeline*> ShaderCache::GetPipelineForUidAsync(const
   auto it = m_gx_pipeline_cache.find(uid);
   if (it != m_gx_pipeline_cache.end())
   {
+    if (it->second.library)
+      OnLibraryPipelineUsed(uid, it->second);
+
     // .second is the pending flag, i.e. compiling in the background.
     if (!it->second.second)
       return it->second.first.get();
@@ -136,6 +153,8 @@ std::optional<const AbstractPipeline*> ShaderCache::GetPipelineForUidAsync(const
       return {};
   }
 
+  // Drawn with the ubershaders or skipped until the compile is done.
+  m_session_stats.stutters++;
   AppendGXPipelineUID(uid);
   QueuePipelineCompile(uid, COMPILE_PRIORITY_ONDEMAND_PIPELINE);
   return {};
@@ -405,7 +424,11 @@ void ShaderCache::CompileMissingPipelines()
   // Queue all uids with a null pipeline for compilation.
   for (auto& it : m_gx_pipeline_cache)
   {
-    if (!it.second.first)
+    if (it.second.first)
+      continue;
+    if (it.second.library)
+      QueuePipelineCompile(it.first, COMPILE_PRIORITY_LIBRARY_PIPELINE);
+    else
       QueuePipelineCompile(it.first, COMPILE_PRIORITY_SHADERCACHE_PIPELINE);
   }
   for (auto& it : m_gx_uber_pipeline_cache)
@@ -723,8 +746,6 @@ ShaderCache::InsertGXUberPipeline(const GXUberPipelineUid& config,
 
 void ShaderCache::LoadPipelineUIDCache()
 {
-  constexpr u32 CACHE_FILE_MAGIC = 0x44495550;  // PUID
-  constexpr size_t CACHE_HEADER_SIZE = sizeof(u32) + sizeof(u32);
   std::string filename =
       File::GetUserPath(D_CACHE_IDX) + SConfig::GetInstance().GetGameID() + ".uidcache";
   if (m_gx_pipeline_uid_cache_file.Open(filename, "rb+"))
@@ -735,15 +756,16 @@ void ShaderCache::LoadPipelineUIDCache()
     bool uid_file_valid = false;
     if (m_gx_pipeline_uid_cache_file.ReadBytes(&existing_magic, sizeof(existing_magic)) &&
         m_gx_pipeline_uid_cache_file.ReadBytes(&existing_version, sizeof(existing_version)) &&
-        existing_magic == CACHE_FILE_MAGIC && existing_version == GX_PIPELINE_UID_VERSION)
+        existing_magic == UID_CACHE_FILE_MAGIC && existing_version == GX_PIPELINE_UID_VERSION)
     {
       // Ensure the expected size matches the actual size of the file. If it doesn't, it means
       // the cache file may be corrupted, and we should not proceed with loading potentially
       // garbage or invalid UIDs.
       const u64 file_size = m_gx_pipeline_uid_cache_file.GetSize();
       const size_t uid_count =
-          static_cast<size_t>(file_size - CACHE_HEADER_SIZE) / sizeof(SerializedGXPipelineUid);
-      const size_t expected_size = uid_count * sizeof(SerializedGXPipelineUid) + CACHE_HEADER_SIZE;
+          static_cast<size_t>(file_size - UID_CACHE_HEADER_SIZE) / sizeof(SerializedGXPipelineUid);
+      const size_t expected_size =
+          uid_count * sizeof(SerializedGXPipelineUid) + UID_CACHE_HEADER_SIZE;
       uid_file_valid = file_size == expected_size;
       if (uid_file_valid)
       {
@@ -779,7 +801,8 @@ void ShaderCache::LoadPipelineUIDCache()
     if (m_gx_pipeline_uid_cache_file.Open(filename, "wb"))
     {
       // Write the version identifier.
-      m_gx_pipeline_uid_cache_file.WriteBytes(&CACHE_FILE_MAGIC, sizeof(GX_PIPELINE_UID_VERSION));
+      m_gx_pipeline_uid_cache_file.WriteBytes(&UID_CACHE_FILE_MAGIC,
+                                              sizeof(GX_PIPELINE_UID_VERSION));
       m_gx_pipeline_uid_cache_file.WriteBytes(&GX_PIPELINE_UID_VERSION,
                                               sizeof(GX_PIPELINE_UID_VERSION));
 
@@ -795,6 +818,64 @@ void ShaderCache::LoadPipelineUIDCache()
            static_cast<unsigned>(m_gx_pipeline_cache.size()), filename.c_str());
 }
 
+void ShaderCache::LoadLibraryPipelineUIDs()
+{
+  // Every game played leaves its UID cache in the cache directory. Most games share plenty of
+  // simple materials, so the pipelines of the other games are compiled too, after this game's
+  // own. They are only written to this game's UID cache once the game uses them.
+  const std::string own_filename =
+      File::GetUserPath(D_CACHE_IDX) + SConfig::GetInstance().GetGameID() + ".uidcache";
+  const std::vector<std::string> files =
+      Common::DoFileSearch({File::GetUserPath(D_CACHE_IDX)}, {".uidcache"});
+
+  size_t games = 0;
+  for (const std::string& filename : files)
+  {
+    if (filename == own_filename)
+      continue;
+
+    File::IOFile file(filename, "rb");
+    u32 magic, version;
+    if (!file.ReadBytes(&magic, sizeof(magic)) || !file.ReadBytes(&version, sizeof(version)) ||
+        magic != UID_CACHE_FILE_MAGIC || version != GX_PIPELINE_UID_VERSION)
+    {
+      continue;
+    }
+
+    // A partly written entry at the end (e.g. Dolphin crashed) is ignored.
+    const size_t uid_count = static_cast<size_t>(file.GetSize() - UID_CACHE_HEADER_SIZE) /
+                             sizeof(SerializedGXPipelineUid);
+    std::vector<SerializedGXPipelineUid> serialized_uids(uid_count);
+    if (!file.ReadArray(serialized_uids.data(), uid_count))
+      continue;
+
+    for (const SerializedGXPipelineUid& serialized_uid : serialized_uids)
+    {
+      GXPipelineUid uid;
+      UnserializePipelineUid(serialized_uid, uid);
+      if (m_gx_pipeline_cache.find(uid) != m_gx_pipeline_cache.end())
+        continue;
+
+      // Flag it as empty with a null pipeline object, for later compilation.
+      auto& entry = m_gx_pipeline_cache[uid];
+      entry.second = false;
+      entry.library = true;
+      m_session_stats.library_pipelines++;
+    }
+    games++;
+  }
+
+  INFO_LOG(VIDEO, "Read %u pipeline UIDs of %zu other games", m_session_stats.library_pipelines,
+           games);
+}
+
+void ShaderCache::OnLibraryPipelineUsed(const GXPipelineUid& config, GXPipelineCacheEntry& entry)
+{
+  entry.library = false;
+  m_session_stats.library_hits++;
+  AppendGXPipelineUID(config);
+}
+
 void ShaderCache::ClosePipelineUIDCache()
 {
   // This is left as a method in case we need to append extra data to the file in the future.
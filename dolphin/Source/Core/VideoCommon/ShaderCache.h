@@ -70,6 +70,16 @@ public:
   // The optional will be empty if this pipeline is now background compiling.
   std::optional<const AbstractPipeline*> GetPipelineForUidAsync(const GXPipelineUid& uid);
 
+  struct SessionStats
+  {
+    // Pipelines the game had to wait for (synchronous mode), or had to draw without.
+    u32 stutters = 0;
+    // Pipelines queued from the UID caches of other games, and how many the game used.
+    u32 library_pipelines = 0;
+    u32 library_hits = 0;
+  };
+  const SessionStats& GetSessionStats() const { return m_session_stats; }
+
   // Shared shaders
   const AbstractShader* GetScreenQuadVertexShader() const
   {
@@ -114,6 +124,14 @@ public:
   const AbstractShader* GetTextureDecodingShader(TextureFormat format, TLUTFormat palette_format);
 
 private:
+  // Value of m_gx_pipeline_cache - .first - pipeline, .second - pending
+  // .library - the UID comes from the UID cache of another game and was not used by this one yet
+  // (see LoadLibraryPipelineUIDs).
+  struct GXPipelineCacheEntry : std::pair<std::unique_ptr<AbstractPipeline>, bool>
+  {
+    bool library = false;
+  };
+
   static constexpr size_t NUM_PALETTE_CONVERSION_SHADERS = 3;
 
   void WaitForAsyncCompiler();
@@ -121,6 +139,7 @@ private:
   void ClearCaches();
   void LoadPipelineUIDCache();
   void ClosePipelineUIDCache();
+  void LoadLibraryPipelineUIDs();
   void CompileMissingPipelines();
   void QueueUberShaderPipelines();
   bool CompileSharedPipelines();
@@ -160,6 +179,7 @@ private:
                                                std::unique_ptr<AbstractPipeline> pipeline);
   void AddSerializedGXPipelineUID(const SerializedGXPipelineUid& uid);
   void AppendGXPipelineUID(const GXPipelineUid& config);
+  void OnLibraryPipelineUsed(const GXPipelineUid& config, GXPipelineCacheEntry& entry);
 
   // ASync Compiler Methods
   void QueueVertexShaderCompile(const VertexShaderUid& uid, u32 priority);
@@ -183,12 +203,14 @@ private:
   // Priorities for compiling. The lower the value, the sooner the pipeline is compiled.
   // The shader cache is compiled last, as it is the least likely to be required. On demand
   // shaders are always compiled before pending ubershaders, as we want to use the ubershader
-  // for as few frames as possible, otherwise we risk framerate drops.
+  // for as few frames as possible, otherwise we risk framerate drops. Pipelines of other
+  // games are only a guess, they come after this game's own.
   enum : u32
   {
     COMPILE_PRIORITY_ONDEMAND_PIPELINE = 100,
     COMPILE_PRIORITY_UBERSHADER_PIPELINE = 200,
-    COMPILE_PRIORITY_SHADERCACHE_PIPELINE = 300
+    COMPILE_PRIORITY_SHADERCACHE_PIPELINE = 300,
+    COMPILE_PRIORITY_LIBRARY_PIPELINE = 400
   };
 
   // Configuration bits.
@@ -224,10 +246,11 @@ private:
   ShaderModuleCache<UberShader::PixelShaderUid> m_uber_ps_cache;
 
   // GX Pipeline Caches - .first - pipeline, .second - pending
-  std::map<GXPipelineUid, std::pair<std::unique_ptr<AbstractPipeline>, bool>> m_gx_pipeline_cache;
+  std::map<GXPipelineUid, GXPipelineCacheEntry> m_gx_pipeline_cache;
   std::map<GXUberPipelineUid, std::pair<std::unique_ptr<AbstractPipeline>, bool>>
       m_gx_uber_pipeline_cache;
   File::IOFile m_gx_pipeline_uid_cache_file;
+  SessionStats m_session_stats;
   LinearDiskCache<SerializedGXPipelineUid, u8> m_gx_pipeline_disk_cache;
   LinearDiskCache<SerializedGXUberPipelineUid, u8> m_gx_uber_pipeline_disk_cache;
 
@@ -39,6 +39,7 @@
 #include "VideoCommon/FramebufferManager.h"
 #include "VideoCommon/HiresTextures.h"
 #include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/PipelineTimings.h"
 #include "VideoCommon/PixelShaderManager.h"
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/SamplerCommon.h"
@@ -1574,16 +1575,19 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
 
       CheckTempSize(total_texture_size);
       dst_buffer = temp;
-      if (!(texformat == TextureFormat::RGBA8 && from_tmem))
       {
-        TexDecoder_Decode(dst_buffer, src_data, expandedWidth, expandedHeight, texformat, tlut,
-                          tlutfmt);
-      }
-      else
-      {
-        u8* src_data_gb = &texMem[tmem_address_odd];
-        TexDecoder_DecodeRGBA8FromTmem(dst_buffer, src_data, src_data_gb, expandedWidth,
-                                       expandedHeight);
+        PipelineTimings::ScopedTimer timer(PipelineTimings::Stage::TextureDecoding);
+        if (!(texformat == TextureFormat::RGBA8 && from_tmem))
+        {
+          TexDecoder_Decode(dst_buffer, src_data, expandedWidth, expandedHeight, texformat, tlut,
+                            tlutfmt);
+        }
+        else
+        {
+          u8* src_data_gb = &texMem[tmem_address_odd];
+          TexDecoder_DecodeRGBA8FromTmem(dst_buffer, src_data, src_data_gb, expandedWidth,
+                                         expandedHeight);
+        }
       }
 
       entry->texture->Load(0, width, height, expandedWidth, dst_buffer, decoded_texture_size);
@@ -1655,8 +1659,11 @@ TextureCacheBase::GetTexture(u32 address, u32 width, u32 height, const TextureFo
       {
         // No need to call CheckTempSize here, as the whole buffer is preallocated at the beginning
         const u32 decoded_mip_size = expanded_mip_width * sizeof(u32) * expanded_mip_height;
-        TexDecoder_Decode(dst_buffer, mip_src_data, expanded_mip_width, expanded_mip_height,
-                          texformat, tlut, tlutfmt);
+        {
+          PipelineTimings::ScopedTimer timer(PipelineTimings::Stage::TextureDecoding);
+          TexDecoder_Decode(dst_buffer, mip_src_data, expanded_mip_width, expanded_mip_height,
+                            texformat, tlut, tlutfmt);
+        }
         entry->texture->Load(level, mip_width, mip_height, expanded_mip_width, dst_buffer,
                              decoded_mip_size);
 
@@ -1747,7 +1754,10 @@ TextureCacheBase::GetXFBTexture(u32 address, u32 width, u32 height, u32 stride,
   {
     const u32 decoded_size = width * height * sizeof(u32);
     CheckTempSize(decoded_size);
-    TexDecoder_DecodeXFB(temp, src_data, width, height, stride);
+    {
+      PipelineTimings::ScopedTimer timer(PipelineTimings::Stage::TextureDecoding);
+      TexDecoder_DecodeXFB(temp, src_data, width, height, stride);
+    }
     entry->texture->Load(0, width, height, width, temp, decoded_size);
   }
 
@@ -117,6 +117,7 @@ void VideoConfig::Refresh()
   iCommandBufferExecuteInterval = Config::Get(Config::GFX_COMMAND_BUFFER_EXECUTE_INTERVAL);
   bShaderCache = Config::Get(Config::GFX_SHADER_CACHE);
   bWaitForShadersBeforeStarting = Config::Get(Config::GFX_WAIT_FOR_SHADERS_BEFORE_STARTING);
+  bPrecompileLibraryShaders = Config::Get(Config::GFX_PRECOMPILE_LIBRARY_SHADERS);
   iShaderCompilationMode = Config::Get(Config::GFX_SHADER_COMPILATION_MODE);
   #warning "JC: modified. Asynchronous shader compling disabled. This could introduce stuttering"
   iShaderCompilerThreads = 0;//Config::Get(Config::GFX_SHADER_COMPILER_THREADS);
@@ -215,12 +216,17 @@ u32 VideoConfig::GetShaderCompilerThreads() const
 u32 VideoConfig::GetShaderPrecompilerThreads() const
 {
   // When using background compilation, always keep the same thread count.
-  if (!bWaitForShadersBeforeStarting)
+  if (!bWaitForShadersBeforeStarting && !bPrecompileLibraryShaders)
     return GetShaderCompilerThreads();
 
   if (!backend_info.bSupportsBackgroundCompiling)
     return 0;
 
+  // The library precompile is too large for the GPU thread alone, it uses the idle cores
+  // even with the precompiler threads switched off.
+  if (bPrecompileLibraryShaders && iShaderPrecompilerThreads <= 0)
+    return GetNumAutoShaderCompilerThreads();
+
   if (iShaderPrecompilerThreads >= 0)
     return static_cast<u32>(iShaderPrecompilerThreads);
   else
@@ -178,6 +178,9 @@ struct VideoConfig final
 
   // Shader compilation settings.
   bool bWaitForShadersBeforeStarting;
+  // Also compiles the pipelines recorded by the other games (their UID caches), before the
+  // game starts.
+  bool bPrecompileLibraryShaders;
   ShaderCompilationMode iShaderCompilationMode;
 
   // Number of shader compiler threads.
@@ -0,0 +1,64 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <string>
+#include <sys/types.h>
+
+#ifndef CLASSIFIER_H
+#define CLASSIFIER_H
+
+    // The classifier tells which emulator runs a game file by looking
+    // at the magic numbers and headers in its first sectors. It only
+    // reads the file and is safe to call from the crawler threads.
+
+    enum emulator_target
+    {
+        unknown,
+        mednafen,
+        dolphin,
+        mupen64plus,
+        ppsspp,
+        pcsx2
+    };
+
+    typedef enum
+    {
+        ROM_UNKNOWN,
+        ROM_GAMECUBE,
+        ROM_WII,
+        ROM_N64,
+        ROM_NES,
+        ROM_SNES,
+        ROM_GENESIS,
+        ROM_SATURN,
+        ROM_GAMEBOY,
+        ROM_GBA,
+        ROM_PSP,
+        ROM_PS2,
+        ROM_ISO9660     // other CD/DVD image
+    } rom_type;
+
+    rom_type classifyRom(const std::string& filename, off_t* size);
+    emulator_target getRomTarget(rom_type type, const std::string& filename, off_t size);
+    int classifyLibraryFile(const std::string& filename);
+
+#endif
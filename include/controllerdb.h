@@ -0,0 +1,49 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <string>
+
+#ifndef CONTROLLERDB_H
+#define CONTROLLERDB_H
+
+    // The controller databases (internaldb.txt, gamecontrollerdb.txt)
+    // are kept in memory. A file is read again only if its size or mtime
+    // changed. For every GUID prefix length that is asked for, an index
+    // of the first line with that prefix is built, so a lookup does not
+    // scan the file.
+    //
+    // The internal database is a journal: new mappings are appended, for
+    // a GUID the last line wins (as in SDL_GameControllerAddMappingsFromFile()).
+    // compactControllerDB() drops the lines that were replaced later on.
+
+    #define CONTROLLER_DB_INTERNAL  0
+    #define CONTROLLER_DB_PUBLIC    1
+    #define CONTROLLER_DB_COUNT     2
+
+    #define CONTROLLER_GUID_LENGTH  32
+
+    void setControllerDB(int db, const std::string& filename);
+    bool findGuidInDB(int db, const std::string& guid, int length, std::string* line);
+    bool addControllerMapping(int db, const std::string& entry);
+    bool compactControllerDB(int db);
+
+#endif
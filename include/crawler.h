@@ -0,0 +1,63 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "library.h"
+
+#ifndef CRAWLER_H
+#define CRAWLER_H
+
+    // The crawler reads a directory tree with a pool of worker threads.
+    // Every worker owns a queue of folders, idle workers steal from the
+    // others. For each folder read, a result is handed over to the main
+    // thread through a lock-free queue (popCrawlerResult()), so the main
+    // thread can keep the splash screen and the event loop running.
+    // Every file is stat'ed once, files with the size of a bios are
+    // collected in the same pass as the game candidates.
+    // readLibraryFolder() reads a single folder on the calling thread,
+    // without the worker pool (e.g. for the listing job of the game browser).
+
+    #define CRAWL_GAMES         1   // game candidates, cue references
+    #define CRAWL_BIOS          2   // files with the size of a bios
+    #define CRAWL_RECURSIVE     4   // descend into sub folders
+    #define CRAWL_CLASSIFY      8   // emulator target of new game candidates (classifier.h)
+
+    #define CRAWLER_MAX_THREADS 16
+
+    typedef struct CrawlerResult {
+        std::string directory;                  // with trailing slash
+        T_LibraryDir entry;                     // bios files are always collected
+        bool fromLibrary;                       // entry is unchanged in the library index
+        std::atomic<struct CrawlerResult*> next;
+    } T_CrawlerResult;
+
+    bool startCrawler(const std::string& directory, int mode);
+    T_CrawlerResult* popCrawlerResult(void);
+    bool crawlerBusy(void);
+    void stopCrawler(void);
+    void cancelCrawler(void);
+    bool readLibraryFolder(const std::string& directory, int mode, const std::atomic<bool>* cancel,
+                           T_LibraryDir* entry, bool* fromLibrary);
+
+#endif
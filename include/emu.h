@@ -23,6 +23,8 @@
 #include <iostream>
 #include <stdio.h>
 #include <string>
+#include <list>
+#include <sys/types.h>
 
 using namespace std;
 
@@ -42,5 +44,8 @@ using namespace std;
     void printSupportedEmus(void);
     void buildGameList(void);
     bool isDirectory(const char *path);
+    bool isGameCandidate(const string& str_with_path, std::list<string> *cueReferences);
+    bool isBiosSize(off_t size);
+    void invalidateBiosCandidates(void);
     
 #endif
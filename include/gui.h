@@ -96,6 +96,9 @@ using namespace std;
 
     extern bool splashScreenRunning;
     
+    // renderScreen() is only called when this is set
+    extern bool gRedraw;
+    
     extern TTF_Font* gFont;
     
     extern int WINDOW_WIDTH;
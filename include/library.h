@@ -0,0 +1,79 @@
+/* Marley Copyright (c) 2021 Marley Development Team 
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <string>
+#include <list>
+#include <vector>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+    // The library index (~/.marley/library.db) remembers the result
+    // of findAllFiles() for every directory it has read. A directory
+    // is only read again if its mtime changed, i.e. if files were
+    // added, removed or renamed in it. Besides the game candidates, it
+    // keeps the files with the size of a bios, so the bios search of the
+    // game folder does not need to read unchanged folders either.
+    // For games checked by the validator (validator.h), it also keeps
+    // what is needed to launch them without looking at the disk again.
+
+    #define LIBRARY_TARGET_UNKNOWN  0
+
+    #define LIBRARY_STATUS_NONE     0   // not validated yet
+    #define LIBRARY_STATUS_READY    1   // target and launch file are valid
+    #define LIBRARY_STATUS_BROKEN   2   // cue file with a missing FILE reference
+    #define LIBRARY_STATUS_NO_CUE   3   // Saturn bin file without a cue sheet, written at launch
+
+    typedef struct LibraryFile {
+        std::string name;       // file name without path
+        off_t size;
+        ino_t inode;
+        int target;             // emulator_target, LIBRARY_TARGET_UNKNOWN if not classified yet
+        int status;             // LIBRARY_STATUS_*
+        std::string launch;     // file handed to the emulator without path, empty for the file itself
+    } T_LibraryFile;
+
+    typedef struct LibraryDir {
+        time_t mtime_sec;
+        long mtime_nsec;
+        std::vector<std::string> subdirs;       // without path, no trailing slash
+        std::vector<T_LibraryFile> files;       // game candidates
+        std::vector<std::string> cueReferences; // FILE entries of valid cue files
+        std::vector<T_LibraryFile> biosFiles;   // files with the size of a bios (isBiosSize())
+    } T_LibraryDir;
+
+    bool loadLibraryIndex(void);
+    bool saveLibraryIndex(void);
+    bool getLibraryDir(const std::string& directory, const struct stat* dirStat, T_LibraryDir* entry);
+    void setLibraryDir(const std::string& directory, const T_LibraryDir& entry);
+    int  getLibraryTarget(const std::string& filename);
+    void setLibraryTarget(const std::string& filename, int target);
+    bool getLibraryFile(const std::string& filename, T_LibraryFile* file);
+    bool setLibraryFile(const std::string& filename, const T_LibraryFile& file);
+    void invalidateLibraryFile(const std::string& filename);
+    bool getLibraryLaunch(const std::string& filename, int* target, std::string* launchFile, bool* needsCueSheet);
+    void stripList(std::list<std::string> *tmpList, std::list<std::string> *toBeRemoved);
+    void finalizeList(std::list<std::string> *tmpList);
+
+#endif
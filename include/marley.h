@@ -64,12 +64,9 @@ using namespace std;
         int screen_manager_main(int argc, char* argv[]);
     #endif
     
-    void restoreSDL(void);
     bool setPathToGames(string filename);
     bool setPathToFirmware(string str);
     bool addSettingToConfigFile(string setting);
-    bool addControllerToInternalDB(string entry);
-    void removeDuplicatesInDB(void);
     
     extern double angle0L;
     extern double angle1L;
@@ -0,0 +1,43 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <string>
+
+#ifndef MDF2ISO_H
+#define MDF2ISO_H
+
+    // mdf2iso reads the image in blocks of whole sectors on a thread of
+    // its own and strips them in memory, the calling thread writes them.
+    // startMdf2Iso() runs a conversion to cue/bin on a worker thread,
+    // the progress can be polled while it is running.
+    // Raw MDF images (isRawMdf()) are not converted, mednafen reads
+    // them in place.
+
+    int mdf2iso_main(int argc, char **argv);
+    bool isRawMdf(const std::string& filename);
+
+    bool startMdf2Iso(const std::string& filename, const std::string& destfilename_no_path);
+    bool getMdf2IsoProgress(int* percent);
+    void cancelMdf2Iso(void);
+    int finishMdf2Iso(void);
+
+#endif
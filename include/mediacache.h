@@ -0,0 +1,43 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <SDL.h>
+
+#ifndef MEDIACACHE_H
+#define MEDIACACHE_H
+
+    // The bitmaps of the launcher (built-in resources) are decoded once
+    // and packed into atlas pages (~/.marley/media.atlas), ARGB8888 with
+    // TextureAtlas metadata per page. On the next start the file is mapped
+    // and the textures are uploaded straight from the pages, no bitmap is
+    // decoded. The cache is rebuilt when the marley binary (the source of
+    // the resources) changes size or mtime.
+
+    typedef struct MediaFile {
+        int texture;            // TEX_*
+        const char* resource;   // path in the built-in resources
+    } T_MediaFile;
+
+    bool loadMediaCache(SDL_Renderer* renderer, const T_MediaFile* media, int count, SDL_Texture** textures);
+    bool saveMediaCache(const T_MediaFile* media, int count, SDL_Surface** surfaces);
+
+#endif
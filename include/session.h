@@ -0,0 +1,40 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+    // An emulator core runs in-process and draws to the launcher window.
+    // The cores create their own GL context on gWindow and delete it on
+    // exit, so the launcher renderer and its textures stay resident during
+    // a session and nothing is reloaded afterwards. PCSX2 attaches to the
+    // X11 window directly, it gets a window of its own for the session
+    // (ownWindow), the launcher window is hidden meanwhile.
+    // The screen_manager UI (no gRenderer) launches games from within its
+    // main loop and keeps its GL context on the launcher window, every core
+    // gets a window of its own then.
+
+    bool beginEmulatorSession(bool ownWindow);
+    void endEmulatorSession(void);
+    double getSessionRestoreTime(void);
+
+#endif
@@ -20,6 +20,7 @@
    TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
    SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
+#include <string>
 #include <vector>
 
 #ifndef STATEMACHINE_H
@@ -81,6 +82,17 @@
     void startControllerConf(int controllerNum);
     void setControllerConfText(std::string text, std::string text2 = "");
 
+    // Saturn mdf images mednafen cannot read are converted to cue/bin on a
+    // thread of its own (mdf2iso.h) before launch_emulator() is called, the
+    // UI keeps running. startGameConversion() returns false if there is
+    // nothing to convert. pollGameConversion() returns false once the
+    // conversion is done, ok is only set if the game can be launched.
+    bool startGameConversion(const std::string& filename);
+    bool pollGameConversion(int* percent, bool* ok);
+    void cancelGameConversion(void);
+    void pollLaunchConversion(void);
+    extern int gConversionPercent;  // -1 if no conversion is running in the SDL launcher
+
      // statemachine
     extern int gState;
 
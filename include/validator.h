@@ -0,0 +1,44 @@
+/* Marley Copyright (c) 2021 Marley Development Team 
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <string>
+#include <vector>
+
+#ifndef VALIDATOR_H
+#define VALIDATOR_H
+
+    // The validator prepares the games of the list for launching on a
+    // thread of its own while the user browses. For every game it looks
+    // up the emulator target, checks the FILE references of cue files
+    // and notes the cue sheets that Saturn bin files are missing. It
+    // does not write into the game folders, the launcher writes a missing
+    // cue sheet when the game is started. The results go to the library
+    // index (library.h), getLibraryLaunch() hands them to the launcher
+    // without any file access. Games that have not been validated yet
+    // are prepared when they are launched. Games validated before and
+    // unchanged since are only stat'ed.
+
+    void startValidator(const std::vector<std::string>& games);
+    void stopValidator(void);
+    bool validatorBusy(void);
+
+#endif
@@ -0,0 +1,42 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <string>
+
+#ifndef WATCHER_H
+#define WATCHER_H
+
+    // The library watcher keeps gGame up to date while marley is
+    // running. Every game folder is watched with inotify; a folder
+    // that reports a change is read again (non-recursive) and only
+    // its entries in gGame are replaced. New sub folders are searched
+    // and watched, removed ones are dropped from gGame.
+    // The folders are read on the crawler threads (crawler.h), the UI
+    // thread only swaps the finished result into gGame when it polls.
+
+    bool watchLibraryFolder(const std::string& directory);
+    void stopLibraryWatcher(void);
+    bool pollLibraryWatcher(void);
+    void cancelLibraryRescan(void);
+    bool libraryFolderChanged(const std::string& directory, int* generation);
+
+#endif
@@ -54,7 +54,8 @@ enum
 {
  CDRF_SUBM_NONE = 0,
  CDRF_SUBM_RW = 1,
- CDRF_SUBM_RW_RAW = 2
+ CDRF_SUBM_RW_RAW = 2,
+ CDRF_SUBM_SKIP = 3	// 96 bytes per sector in the file, not used(P and Q are synthesized)
 };
 
 // Disk-image(rip) track/sector formats
@@ -935,6 +936,62 @@ void CDAccess_Image::ImageOpen(VirtualFS* vfs, const std::string& path, bool ima
  GenerateTOC();
 }
 
+//
+// Data track of an Alcohol 120% MDF image(without the MDS file), read in place: raw 2352-byte
+// sectors, each followed by 96 bytes of subchannel data unless the second sector starts right
+// after the first one. The subchannel data is skipped, P and Q are synthesized as for CUE+BIN.
+//
+void CDAccess_Image::MDFOpen(VirtualFS* vfs, const std::string& path, bool image_memcache)
+{
+ static const uint8 sync_header[12] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+ CDRFILE_TRACK_INFO* track;
+ uint8 buf[2352 + 12];
+
+ MDFN_printf(_("MDF image detected.\n"));
+
+ disc_type = DISC_TYPE_CDDA_OR_M1;
+ FirstTrack = LastTrack = 1;
+ NumTracks = 1;
+ track = &Tracks[FirstTrack];
+
+ track->FirstFileInstance = true;
+ if(image_memcache)
+  track->fp = new MemoryStream(vfs->open(path, VirtualFS::MODE_READ));
+ else
+ {
+  track->fp = vfs->open(path, VirtualFS::MODE_READ);
+  track->fp->require_fast_seekable();
+ }
+
+ if(track->fp->read(buf, sizeof(buf), false) != sizeof(buf) || memcmp(buf, sync_header, 12))
+  throw MDFN_Error(0, _("Unsupported MDF image, only raw data tracks can be read."));
+
+ track->SubchannelMode = memcmp(buf + 2352, sync_header, 12) ? CDRF_SUBM_SKIP : CDRF_SUBM_NONE;
+
+ if(buf[12 + 3] == 0x02)
+ {
+  track->DIFormat = DI_FORMAT_MODE2_RAW;
+  disc_type = DISC_TYPE_CD_XA;
+ }
+ else
+  track->DIFormat = DI_FORMAT_MODE1_RAW;
+
+ track->subq_control = SUBQ_CTRLF_DATA;
+ track->pregap = 150;
+ track->LBA = 0;
+ track->FileOffset = 0;
+ track->sectors = GetSectorCount(track);
+ total_sectors = track->sectors;
+
+ //
+ // Indexes as adjusted for MakeSubPQ() in ImageOpen(), index 1 only.
+ //
+ for(int32 i = 0; i < 100; i++)
+  track->index[i] = (i == 1) ? track->LBA : INT32_MAX;
+
+ GenerateTOC();
+}
+
 void CDAccess_Image::Cleanup(void)
 {
  for(int32 track = 0; track < 100; track++)
@@ -964,7 +1021,10 @@ CDAccess_Image::CDAccess_Image(VirtualFS* vfs, const std::string& path, bool ima
 
  try
  {
-  ImageOpen(vfs, path, image_memcache);
+  if(path.size() >= 4 && !MDFN_strazicmp(path.c_str() + path.size() - 4, ".mdf"))
+   MDFOpen(vfs, path, image_memcache);
+  else
+   ImageOpen(vfs, path, image_memcache);
  }
  catch(...)
  {
@@ -1134,7 +1194,7 @@ void CDAccess_Image::Read_Raw_Sector(uint8 *buf, int32 lba)
 
     }
 
-    if(ct->SubchannelMode)
+    if(ct->SubchannelMode == CDRF_SUBM_RW_RAW)
      ct->fp->read(buf + 2352, 96);
    }
   } // end if audible part of audio track read.
@@ -1163,7 +1223,7 @@ bool CDAccess_Image::Fast_Read_Raw_PW_TSRE(uint8* pwbuf, int32 lba) const noexce
  //
  // If TOC+BIN has embedded subchannel data, we can't fast-read(synthesize) it...
  //
- if(Tracks[track].SubchannelMode && lba >= (Tracks[track].LBA - Tracks[track].pregap_dv) && (lba < Tracks[track].LBA + Tracks[track].sectors))
+ if(Tracks[track].SubchannelMode == CDRF_SUBM_RW_RAW && lba >= (Tracks[track].LBA - Tracks[track].pregap_dv) && (lba < Tracks[track].LBA + Tracks[track].sectors))
   return(false);
 
  return(true);
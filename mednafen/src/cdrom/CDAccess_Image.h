@@ -90,6 +90,7 @@ class CDAccess_Image : public CDAccess
  std::string base_dir;
 
  void ImageOpen(VirtualFS* vfs, const std::string& path, bool image_memcache);
+ void MDFOpen(VirtualFS* vfs, const std::string& path, bool image_memcache);
  void LoadSBI(VirtualFS* vfs, const std::string& sbi_path);
  void GenerateTOC(void);
  void Cleanup(void);
@@ -5,6 +5,7 @@
 
 #include "Common/Log.h"
 #include "Common/MemoryUtil.h"
+#include "Common/Profiler/Profiler.h"
 
 #if 0 // def _DEBUG
 #define printf(...) printf(__VA_ARGS__)
@@ -529,6 +530,7 @@ void SCREEN_GLRenderManager::EndSubmitFrame(int frame) {
 			}
 		}
 		if (swapFunction_) {
+			PROFILE_THIS_SCOPE("SwapBuffers", PROFILE_SWAP);
 			swapFunction_();
 		}
 	} else {
@@ -542,26 +544,29 @@ void SCREEN_GLRenderManager::Run(int frame) {
 
 	FrameData &frameData = frameData_[frame];
 
-	auto &stepsOnThread = frameData_[frame].steps;
-	auto &initStepsOnThread = frameData_[frame].initSteps;
-	// queueRunner_.LogSteps(stepsOnThread);
-	queueRunner_.RunInitSteps(initStepsOnThread, skipGLCalls_);
-	initStepsOnThread.clear();
-
-	// Run this after RunInitSteps so any fresh GLRBuffers for the pushbuffers can get created.
-	if (!skipGLCalls_) {
-		for (auto iter : frameData.activePushBuffers) {
-			iter->Flush();
-			iter->UnmapDevice();
+	{
+		PROFILE_THIS_SCOPE("SCREEN_GLRenderManager::Run", PROFILE_SUBMIT);
+		auto &stepsOnThread = frameData_[frame].steps;
+		auto &initStepsOnThread = frameData_[frame].initSteps;
+		// queueRunner_.LogSteps(stepsOnThread);
+		queueRunner_.RunInitSteps(initStepsOnThread, skipGLCalls_);
+		initStepsOnThread.clear();
+
+		// Run this after RunInitSteps so any fresh GLRBuffers for the pushbuffers can get created.
+		if (!skipGLCalls_) {
+			for (auto iter : frameData.activePushBuffers) {
+				iter->Flush();
+				iter->UnmapDevice();
+			}
 		}
-	}
 
-	queueRunner_.RunSteps(stepsOnThread, skipGLCalls_);
-	stepsOnThread.clear();
+		queueRunner_.RunSteps(stepsOnThread, skipGLCalls_);
+		stepsOnThread.clear();
 
-	if (!skipGLCalls_) {
-		for (auto iter : frameData.activePushBuffers) {
-			iter->MapDevice(bufferStrategy_);
+		if (!skipGLCalls_) {
+			for (auto iter : frameData.activePushBuffers) {
+				iter->MapDevice(bufferStrategy_);
+			}
 		}
 	}
 
@@ -0,0 +1,191 @@
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "Common/Profiler/Profiler.h"
+
+// about half an hour of continuous rendering, later events are dropped
+#define PROFILE_TRACE_MAX_EVENTS (1024 * 1024)
+
+std::atomic<bool> SCREEN_g_profilerActive(false);
+
+struct TraceEvent {
+	const char *name;
+	SCREEN_ProfileCategory category;
+	int thread;
+	int64_t startUs;
+	int64_t durationUs;
+};
+
+static const char *categoryNames[PROFILE_CATEGORY_COUNT] = {
+	"events",
+	"update",
+	"layout",
+	"draw",
+	"submit",
+	"swap",
+};
+
+static const uint32_t categoryColors[PROFILE_CATEGORY_COUNT] = {
+	0xFF40C0FF,
+	0xFFFF8040,
+	0xFFFFFF40,
+	0xFF40FF40,
+	0xFF4040FF,
+	0xFF808080,
+};
+
+static std::mutex profilerMutex;
+static bool hudVisible = false;
+static bool tracing = false;
+static bool traceFull = false;
+static std::string traceFilename;
+static std::vector<TraceEvent> traceEvents;
+
+static float currentMs[PROFILE_CATEGORY_COUNT];
+static SCREEN_ProfileFrame history[SCREEN_PROFILE_HISTORY];
+static int historyNext = 0;
+static int historyCount = 0;
+static int threadCount = 0;
+
+// nested scopes of the same category are counted once
+static thread_local int scopeDepth[PROFILE_CATEGORY_COUNT];
+static thread_local int threadIndex = -1;
+
+static int64_t NowUs() {
+	static const auto start = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void UpdateActive() {
+	SCREEN_g_profilerActive = hudVisible || tracing;
+}
+
+SCREEN_ProfileScope::SCREEN_ProfileScope(const char *name, SCREEN_ProfileCategory category)
+	: name_(name), category_(category), startUs_(-1) {
+	if (!SCREEN_g_profilerActive)
+		return;
+	scopeDepth[category_]++;
+	startUs_ = NowUs();
+}
+
+SCREEN_ProfileScope::~SCREEN_ProfileScope() {
+	if (startUs_ < 0)
+		return;
+	int64_t endUs = NowUs();
+	bool outermost = --scopeDepth[category_] == 0;
+
+	std::lock_guard<std::mutex> guard(profilerMutex);
+	if (outermost)
+		currentMs[category_] += (endUs - startUs_) / 1000.0f;
+	if (!tracing)
+		return;
+	if (traceEvents.size() >= PROFILE_TRACE_MAX_EVENTS) {
+		if (!traceFull)
+			printf("Trace %s is full, later events are dropped\n", traceFilename.c_str());
+		traceFull = true;
+		return;
+	}
+	if (threadIndex < 0)
+		threadIndex = threadCount++;
+	traceEvents.push_back({ name_, category_, threadIndex, startUs_, endUs - startUs_ });
+}
+
+const char *SCREEN_ProfilerCategoryName(SCREEN_ProfileCategory category) {
+	return categoryNames[category];
+}
+
+uint32_t SCREEN_ProfilerCategoryColor(SCREEN_ProfileCategory category) {
+	return categoryColors[category];
+}
+
+void SCREEN_ProfilerEndFrame() {
+	if (!SCREEN_g_profilerActive)
+		return;
+
+	std::lock_guard<std::mutex> guard(profilerMutex);
+	SCREEN_ProfileFrame &frame = history[historyNext];
+	for (int i = 0; i < PROFILE_CATEGORY_COUNT; i++) {
+		frame.categoryMs[i] = currentMs[i];
+		currentMs[i] = 0.0f;
+	}
+
+	historyNext = (historyNext + 1) % SCREEN_PROFILE_HISTORY;
+	if (historyCount < SCREEN_PROFILE_HISTORY)
+		historyCount++;
+}
+
+int SCREEN_ProfilerGetFrames(SCREEN_ProfileFrame *frames, int max) {
+	std::lock_guard<std::mutex> guard(profilerMutex);
+	int count = historyCount < max ? historyCount : max;
+	int first = historyNext - count;
+	if (first < 0)
+		first += SCREEN_PROFILE_HISTORY;
+	for (int i = 0; i < count; i++)
+		frames[i] = history[(first + i) % SCREEN_PROFILE_HISTORY];
+	return count;
+}
+
+void SCREEN_ProfilerSetHUD(bool visible) {
+	std::lock_guard<std::mutex> guard(profilerMutex);
+	hudVisible = visible;
+	UpdateActive();
+}
+
+bool SCREEN_ProfilerHUDVisible() {
+	return hudVisible;
+}
+
+bool SCREEN_ProfilerStartTrace(const std::string &filename) {
+	std::lock_guard<std::mutex> guard(profilerMutex);
+	if (tracing) {
+		printf("A trace is already written to %s\n", traceFilename.c_str());
+		return false;
+	}
+	printf("Writing a trace to %s\n", filename.c_str());
+	traceFilename = filename;
+	traceEvents.clear();
+	traceEvents.reserve(64 * 1024);
+	traceFull = false;
+	tracing = true;
+	UpdateActive();
+	return true;
+}
+
+bool SCREEN_ProfilerStopTrace() {
+	std::vector<TraceEvent> events;
+	std::string filename;
+	{
+		std::lock_guard<std::mutex> guard(profilerMutex);
+		if (!tracing)
+			return true;
+		tracing = false;
+		UpdateActive();
+		events.swap(traceEvents);
+		filename = traceFilename;
+	}
+
+	FILE *file = fopen(filename.c_str(), "w");
+	if (!file) {
+		printf("Could not write trace %s\n", filename.c_str());
+		return false;
+	}
+	fprintf(file, "{\"traceEvents\":[\n");
+	for (size_t i = 0; i < events.size(); i++) {
+		const TraceEvent &event = events[i];
+		fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d}",
+			i ? ",\n" : "", event.name, categoryNames[event.category],
+			(long long)event.startUs, (long long)event.durationUs, event.thread);
+	}
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	bool ok = !ferror(file);
+	if (fclose(file) != 0)
+		ok = false;
+	if (!ok) {
+		printf("Could not write trace %s\n", filename.c_str());
+		return false;
+	}
+	printf("Trace written to %s (%zu events)\n", filename.c_str(), events.size());
+	return true;
+}
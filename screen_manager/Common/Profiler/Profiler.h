@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Scoped timers for the launcher UIs (screen_manager and the SDL launcher).
+// The time of every scope is added to its category in the current frame,
+// the last SCREEN_PROFILE_HISTORY frames are kept for the frame-time graph.
+// While a trace is running, every scope is also recorded as a Chrome trace
+// event and written as JSON when the trace stops (chrome://tracing, Perfetto).
+// Without the HUD and without a trace, a scope costs a flag check.
+
+enum SCREEN_ProfileCategory {
+	PROFILE_EVENTS,  // input and window events
+	PROFILE_UPDATE,  // screen update
+	PROFILE_LAYOUT,  // view layout
+	PROFILE_DRAW,    // draw list build
+	PROFILE_SUBMIT,  // GL submit
+	PROFILE_SWAP,    // swap / present, includes the vsync wait
+	PROFILE_CATEGORY_COUNT,
+};
+
+#define SCREEN_PROFILE_HISTORY 120
+
+struct SCREEN_ProfileFrame {
+	float categoryMs[PROFILE_CATEGORY_COUNT];
+};
+
+// the HUD is visible or a trace is running
+extern std::atomic<bool> SCREEN_g_profilerActive;
+
+class SCREEN_ProfileScope {
+public:
+	SCREEN_ProfileScope(const char *name, SCREEN_ProfileCategory category);
+	~SCREEN_ProfileScope();
+
+private:
+	const char *name_;
+	SCREEN_ProfileCategory category_;
+	int64_t startUs_;
+};
+
+#define SCREEN_PROFILE_CONCAT2(a, b) a##b
+#define SCREEN_PROFILE_CONCAT(a, b) SCREEN_PROFILE_CONCAT2(a, b)
+// name must be a string literal (or live until the trace is written)
+#define PROFILE_THIS_SCOPE(name, category) SCREEN_ProfileScope SCREEN_PROFILE_CONCAT(profileScope, __LINE__)(name, category)
+
+const char *SCREEN_ProfilerCategoryName(SCREEN_ProfileCategory category);
+// graph color, 0xAABBGGRR as in SCREEN_DrawBuffer
+uint32_t SCREEN_ProfilerCategoryColor(SCREEN_ProfileCategory category);
+
+// Closes the current frame, call once per rendered frame.
+void SCREEN_ProfilerEndFrame();
+// Copies up to max frames, oldest first. Returns the number of frames.
+int SCREEN_ProfilerGetFrames(SCREEN_ProfileFrame *frames, int max);
+
+void SCREEN_ProfilerSetHUD(bool visible);
+bool SCREEN_ProfilerHUDVisible();
+
+bool SCREEN_ProfilerStartTrace(const std::string &filename);
+// Writes the trace file, does nothing if no trace is running.
+bool SCREEN_ProfilerStopTrace();
@@ -71,6 +71,19 @@ bool SCREEN_NativeAxis(const AxisInput &axis);
 // will also be called sixty times per second. Main thread.
 void SCREEN_NativeRender(SCREEN_GraphicsContext *graphicsContext);
 
+// The main loop only renders when a frame was asked for. Anything that
+// changes what is on screen or animates calls this. Duration keeps frames
+// coming for that many seconds, SCREEN_RENDER_AFTER_INPUT covers the tweens,
+// scrolling and fades that follow input. A zero duration may be requested
+// from any thread, a longer one from the main thread only.
+#define SCREEN_RENDER_AFTER_INPUT 1.0
+void SCREEN_NativeRequestRender(double duration = 0.0);
+
+// True if a frame is due. SCREEN_NativeRenderRequested() also takes the
+// request, animations ask again while they are drawn. Main thread.
+bool SCREEN_NativeIsRenderPending();
+bool SCREEN_NativeRenderRequested();
+
 // This should render num_samples 44khz stereo samples.
 // Try not to make too many assumptions on the granularity
 // of num_samples.
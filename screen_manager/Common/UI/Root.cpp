@@ -7,6 +7,7 @@
 #include "Common/UI/ViewGroup.h"
 
 #include "Common/Log.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/TimeUtil.h"
 
 namespace SCREEN_UI {
@@ -110,6 +111,7 @@ bool IsFocusMovementEnabled() {
 }
 
 void LayoutViewHierarchy(const SCREEN_UIContext &dc, ViewGroup *root, bool ignoreInsets) {
+	PROFILE_THIS_SCOPE("LayoutViewHierarchy", PROFILE_LAYOUT);
 	if (!root) {
 		printf("Tried to layout a view hierarchy from a zero pointer root");
 		return;
@@ -187,6 +189,7 @@ const double repeatDelay = 15 * (1.0 / 60.0f);  // 15 frames like before.
 const double repeatInterval = 5 * (1.0 / 60.0f);  // 5 frames like before.
 
 bool KeyEvent(const KeyInput &key, ViewGroup *root) {
+	PROFILE_THIS_SCOPE("KeyEvent", PROFILE_EVENTS);
 	bool retval = false;
 	// Ignore repeats for focus moves.
 	if ((key.flags & (KEY_DOWN | KEY_IS_REPEAT)) == KEY_DOWN) {
@@ -264,6 +267,7 @@ restart:
 }
 
 bool TouchEvent(const TouchInput &touch, ViewGroup *root) {
+	PROFILE_THIS_SCOPE("TouchEvent", PROFILE_EVENTS);
 	focusForced = false;
 	root->Touch(touch);
 	if ((touch.flags & TOUCH_DOWN) && !focusForced) {
@@ -354,6 +358,7 @@ bool AxisEvent(const AxisInput &axis, ViewGroup *root) {
 }
 
 void UpdateViewHierarchy(ViewGroup *root) {
+	PROFILE_THIS_SCOPE("UpdateViewHierarchy", PROFILE_UPDATE);
 	ProcessHeldKeys(root);
 	frameCount++;
 
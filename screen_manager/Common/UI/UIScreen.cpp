@@ -6,6 +6,7 @@
 #include "Common/Input/InputState.h"
 #include "Common/Input/KeyCodes.h"
 #include "Common/Math/curves.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/UI/UIScreen.h"
 #include "Common/UI/Context.h"
 #include "Common/UI/Screen.h"
@@ -115,6 +116,7 @@ void SCREEN_UIScreen::render() {
 		SCREEN_UIContext *uiContext = screenManager()->getUIContext();
 		SCREEN_UI::LayoutViewHierarchy(*uiContext, root_, ignoreInsets_);
 
+		PROFILE_THIS_SCOPE("SCREEN_UIScreen::render", PROFILE_DRAW);
 		uiContext->PushTransform({translation_, scale_, alpha_});
 
 		uiContext->Begin();
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <set>
 #include <mutex>
@@ -1140,6 +1141,112 @@ void GridLayout::Layout() {
 	}
 }
 
+VirtualGridLayout::VirtualGridLayout(ListAdaptor *adaptor, GridLayoutSettings settings, bool singleColumn, LayoutParams *layoutParams)
+	: ViewGroup(layoutParams), adaptor_(adaptor), settings_(settings), singleColumn_(singleColumn) {
+}
+
+VirtualGridLayout::~VirtualGridLayout() {
+	for (View *view : recycled_)
+		delete view;
+	recycled_.clear();
+}
+
+View *VirtualGridLayout::GetItemView(int index) {
+	for (size_t i = 0; i < recycled_.size(); i++) {
+		if (adaptor_->RecycleItemView(recycled_[i], index)) {
+			View *view = recycled_[i];
+			recycled_.erase(recycled_.begin() + i);
+			return view;
+		}
+	}
+	return adaptor_->CreateItemView(index);
+}
+
+// Keeps views for the rows within one screen above and below the visible area.
+// The bounds are the ones of the previous layout, the margin covers the scrolling since.
+void VirtualGridLayout::UpdateItemViews(const Bounds &visible) {
+	float rowStride = settings_.rowHeight + settings_.spacing;
+	float top = visible.y - bounds_.y - visible.h;
+	float bottom = visible.y2() - bounds_.y + visible.h;
+
+	int firstRow = std::max(0, (int)floorf(top / rowStride));
+	int lastRow = std::max(0, (int)floorf(bottom / rowStride));
+	int first = std::min(numItems_, firstRow * numColumns_);
+	int last = std::min(numItems_, (lastRow + 1) * numColumns_);
+	if (first == firstItem_ && last == firstItem_ + (int)views_.size())
+		return;
+
+	std::lock_guard<std::mutex> guard(modifyLock_);
+	std::vector<View *> views;
+	views.reserve(last - first);
+	for (int i = 0; i < (int)views_.size(); i++) {
+		int index = firstItem_ + i;
+		if (index < first || index >= last) {
+			if (views_[i]->HasFocus())
+				SetFocusedView(nullptr);
+			if (adaptor_->CanRecycleItemView(views_[i]) && (int)recycled_.size() < last - first)
+				recycled_.push_back(views_[i]);
+			else
+				delete views_[i];
+		}
+	}
+	for (int index = first; index < last; index++) {
+		int i = index - firstItem_;
+		if (i >= 0 && i < (int)views_.size()) {
+			views.push_back(views_[i]);
+		} else {
+			views.push_back(GetItemView(index));
+		}
+	}
+	views_.swap(views);
+	firstItem_ = first;
+}
+
+void VirtualGridLayout::Measure(const SCREEN_UIContext &dc, MeasureSpec horiz, MeasureSpec vert) {
+	MeasureSpecType measureType = settings_.fillCells ? EXACTLY : AT_MOST;
+
+	MeasureBySpec(layoutParams_->width, 0.0f, horiz, &measuredWidth_);
+
+	if (singleColumn_) {
+		numColumns_ = 1;
+	} else {
+		numColumns_ = (measuredWidth_ - settings_.spacing) / (settings_.columnWidth + settings_.spacing);
+		if (!numColumns_) numColumns_ = 1;
+	}
+	numItems_ = adaptor_->GetNumItems();
+	UpdateItemViews(dc.GetBounds());
+
+	float columnWidth = singleColumn_ ? measuredWidth_ : settings_.columnWidth;
+	for (size_t i = 0; i < views_.size(); i++) {
+		views_[i]->Measure(dc, MeasureSpec(measureType, columnWidth), MeasureSpec(measureType, settings_.rowHeight));
+	}
+
+	int numRows = (numItems_ + (numColumns_ - 1)) / numColumns_;
+	float estimatedHeight = (settings_.rowHeight + settings_.spacing) * numRows;
+
+	MeasureBySpec(layoutParams_->height, estimatedHeight, vert, &measuredHeight_);
+}
+
+void VirtualGridLayout::Layout() {
+	float columnWidth = singleColumn_ ? bounds_.w : settings_.columnWidth;
+	for (size_t i = 0; i < views_.size(); i++) {
+		int index = firstItem_ + (int)i;
+		Bounds itemBounds, innerBounds;
+
+		itemBounds.x = bounds_.x + (index % numColumns_) * (columnWidth + settings_.spacing);
+		itemBounds.y = bounds_.y + (index / numColumns_) * (settings_.rowHeight + settings_.spacing);
+		itemBounds.w = columnWidth;
+		itemBounds.h = settings_.rowHeight;
+
+		ApplyGravity(itemBounds, Margins(0.0f),
+			views_[i]->GetMeasuredWidth(), views_[i]->GetMeasuredHeight(),
+			G_HCENTER | G_VCENTER, innerBounds);
+
+		views_[i]->SetBounds(innerBounds);
+		views_[i]->Layout();
+	}
+}
+
 TabHolder::TabHolder(Orientation orientation, float stripSize, LayoutParams *layoutParams, float leftMargin)
 	: LinearLayout(Opposite(orientation), layoutParams), stripSize_(stripSize) {
 	SetSpacing(0.0f);
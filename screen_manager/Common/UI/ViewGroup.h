@@ -348,6 +348,10 @@ public:
 	virtual std::string GetTitle(int index) const { return ""; }
 	virtual void SetSelected(int sel) { }
 	virtual int GetSelected() { return -1; }
+	// Points a view that went out of sight to another item. Returns false if the view can't show it.
+	virtual bool RecycleItemView(View *view, int index) { return false; }
+	// Whether RecycleItemView() accepts this view for any item at all, views that can't be reused are deleted.
+	virtual bool CanRecycleItemView(View *view) { return false; }
 };
 
 class ChoiceListAdaptor : public ListAdaptor {
@@ -401,4 +405,31 @@ private:
 	std::set<int> hidden_;
 };
 
+// Same placement as GridLayout (one column filling the width if singleColumn is set),
+// but only the items in and around the visible area exist as views. Items that
+// scroll out of sight go to a pool and are reused for new ones via RecycleItemView().
+// The pool holds at most as many views as are in range, only of the kinds the adaptor
+// can recycle; the other views are deleted.
+class VirtualGridLayout : public ViewGroup {
+public:
+	VirtualGridLayout(ListAdaptor *adaptor, GridLayoutSettings settings, bool singleColumn, LayoutParams *layoutParams = 0);
+	~VirtualGridLayout();
+
+	void Measure(const SCREEN_UIContext &dc, MeasureSpec horiz, MeasureSpec vert) override;
+	void Layout() override;
+	std::string Describe() const override { return "VirtualGridLayout: " + View::Describe(); }
+
+private:
+	void UpdateItemViews(const Bounds &visible);
+	View *GetItemView(int index);
+
+	ListAdaptor *adaptor_;
+	GridLayoutSettings settings_;
+	bool singleColumn_;
+	int numColumns_ = 1;
+	int numItems_ = 0;
+	int firstItem_ = 0;  // item shown by views_[0]
+	std::vector<View *> recycled_;
+};
+
 }  // namespace SCREEN_UI
@@ -317,7 +317,7 @@ int SDLGLSCREEN_GraphicsContext::Init(SDL_Window *&window, int x, int y, int mod
 	// On Mac, full screen animates so each attempt is slow.
 	mode |= SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN;
 
-	SDL_GLContext glContext = nullptr;
+	glContext = nullptr;
 	for (size_t i = 0; i < ARRAY_SIZE(attemptVersions); ++i) {
 		const auto &ver = attemptVersions[i];
 		// Make sure to request a somewhat modern GL context at least - the
@@ -414,6 +414,8 @@ int SDLGLSCREEN_GraphicsContext::Init(SDL_Window *&window, int x, int y, int mod
 	CheckGLExtensions();
 	draw_ = SCREEN_Draw::T3DCreateGLContext();
 	renderManager_ = (SCREEN_GLRenderManager *)draw_->GetNativeObject(SCREEN_Draw::SCREEN_NativeObject::RENDER_MANAGER);
+	// Double buffered: the main thread records a frame while the render thread runs the previous one.
+	renderManager_->SetInflightFrames(2);
 	SetGPUBackend(SCREEN_GPUBackend::OPENGL);
 	bool success = draw_->CreatePresets();
 	_assert_(success);
@@ -439,6 +441,28 @@ void SDLGLSCREEN_GraphicsContext::SwapInterval(int interval) {
 	renderManager_->SwapInterval(interval);
 }
 
+bool SDLGLSCREEN_GraphicsContext::MakeCurrent() {
+#ifdef USING_EGL
+	if (useEGLSwap)
+		return eglMakeCurrent(g_eglDisplay, g_eglSurface, g_eglSurface, g_eglContext) == EGL_TRUE;
+#endif
+	if (SDL_GL_MakeCurrent(window_, glContext) != 0) {
+		fprintf(stderr, "SDL_GL_MakeCurrent failed: %s\n", SDL_GetError());
+		return false;
+	}
+	return true;
+}
+
+void SDLGLSCREEN_GraphicsContext::ReleaseCurrent() {
+#ifdef USING_EGL
+	if (useEGLSwap) {
+		eglMakeCurrent(g_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		return;
+	}
+#endif
+	SDL_GL_MakeCurrent(window_, nullptr);
+}
+
 void SDLGLSCREEN_GraphicsContext::Shutdown() {
 }
 
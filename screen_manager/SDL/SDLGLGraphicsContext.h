@@ -46,6 +46,11 @@ public:
 		renderManager_->StopThread();
 	}
 
+	// The GL context is current on one thread at a time. The render thread
+	// takes it over after init and hands it back for the shutdown.
+	bool MakeCurrent();
+	void ReleaseCurrent();
+
 private:
 	SCREEN_Draw::SCREEN_DrawContext *draw_ = nullptr;
 	SDL_Window *window_;
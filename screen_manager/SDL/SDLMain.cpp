@@ -16,6 +16,7 @@ SCREEN_SDLJoystick *SCREEN_joystick = NULL;
 #include <atomic>
 #include <algorithm>
 #include <cmath>
+#include <future>
 #include <thread>
 #include <locale>
 
@@ -25,6 +26,7 @@ SCREEN_SDLJoystick *SCREEN_joystick = NULL;
 #include "Common/Data/Format/PNGLoad.h"
 #include "NKCodeFromSDL.h"
 #include "Common/Math/math_util.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/GPU/OpenGL/GLRenderManager.h"
 
 #include "SDL_syswm.h"
@@ -49,10 +51,12 @@ SCREEN_SDLJoystick *SCREEN_joystick = NULL;
 #include "SDLGLGraphicsContext.h"
 #include "../../include/gui.h"
 #include "../../include/controller.h"
+#include "../../include/watcher.h"
 #include "../include/statemachine.h"
 #include "../include/log.h"
 
 void mainLoopWii(void);
+void launch_emulator(void);
 void SCREEN_NativeResized(void);
 extern bool restart_screen_manager;
 extern bool shutdown_now;
@@ -70,6 +74,70 @@ static bool SCREEN_g_ToggleFullScreenNextFrame = false;
 static int SCREEN_g_ToggleFullScreenType;
 static int SCREEN_g_QuitRequested = 0;
 
+// While nothing changes the loop sleeps in SDL_WaitEventTimeout() and only
+// wakes up to poll the wiimote and the library watcher. While frames are
+// due it keeps the previous pace.
+#define IDLE_TIMEOUT_MS 50
+#define FRAME_DELAY_MS  10
+
+// sticks resting near the center keep sending axis events
+static bool SCREEN_IsIdleEvent(const SDL_Event &event) {
+    switch (event.type) {
+    case SDL_JOYAXISMOTION:
+        return abs(event.jaxis.value) <= ANALOG_DEAD_ZONE;
+    case SDL_CONTROLLERAXISMOTION:
+        return abs(event.caxis.value) <= ANALOG_DEAD_ZONE;
+    default:
+        return false;
+    }
+}
+
+// GL runs on its own thread: the main thread handles the events, updates the
+// screens and records the draw steps, the render thread executes them and
+// swaps. A stalling GL driver does not hold up the input handling, the main
+// thread only waits when it is two frames ahead.
+static std::thread SCREEN_renderThread;
+static bool SCREEN_useRenderThread = false;
+
+static void SCREEN_RenderThreadFunc(SDLGLSCREEN_GraphicsContext *ctx, std::promise<bool> *started) {
+    setCurrentThreadName("Render");
+    if (!ctx->MakeCurrent()) {
+        started->set_value(false);
+        return;
+    }
+    ctx->ThreadStart();
+    started->set_value(true);
+
+    // returns false after StopThread()
+    while (ctx->ThreadFrame()) {
+    }
+
+    ctx->ThreadEnd();
+    ctx->ReleaseCurrent();
+}
+
+// Returns false if the context could not be moved, it stays on the main thread then.
+static bool SCREEN_RenderThreadStart(SDLGLSCREEN_GraphicsContext *ctx) {
+    std::promise<bool> started;
+    std::future<bool> result = started.get_future();
+
+    ctx->ReleaseCurrent();
+    SCREEN_renderThread = std::thread(SCREEN_RenderThreadFunc, ctx, &started);
+    if (result.get())
+        return true;
+
+    SCREEN_renderThread.join();
+    ctx->MakeCurrent();
+    return false;
+}
+
+// Runs the queued frames, then the context is current on the main thread again.
+static void SCREEN_RenderThreadStop(SDLGLSCREEN_GraphicsContext *ctx) {
+    ctx->StopThread();
+    SCREEN_renderThread.join();
+    ctx->MakeCurrent();
+}
+
 static int SCREEN_g_DesktopWidth = 0;
 static int SCREEN_g_DesktopHeight = 0;
 static float SCREEN_g_RefreshRate = 60.f;
@@ -406,6 +474,30 @@ void SCREEN_ToggleFullScreenIfFlagSet(SDL_Window *window) {
         SDL_SetWindowFullscreen(window, window_flags);
     }
 }
+
+// A game is launched from within the main loop. The core runs in a window
+// of its own (beginEmulatorSession() in session.cpp), the GL context, the
+// render thread, the UI atlas and the textures stay resident on the hidden
+// launcher window. Only the audio device is handed over to the core.
+static void SCREEN_LaunchEmulator(SDLGLSCREEN_GraphicsContext *ctx) {
+    SCREEN_StopSDLAudioDevice();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+
+    launch_emulator();
+    launch_request_from_screen_manager = false;
+
+    // the core made a context of its own current on the main thread
+    if (!SCREEN_useRenderThread)
+        ctx->MakeCurrent();
+
+    // the controllers were closed and opened again meanwhile
+    delete SCREEN_joystick;
+    SCREEN_joystick = new SCREEN_SDLJoystick();
+
+    SCREEN_InitSDLAudioDevice();
+    SCREEN_NativeRequestRender();
+}
+
 void gpu_features_reset(void);
 int screen_manager_main(int argc, char *argv[]) {
     gpu_features_reset();
@@ -511,7 +603,7 @@ int screen_manager_main(int argc, char *argv[]) {
     }
     graphicsContext = ctx;
 
-    // Since we render from the main thread, there's nothing done here, but we call it to avoid confusion.
+    // The render thread only takes over the context, there's nothing done here, but we call it to avoid confusion.
     if (!graphicsContext->InitFromRenderThread(&error_message)) {
         printf("Init from thread error: '%s'\n", error_message.c_str());
     }
@@ -524,12 +616,19 @@ int screen_manager_main(int argc, char *argv[]) {
 
     SCREEN_NativeInitGraphics(graphicsContext);
         
-    graphicsContext->ThreadStart();
+    SCREEN_useRenderThread = SCREEN_RenderThreadStart(ctx);
+    if (!SCREEN_useRenderThread) {
+        printf("Could not start the render thread, rendering on the main thread\n");
+        graphicsContext->ThreadStart();
+    }
 
     while (true) {
 
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
+            PROFILE_THIS_SCOPE("SDL event", PROFILE_EVENTS);
+            if (!SCREEN_IsIdleEvent(event))
+                SCREEN_NativeRequestRender(SCREEN_RENDER_AFTER_INPUT);
             switch (event.type) {
             case SDL_QUIT:
                 SCREEN_g_QuitRequested = 1;
@@ -545,6 +644,11 @@ int screen_manager_main(int argc, char *argv[]) {
                         printJoyInfoAll();
                         break;
                     } else
+                    if (event.key.keysym.sym == SDLK_F3) 
+                    {
+                        SCREEN_ProfilerSetHUD(!SCREEN_ProfilerHUDVisible());
+                        break;
+                    } else
                     {
                         int k = event.key.keysym.sym;
                         KeyInput key;
@@ -669,16 +773,29 @@ int screen_manager_main(int argc, char *argv[]) {
             }
         }
         
+        // consumed by the screen update
+        if (gUpdateCurrentScreen)
+            SCREEN_NativeRequestRender();
         SCREEN_NativeUpdate();
-        SCREEN_NativeRender(graphicsContext);
-        
-        graphicsContext->ThreadFrame();
 
-        graphicsContext->SwapBuffers();
+        if (SCREEN_NativeRenderRequested()) {
+            SCREEN_NativeRender(graphicsContext);
+
+            if (!SCREEN_useRenderThread)
+                graphicsContext->ThreadFrame();
+
+            graphicsContext->SwapBuffers();
+            SCREEN_ProfilerEndFrame();
+        }
+
+        if (launch_request_from_screen_manager)
+            SCREEN_LaunchEmulator(ctx);
 
         if (SCREEN_g_QuitRequested) break;
-        SDL_Delay(10);
+        SDL_WaitEventTimeout(nullptr, SCREEN_NativeIsRenderPending() ? FRAME_DELAY_MS : IDLE_TIMEOUT_MS);
         mainLoopWii();
+        if (pollLibraryWatcher())
+            SCREEN_NativeRequestRender();
     }
 
     SCREEN_StopSDLAudioDevice();
@@ -688,7 +805,10 @@ int screen_manager_main(int argc, char *argv[]) {
 
     delete SCREEN_joystick;
 
-    graphicsContext->ThreadEnd();
+    if (SCREEN_useRenderThread)
+        SCREEN_RenderThreadStop(ctx);
+    else
+        graphicsContext->ThreadEnd();
 
     SCREEN_NativeShutdown();
 
@@ -40,23 +40,25 @@
 #include "Common/TimeUtil.h"
 #include "Common/StringUtils.h"
 #include "Common/Render/Sprite_Sheet.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "UI/MainScreen.h"
 #include "UI/MiscScreens.h"
+#include "UI/TextureUtil.h"
 #include <SDL.h>
 
 #include "../include/controller.h"
+#include "../include/watcher.h"
+#include "../include/crawler.h"
+#include "../include/library.h"
+#include "../include/statemachine.h"
 #include "../include/log.h"
 
 void UISetBackground(SCREEN_UIContext &dc,std::string bgPng);
 void DrawBackgroundSimple(SCREEN_UIContext &dc, int page);
-void findAllFiles(const char * directory, std::list<std::string> *tmpList, std::list<std::string> *toBeRemoved, bool recursiveSearch=true);
-void stripList(std::list<std::string> *tmpList,std::list<std::string> *toBeRemoved);
-void finalizeList(std::list<std::string> *tmpList);
 extern bool launch_request_from_screen_manager;
 extern bool restart_screen_manager;
 extern std::string game_screen_manager;
 extern std::string gBaseDir;
-extern bool stopSearching;
 extern int gTheme;
 extern SCREEN_ScreenManager *SCREEN_screenManager;
 
@@ -505,6 +507,9 @@ void SCREEN_MainInfoMessage::Draw(SCREEN_UIContext &dc) {
         alpha = MAX_ALPHA - MAX_ALPHA * (float)((sinceShow - timeToShow) / FADE_TIME);
     }
 
+    if (alpha > 0.0f)
+        SCREEN_NativeRequestRender();
+
     if (alpha >= 0.1f) {
         SCREEN_UI::Style style = dc.theme->popupTitle;
         style.background.color = colorAlpha(style.background.color, alpha - 0.1f);
@@ -533,6 +538,11 @@ public:
     }
 
     const std::string &GetPath() const { return gamePath_; }
+    void SetPath(const std::string &gamePath) {
+        gamePath_ = gamePath;
+        holdStart_ = 0.0;
+        down_ = false;
+    }
 
     void SetHoldEnabled(bool hold) {
         holdEnabled_ = hold;
@@ -629,6 +639,16 @@ void SCREEN_GameButton::Draw(SCREEN_UIContext &dc) {
     if (!IsEnabled()) style = dc.theme->buttonDisabledStyle;
 
     dc.FillRect(style.background, bounds_);
+
+    // box art replaces the name in the grid
+    SCREEN_Draw::SCREEN_Texture *texture = nullptr;
+    if (gridStyle_ && g_thumbnailCache) {
+        texture = g_thumbnailCache->GetTexture(gamePath_);
+    }
+    if (texture) {
+        DrawThumbnail(dc, texture, bounds_.Expand(-4.0f));
+        return;
+    }
     
     int startChar = gamePath_.find_last_of("/") + 1;  //show only file name
     int endChar = gamePath_.find_last_of("."); // remove extension
@@ -765,7 +785,7 @@ SCREEN_GameBrowser::SCREEN_GameBrowser(std::string path, SCREEN_BrowseFlags brow
     : LinearLayout(SCREEN_UI::ORIENT_VERTICAL, layoutParams), path_(path), gridStyle_(gridStyle), screenManager_(screenManager), browseFlags_(browseFlags), lastText_(lastText), lastLink_(lastLink) {
     using namespace SCREEN_UI;
     DEBUG_PRINTF("   SCREEN_GameBrowser::SCREEN_GameBrowser\n");
-    Refresh();
+    StartListing();
 }
 
 SCREEN_GameBrowser::~SCREEN_GameBrowser() {
@@ -775,7 +795,7 @@ SCREEN_GameBrowser::~SCREEN_GameBrowser() {
 void SCREEN_GameBrowser::SetPath(const std::string &path) {
     DEBUG_PRINTF("   void SCREEN_GameBrowser::SetPath(const std::string &path) %s\n",path.c_str());
     path_.SetPath(path);
-    Refresh();
+    StartListing();
 }
 
 std::string SCREEN_GameBrowser::GetPath() {
@@ -793,9 +813,26 @@ SCREEN_UI::EventReturn SCREEN_GameBrowser::LayoutChange(SCREEN_UI::EventParams &
 
 void SCREEN_GameBrowser::Update() {
     LinearLayout::Update();
-    if (listingPending_ && path_.IsListingReady()) {
-        Refresh();
+    if (listingPending_ && gameListing_.IsReady()) {
+        std::string path;
+        std::list<std::string> games;
+        std::vector<FileInfo> folders;
+        if (gameListing_.GetListing(path, games, folders) && (path == path_.GetPath())) {
+            finalizeList(&games);
+            games_.assign(games.begin(), games.end());
+            folders_.swap(folders);
+            listingValid_ = true;
+            listingPending_ = false;
+            Refresh();
+        }
+    } else if (libraryFolderChanged(path_.GetPath(), &watchGeneration_)) {
+        // the current list stays until the new one is ready
+        listingPending_ = true;
+        gameListing_.SetPath(path_.GetPath());
     }
+    // the list shows up as soon as it is ready
+    if (listingPending_)
+        SCREEN_NativeRequestRender();
 }
 
 void SCREEN_GameBrowser::Draw(SCREEN_UIContext &dc) {
@@ -831,6 +868,16 @@ void SCREEN_GameBrowser::Draw(SCREEN_UIContext &dc) {
     }
 }
 
+void SCREEN_GameBrowser::StartListing() {
+    DEBUG_PRINTF("   void SCREEN_GameBrowser::StartListing()\n");
+    games_.clear();
+    folders_.clear();
+    listingValid_ = false;
+    listingPending_ = true;
+    gameListing_.SetPath(path_.GetPath());
+    Refresh();
+}
+
 void SCREEN_GameBrowser::Refresh() {
     using namespace SCREEN_UI;
     DEBUG_PRINTF("   void SCREEN_GameBrowser::Refresh()\n");
@@ -843,80 +890,24 @@ void SCREEN_GameBrowser::Refresh() {
 
     Add(new Spacer(1.0f));
     auto mm = GetI18NCategory("MainMenu");
-    
-    if (*gridStyle_) {
-        gameList_ = new SCREEN_UI::GridLayout(SCREEN_UI::GridLayoutSettings(150*1.0f, 85*1.0f), new LinearLayoutParams(FILL_PARENT, WRAP_CONTENT));
-    } else {
-        SCREEN_UI::LinearLayout *gl = new SCREEN_UI::LinearLayout(SCREEN_UI::ORIENT_VERTICAL, new LinearLayoutParams(FILL_PARENT, WRAP_CONTENT));
-        gl->SetSpacing(4.0f);
-        gameList_ = gl;
-    }
-    Add(gameList_);
-    
-    // Show games in the current directory
-    std::vector<SCREEN_GameButton *> gameButtons;
-
-    // Show folders in the current directory
-    std::vector<SCREEN_DirButtonMain *> dirButtons;
 
-    listingPending_ = !path_.IsListingReady();
-
-    std::vector<std::string> filenames;
-    if (!listingPending_) {
+    if (listingValid_) {
         lastGamePath = path_.GetPath();
         gamesPathView->SetText(path_.GetFriendlyPath().c_str());
-        
-        std::list<std::string> tmpList;
-        std::list<std::string> toBeRemoved;
-        std::string pathToBeSearched;
-        std::string strList;
-        std::list<std::string>::iterator iteratorTmpList;
-        
-        pathToBeSearched = path_.GetPath();
-        stopSearching=false;
-        findAllFiles(pathToBeSearched.c_str(),&tmpList,&toBeRemoved,false);
-        stripList(&tmpList,&toBeRemoved); // strip cue file entries
-        finalizeList(&tmpList);
-        
-        iteratorTmpList = tmpList.begin();
-        for (int i=0;i<tmpList.size();i++)
-        {
-            strList = *iteratorTmpList;
-            iteratorTmpList++;
-            gameButtons.push_back(new SCREEN_GameButton(strList, *gridStyle_, new SCREEN_UI::LinearLayoutParams(*gridStyle_ == true ? SCREEN_UI::WRAP_CONTENT : SCREEN_UI::FILL_PARENT, 50.0f)));
-        }
-        
-        std::vector<FileInfo> fileInfo;
-        path_.GetListing(fileInfo, "");
-        for (size_t i = 0; i < fileInfo.size(); i++) {
-            if (fileInfo[i].isDirectory) {
-                if (browseFlags_ & SCREEN_BrowseFlags::NAVIGATE) {
-                    dirButtons.push_back(new SCREEN_DirButtonMain(fileInfo[i].fullName, fileInfo[i].name, *gridStyle_, new SCREEN_UI::LinearLayoutParams(SCREEN_UI::FILL_PARENT, 50.0f)));
-                }
-            }
-        }
     }
+    showFolders_ = (browseFlags_ & SCREEN_BrowseFlags::NAVIGATE);
+    showUpButton_ = showFolders_ && (lastGamePath != "/");
 
-    if (browseFlags_ & SCREEN_BrowseFlags::NAVIGATE) {
-        if (lastGamePath != "/")
-        {
-            SCREEN_DirButtonMain* UP_button = new SCREEN_DirButtonMain("..", *gridStyle_, new SCREEN_UI::LinearLayoutParams(SCREEN_UI::FILL_PARENT, 50.0f));
-            UP_button->OnClick.Handle(this, &SCREEN_GameBrowser::NavigateClick);
-            gameList_->Add(UP_button);
-        }
+    // only the buttons in sight are created, see SCREEN_GameListAdaptor
+    if (*gridStyle_) {
+        gameList_ = new VirtualGridLayout(&listAdaptor_, GridLayoutSettings(150*1.0f, 85*1.0f), false, new LinearLayoutParams(FILL_PARENT, WRAP_CONTENT));
+    } else {
+        gameList_ = new VirtualGridLayout(&listAdaptor_, GridLayoutSettings(500, 50, 4), true, new LinearLayoutParams(FILL_PARENT, WRAP_CONTENT));
     }
+    Add(gameList_);
 
-    if (listingPending_) {
-        gameList_->Add(new SCREEN_UI::TextView(mm->T("Loading..."), ALIGN_CENTER, false, new SCREEN_UI::LinearLayoutParams(SCREEN_UI::FILL_PARENT, SCREEN_UI::FILL_PARENT)));
-    }
-    
-       for (size_t i = 0; i < gameButtons.size(); i++) {
-        gameList_->Add(gameButtons[i])->OnClick.Handle(this, &SCREEN_GameBrowser::GameButtonClick);
-    }
-    
-    for (size_t i = 0; i < dirButtons.size(); i++) {
-        std::string str = dirButtons[i]->GetPath();
-        gameList_->Add(dirButtons[i])->OnClick.Handle(this, &SCREEN_GameBrowser::NavigateClick);
+    if (!listingValid_) {
+        Add(new SCREEN_UI::TextView(mm->T("Loading..."), ALIGN_CENTER, false, new SCREEN_UI::LinearLayoutParams(SCREEN_UI::FILL_PARENT, 50.0f)));
     }
 }
 
@@ -958,12 +949,20 @@ SCREEN_UI::EventReturn SCREEN_GameBrowser::GameButtonClick(SCREEN_UI::EventParam
     SCREEN_GameButton *button = static_cast<SCREEN_GameButton *>(e.v);
     std::string text = button->GetPath();
     
+    // an mdf image mednafen cannot read is converted first
+    if (startGameConversion(text)) {
+        auto ma = GetI18NCategory("Main");
+        auto conversion = new SCREEN_ConversionScreen(ma->T("Converting game"), text);
+        conversion->SetPopupOrigin(button);
+        screenManager_->push(conversion);
+        return SCREEN_UI::EVENT_DONE;
+    }
+
+    // picked up by the main loop, the screen manager stays resident while the game runs
     DEBUG_PRINTF("   ###############  launching %s ############### \n",text.c_str());
     launch_request_from_screen_manager = true;
     game_screen_manager = text;
 
-    SCREEN_System_SendMessage("finish", "");
-
     return SCREEN_UI::EVENT_DONE;
 }
 
@@ -973,6 +972,147 @@ SCREEN_UI::EventReturn SCREEN_GameBrowser::OnRecentClear(SCREEN_UI::EventParams
     return SCREEN_UI::EVENT_DONE;
 }
 
+int SCREEN_GameListAdaptor::GetNumItems() {
+    return (browser_->showUpButton_ ? 1 : 0) + browser_->games_.size() + (browser_->showFolders_ ? browser_->folders_.size() : 0);
+}
+
+SCREEN_UI::View *SCREEN_GameListAdaptor::CreateItemView(int index) {
+    bool gridStyle = *browser_->gridStyle_;
+
+    if (browser_->showUpButton_) {
+        if (index == 0) {
+            SCREEN_DirButtonMain *UP_button = new SCREEN_DirButtonMain("..", gridStyle, new SCREEN_UI::LinearLayoutParams(SCREEN_UI::FILL_PARENT, 50.0f));
+            UP_button->OnClick.Handle(browser_, &SCREEN_GameBrowser::NavigateClick);
+            return UP_button;
+        }
+        index--;
+    }
+    if (index < (int)browser_->games_.size()) {
+        SCREEN_GameButton *gameButton = new SCREEN_GameButton(browser_->games_[index], gridStyle, new SCREEN_UI::LinearLayoutParams(gridStyle == true ? SCREEN_UI::WRAP_CONTENT : SCREEN_UI::FILL_PARENT, 50.0f));
+        gameButton->OnClick.Handle(browser_, &SCREEN_GameBrowser::GameButtonClick);
+        return gameButton;
+    }
+    index -= browser_->games_.size();
+    const FileInfo &folder = browser_->folders_[index];
+    SCREEN_DirButtonMain *dirButton = new SCREEN_DirButtonMain(folder.fullName, folder.name, gridStyle, new SCREEN_UI::LinearLayoutParams(SCREEN_UI::FILL_PARENT, 50.0f));
+    dirButton->OnClick.Handle(browser_, &SCREEN_GameBrowser::NavigateClick);
+    return dirButton;
+}
+
+// game buttons are reused while scrolling, they make up most of a big folder
+bool SCREEN_GameListAdaptor::RecycleItemView(SCREEN_UI::View *view, int index) {
+    if (browser_->showUpButton_) {
+        if (index == 0) return false;
+        index--;
+    }
+    if (index >= (int)browser_->games_.size()) return false;
+
+    SCREEN_GameButton *gameButton = dynamic_cast<SCREEN_GameButton *>(view);
+    if (!gameButton) return false;
+    gameButton->SetPath(browser_->games_[index]);
+    return true;
+}
+
+bool SCREEN_GameListAdaptor::CanRecycleItemView(SCREEN_UI::View *view) {
+    return dynamic_cast<SCREEN_GameButton *>(view) != nullptr;
+}
+
+SCREEN_GameListing::~SCREEN_GameListing() {
+    std::unique_lock<std::mutex> guard(pendingLock_);
+    pendingCancel_ = true;
+    pendingStop_ = true;
+    pendingCond_.notify_all();
+    guard.unlock();
+
+    if (pendingThread_.joinable()) {
+        pendingThread_.join();
+    }
+}
+
+void SCREEN_GameListing::SetPath(const std::string &path) {
+    DEBUG_PRINTF("   void SCREEN_GameListing::SetPath(const std::string &path) %s\n",path.c_str());
+    std::lock_guard<std::mutex> guard(pendingLock_);
+
+    ready_ = false;
+    // a folder still being read is outdated
+    pendingCancel_ = true;
+    pendingPath_ = path;
+    pendingCond_.notify_all();
+
+    if (pendingThread_.joinable())
+        return;
+
+    pendingThread_ = std::thread([this] {
+        setCurrentThreadName("GameListing");
+        Run();
+    });
+}
+
+bool SCREEN_GameListing::IsReady() {
+    std::lock_guard<std::mutex> guard(pendingLock_);
+    return ready_;
+}
+
+bool SCREEN_GameListing::GetListing(std::string &path, std::list<std::string> &games, std::vector<FileInfo> &folders) {
+    std::lock_guard<std::mutex> guard(pendingLock_);
+    if (!ready_) return false;
+
+    path = path_;
+    games.swap(games_);
+    folders.swap(folders_);
+    games_.clear();
+    folders_.clear();
+    return true;
+}
+
+void SCREEN_GameListing::Run() {
+    std::unique_lock<std::mutex> guard(pendingLock_);
+
+    while (!pendingStop_) {
+        if (pendingPath_.empty()) {
+            pendingCond_.wait(guard);
+            continue;
+        }
+        std::string path = pendingPath_;
+        pendingPath_.clear();
+        pendingCancel_ = false;
+        guard.unlock();
+
+        std::list<std::string> games;
+        std::list<std::string> toBeRemoved;
+        std::vector<FileInfo> folders;
+        std::vector<FileInfo> fileInfo;
+        T_LibraryDir entry;
+        bool fromLibrary;
+
+        if (readLibraryFolder(path, CRAWL_GAMES | CRAWL_CLASSIFY, &pendingCancel_, &entry, &fromLibrary)) {
+            for (const T_LibraryFile &file : entry.files) {
+                games.push_back(path + file.name);
+            }
+            for (const std::string &cueReference : entry.cueReferences) {
+                toBeRemoved.push_back(cueReference);
+            }
+            if (!fromLibrary) setLibraryDir(path, entry);
+            stripList(&games, &toBeRemoved); // strip cue file entries
+            games.sort();
+        }
+
+        getFilesInDir(path.c_str(), &fileInfo, "");
+        for (size_t i = 0; i < fileInfo.size(); i++) {
+            if (fileInfo[i].isDirectory) folders.push_back(fileInfo[i]);
+        }
+
+        guard.lock();
+        // results of an outdated request are dropped
+        if (pendingPath_.empty() && !pendingStop_) {
+            path_ = path;
+            games_.swap(games);
+            folders_.swap(folders);
+            ready_ = true;
+        }
+    }
+}
+
 #define TRANSPARENT_BACKGROUND true
 void SCREEN_OffDiagScreen::CreatePopupContents(SCREEN_UI::ViewGroup *parent) {
     using namespace SCREEN_UI;
@@ -1026,6 +1166,68 @@ SCREEN_UI::EventReturn SCREEN_OffDiagScreen::QuitMarley(SCREEN_UI::EventParams &
     return SCREEN_UI::EVENT_DONE;
 }
 
+SCREEN_ConversionScreen::~SCREEN_ConversionScreen() {
+    if (running_)
+        cancelGameConversion();
+}
+
+void SCREEN_ConversionScreen::CreatePopupContents(SCREEN_UI::ViewGroup *parent) {
+    using namespace SCREEN_UI;
+
+    auto ma = GetI18NCategory("Main");
+    SCREEN_UIContext &dc = *screenManager()->getUIContext();
+
+    LinearLayout *items = new LinearLayout(ORIENT_VERTICAL, new LinearLayoutParams(FILL_PARENT, WRAP_CONTENT));
+    items->SetSpacing(10.0f);
+
+    std::string name = game_.substr(game_.find_last_of("/") + 1);
+    status_ = items->Add(new TextView(name, ALIGN_LEFT | ALIGN_VCENTER, false));
+    status_->SetTextColor(dc.theme->popupStyle.fgColor);
+    progress_ = items->Add(new ProgressBar(new LinearLayoutParams(FILL_PARENT, 40.0f)));
+
+    if (gTheme == THEME_RETRO)
+        items->Add(new Choice(ma->T("CANCEL"), TRANSPARENT_BACKGROUND, new LayoutParams(200.0f, 64.0f)))->OnClick.Handle<SCREEN_UIScreen>(this, &SCREEN_UIScreen::OnBack);
+    else
+        items->Add(new Choice(ma->T("CANCEL"), new LayoutParams(200.0f, 64.0f)))->OnClick.Handle<SCREEN_UIScreen>(this, &SCREEN_UIScreen::OnBack);
+
+    parent->Add(items);
+}
+
+void SCREEN_ConversionScreen::update() {
+    SCREEN_PopupScreen::update();
+
+    int percent = 0;
+    bool ok;
+
+    if (!running_)
+        return;
+    if (pollGameConversion(&percent, &ok)) {
+        progress_->SetProgress(percent / 100.0f);
+        // frames are only rendered on request, the progress is polled once per frame
+        SCREEN_NativeRequestRender();
+        return;
+    }
+
+    running_ = false;
+    if (ok) {
+        DEBUG_PRINTF("   ###############  launching %s ############### \n",game_.c_str());
+        launch_request_from_screen_manager = true;
+        game_screen_manager = game_;
+        TriggerFinish(DR_OK);
+    } else {
+        auto ma = GetI18NCategory("Main");
+        status_->SetText(ma->T("Conversion failed"));
+        SCREEN_NativeRequestRender();
+    }
+}
+
+void SCREEN_ConversionScreen::OnCompleted(DialogResult result) {
+    if (running_) {
+        cancelGameConversion();
+        running_ = false;
+    }
+}
+
 SCREEN_ImageID checkControllerType(std::string name, std::string nameDB, bool mappingOK)
 {
     if (!mappingOK)
@@ -18,7 +18,9 @@
 #pragma once
 
 #include "ppsspp_config.h"
+#include <atomic>
 #include <condition_variable>
+#include <list>
 #include <mutex>
 #include <thread>
 #include "Common/UI/UIScreen.h"
@@ -100,6 +102,45 @@ private:
     float cutOffY_;
 };
 
+// Reads a folder for the game browser on a worker thread: the game
+// candidates (via the library index, see crawler.h) and the sub folders.
+class SCREEN_GameListing {
+public:
+    ~SCREEN_GameListing();
+
+    void SetPath(const std::string &path);
+    bool IsReady();
+    bool GetListing(std::string &path, std::list<std::string> &games, std::vector<FileInfo> &folders);
+
+private:
+    void Run();
+
+    std::string path_;
+    std::list<std::string> games_;
+    std::vector<FileInfo> folders_;
+    std::string pendingPath_;
+    std::condition_variable pendingCond_;
+    std::mutex pendingLock_;
+    std::thread pendingThread_;
+    std::atomic<bool> pendingCancel_{false};
+    bool pendingStop_ = false;
+    bool ready_ = false;
+};
+
+// Items of the game browser: "..", the games, the sub folders
+class SCREEN_GameListAdaptor : public SCREEN_UI::ListAdaptor {
+public:
+    SCREEN_GameListAdaptor(SCREEN_GameBrowser *browser) : browser_(browser) {}
+
+    SCREEN_UI::View *CreateItemView(int index) override;
+    bool RecycleItemView(SCREEN_UI::View *view, int index) override;
+    bool CanRecycleItemView(SCREEN_UI::View *view) override;
+    int GetNumItems() override;
+
+private:
+    SCREEN_GameBrowser *browser_;
+};
+
 class SCREEN_GameBrowser : public SCREEN_UI::LinearLayout {
 public:
     SCREEN_GameBrowser(std::string path, SCREEN_BrowseFlags browseFlags, bool *gridStyle, SCREEN_ScreenManager *screenManager, std::string lastText, std::string lastLink, SCREEN_UI::LayoutParams *layoutParams = nullptr);
@@ -116,8 +157,11 @@ public:
 protected:
 
     void Refresh();
+    void StartListing();
 
 private:
+    friend class SCREEN_GameListAdaptor;
+
     bool IsCurrentPathPinned();
     const std::vector<std::string> GetPinnedPaths();
     const std::string GetBaseName(const std::string &path);
@@ -138,7 +182,15 @@ private:
     std::string lastText_;
     std::string lastLink_;
     std::string focusGamePath_;
+    SCREEN_GameListing gameListing_;
+    SCREEN_GameListAdaptor listAdaptor_{this};
+    std::vector<std::string> games_;
+    std::vector<FileInfo> folders_;
+    bool showUpButton_ = false;
+    bool showFolders_ = false;
+    bool listingValid_ = false;
     bool listingPending_ = false;
+    int watchGeneration_ = 0;
     float lastScale_ = 1.0f;
     bool lastLayoutWasGrid_ = true;
     SCREEN_ScreenManager *screenManager_;
@@ -155,3 +207,23 @@ private:
     SCREEN_UI::EventReturn QuitMarley(SCREEN_UI::EventParams &e);
 };
 
+// Shown while an mdf image is converted before launch (startGameConversion()),
+// the game is launched when the conversion succeeded.
+class SCREEN_ConversionScreen : public SCREEN_PopupScreen {
+public:
+    SCREEN_ConversionScreen(std::string label, std::string game) : SCREEN_PopupScreen(label), game_(game) {}
+    ~SCREEN_ConversionScreen();
+    void CreatePopupContents(SCREEN_UI::ViewGroup *parent) override;
+    void update() override;
+
+protected:
+    bool ShowButtons() const override { return false; }
+    void OnCompleted(DialogResult result) override;
+
+private:
+    std::string game_;
+    bool running_ = true;
+    SCREEN_UI::TextView *status_ = nullptr;
+    SCREEN_UI::ProgressBar *progress_ = nullptr;
+};
+
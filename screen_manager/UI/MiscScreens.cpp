@@ -171,6 +171,7 @@ void DrawBackgroundSimple(SCREEN_UIContext &dc, int page) {
         switch(page)
         {
             case SCREEN_DOLPHIN:
+                SCREEN_NativeRequestRender();
                 for (int i = 0; i < QUANTITY_SYMBOLS; i++) {
                     float x = xbase[i] + dc.GetBounds().x;
                     float y = ybase[i] + dc.GetBounds().y + 40 * cosf(i * 7.2f + t * 1.3f);
@@ -180,6 +181,7 @@ void DrawBackgroundSimple(SCREEN_UIContext &dc, int page) {
 
                 break;
             case SCREEN_GENERAL:
+                SCREEN_NativeRequestRender();
                 for (int i = 0; i < QUANTITY_SYMBOLS; i++) {
                     float x = xbase[i] + dc.GetBounds().x;
                     float y = ybase[i] + dc.GetBounds().y + 40 * cosf(i * 7.2f + t * 1.3f);
@@ -192,6 +194,7 @@ void DrawBackgroundSimple(SCREEN_UIContext &dc, int page) {
             case SCREEN_MAIN:
                 {
                     Bounds bounds(0, 0, dp_xres, dp_yres);
+                    SCREEN_NativeRequestRender();
                     
                     //moving clouds
                     float x_clouds = + t*5 - dp_xres*cnt_clouds;
@@ -266,6 +269,8 @@ void DrawBackground(SCREEN_UIContext &dc, float alpha) {
     
     if (gTheme == THEME_RETRO)
     {
+        // the symbols keep moving
+        SCREEN_NativeRequestRender();
         double t = time_now_d();
         for (int i = 0; i < 100; i++) {
             float x = xbase[i] + dc.GetBounds().x;
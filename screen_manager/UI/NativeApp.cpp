@@ -31,6 +31,7 @@
 
 #include <locale.h>
 #include <algorithm>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -62,10 +63,12 @@
 #include "Common/MemArena.h"
 #include "Common/GraphicsContext.h"
 #include "Common/OSVersion.h"
+#include "Common/Profiler/Profiler.h"
 
 #include "UI/MainScreen.h"
 #include "UI/MiscScreens.h"
 #include "UI/OnScreenDisplay.h"
+#include "UI/ProfilerDraw.h"
 #include "UI/TextureUtil.h"
 
 #include "../../include/emu.h"
@@ -87,6 +90,10 @@ std::string SCREEN_config_filename;
 static bool SCREEN_resized = false;
 static bool restarting = false;
 
+// the first frame is always drawn
+static std::atomic<bool> renderRequested(true);
+static double renderUntil = 0.0;
+
 struct PendingMessage {
     std::string msg;
     std::string value;
@@ -270,8 +277,11 @@ bool SCREEN_NativeInitGraphics(SCREEN_GraphicsContext *graphicsContext) {
         uiContext->Text()->SetFont("Tahoma", 20, 0);
 
     SCREEN_screenManager->setUIContext(uiContext);
+    SCREEN_screenManager->setPostRenderCallback(&SCREEN_DrawProfile, nullptr);
     SCREEN_screenManager->setSCREEN_DrawContext(g_draw);
 
+    g_thumbnailCache = new SCREEN_ThumbnailCache();
+
     return true;
 }
 
@@ -320,6 +330,9 @@ void SCREEN_NativeShutdownGraphics() {
     
     SCREEN_UIBackgroundShutdown();
 
+    delete g_thumbnailCache;
+    g_thumbnailCache = nullptr;
+
     delete uiContext;
     uiContext = nullptr;
 
@@ -349,6 +362,12 @@ void SCREEN_NativeRender(SCREEN_GraphicsContext *graphicsContext) {
     SCREEN_ui_draw2d.PushDrawMatrix(ortho);
     SCREEN_ui_draw2d_front.PushDrawMatrix(ortho);
 
+    // box art decoded since the last frame
+    if (g_thumbnailCache) {
+        PROFILE_THIS_SCOPE("SCREEN_ThumbnailCache::Frame", PROFILE_DRAW);
+        g_thumbnailCache->Frame(g_draw);
+    }
+
     // All actual rendering happens in here
     SCREEN_screenManager->render();
     if (SCREEN_screenManager->getUIContext()->Text()) {
@@ -367,6 +386,7 @@ void SCREEN_NativeRender(SCREEN_GraphicsContext *graphicsContext) {
         graphicsContext->Resize();
         SCREEN_screenManager->resized();
         gUpdateCurrentScreen = true;
+        SCREEN_NativeRequestRender();
     }
 
     SCREEN_ui_draw2d.PopDrawMatrix();
@@ -374,11 +394,30 @@ void SCREEN_NativeRender(SCREEN_GraphicsContext *graphicsContext) {
     
 }
 
+void SCREEN_NativeRequestRender(double duration) {
+    if (duration > 0.0) {
+        double until = time_now_d() + duration;
+        if (until > renderUntil)
+            renderUntil = until;
+    }
+    renderRequested = true;
+}
+
+bool SCREEN_NativeIsRenderPending() {
+    return renderRequested || time_now_d() < renderUntil;
+}
+
+bool SCREEN_NativeRenderRequested() {
+    bool requested = renderRequested.exchange(false);
+    return requested || time_now_d() < renderUntil;
+}
+
 void SCREEN_HandleGlobalMessage(const std::string &msg, const std::string &value) {
     
 }
 
 void SCREEN_NativeUpdate() {
+    PROFILE_THIS_SCOPE("SCREEN_NativeUpdate", PROFILE_UPDATE);
 
     std::vector<PendingMessage> toProcess;
     std::vector<PendingInputBox> inputToProcess;
@@ -469,6 +508,7 @@ void SCREEN_wiimoteInput(int button)
             default:
                 break;
         }
+        SCREEN_NativeRequestRender(SCREEN_RENDER_AFTER_INPUT);
     } else
     {
         key.flags = KEY_UP;
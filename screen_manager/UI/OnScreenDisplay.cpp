@@ -24,6 +24,7 @@
 
 #include "Common/UI/Context.h"
 
+#include "Common/System/NativeApp.h"
 #include "Common/TimeUtil.h"
 
 SCREEN_OnScreenMessages osm;
@@ -32,6 +33,9 @@ void SCREEN_OnScreenMessagesView::Draw(SCREEN_UIContext &dc) {
     // First, clean out old messages.
     osm.Lock();
     osm.Clean();
+    // fading out
+    if (!osm.IsEmpty())
+        SCREEN_NativeRequestRender();
 
     // Get height
     float w, h;
@@ -0,0 +1,94 @@
+// Copyright (c) 2013-2020 PPSSPP project
+// Copyright (c) 2020 - 2021 Marley project
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+
+#include "Common/Profiler/Profiler.h"
+#include "Common/Render/DrawBuffer.h"
+#include "Common/System/Display.h"
+#include "Common/UI/Context.h"
+#include "Common/UI/View.h"
+
+#include "UI/ProfilerDraw.h"
+
+#define GRAPH_BAR_WIDTH 3.0f
+#define GRAPH_HEIGHT    150.0f
+#define GRAPH_MAX_MS    50.0f
+#define LEGEND_WIDTH    230.0f
+#define LEGEND_LINE     20.0f
+
+void SCREEN_DrawProfile(SCREEN_UIContext *ui, void *userdata) {
+    if (!SCREEN_ProfilerHUDVisible())
+        return;
+
+    SCREEN_ProfileFrame frames[SCREEN_PROFILE_HISTORY];
+    int count = SCREEN_ProfilerGetFrames(frames, SCREEN_PROFILE_HISTORY);
+
+    float graphWidth = SCREEN_PROFILE_HISTORY * GRAPH_BAR_WIDTH;
+    float left = 10.0f;
+    float bottom = dp_yres - 10.0f;
+    float top = bottom - GRAPH_HEIGHT;
+    float scale = GRAPH_HEIGHT / GRAPH_MAX_MS;
+
+    ui->Begin();
+    SCREEN_DrawBuffer *draw = ui->Draw();
+    draw->Rect(left - 5.0f, top - 5.0f, graphWidth + LEGEND_WIDTH, GRAPH_HEIGHT + 10.0f, 0xB0000000);
+
+    float averageMs[PROFILE_CATEGORY_COUNT] = {};
+    float workMs = 0.0f;
+    float maxWorkMs = 0.0f;
+    for (int i = 0; i < count; i++) {
+        // newest frame on the right
+        float x = left + (SCREEN_PROFILE_HISTORY - count + i) * GRAPH_BAR_WIDTH;
+        float y = bottom;
+        float frameWorkMs = 0.0f;
+        for (int c = 0; c < PROFILE_CATEGORY_COUNT; c++) {
+            float ms = frames[i].categoryMs[c];
+            float h = std::min(ms * scale, y - top);
+            if (h > 0.0f) {
+                draw->Rect(x, y - h, GRAPH_BAR_WIDTH - 1.0f, h, SCREEN_ProfilerCategoryColor((SCREEN_ProfileCategory)c));
+                y -= h;
+            }
+            averageMs[c] += ms;
+            // the swap mostly waits for vsync
+            if (c != PROFILE_SWAP)
+                frameWorkMs += ms;
+        }
+        workMs += frameWorkMs;
+        maxWorkMs = std::max(maxWorkMs, frameWorkMs);
+    }
+
+    // 60 and 30 fps
+    draw->hLine(left, bottom - 1000.0f / 60.0f * scale, left + graphWidth, 0x80FFFFFF);
+    draw->hLine(left, bottom - 1000.0f / 30.0f * scale, left + graphWidth, 0x80FFFFFF);
+
+    char text[64];
+    float x = left + graphWidth + 5.0f;
+    float y = top;
+    ui->SetFontStyle(ui->theme->uiFontSmall);
+    for (int c = 0; c < PROFILE_CATEGORY_COUNT; c++) {
+        snprintf(text, sizeof(text), "%s %.2f ms", SCREEN_ProfilerCategoryName((SCREEN_ProfileCategory)c),
+            count ? averageMs[c] / count : 0.0f);
+        ui->DrawText(text, x, y, SCREEN_ProfilerCategoryColor((SCREEN_ProfileCategory)c), ALIGN_TOPLEFT);
+        y += LEGEND_LINE;
+    }
+    snprintf(text, sizeof(text), "work %.2f ms, max %.2f ms", count ? workMs / count : 0.0f, maxWorkMs);
+    ui->DrawText(text, x, y, 0xFFFFFFFF, ALIGN_TOPLEFT);
+    ui->Flush();
+}
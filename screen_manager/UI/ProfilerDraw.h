@@ -0,0 +1,26 @@
+// Copyright (c) 2013-2020 PPSSPP project
+// Copyright (c) 2020 - 2021 Marley project
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+class SCREEN_UIContext;
+
+// Frame-time graph of the last frames, one stacked bar per frame with the
+// time spent per profiler category. Drawn over the current screen while
+// the profiler HUD is on (F3 or --perf-hud).
+void SCREEN_DrawProfile(SCREEN_UIContext *ui, void *userdata);
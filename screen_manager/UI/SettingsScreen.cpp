@@ -2271,6 +2271,8 @@ void SCREEN_DirBrowser::Update() {
     if (listingPending_ && path_.IsListingReady()) {
         Refresh();
     }
+    if (listingPending_)
+        SCREEN_NativeRequestRender();
 }
 
 void SCREEN_DirBrowser::Draw(SCREEN_UIContext &dc) {
@@ -29,7 +29,10 @@
 #include "Common/Math/math_util.h"
 #include "Common/Math/curves.h"
 #include "Common/File/VFS/VFS.h"
+#include "Common/File/FileUtil.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Common/Log.h"
+#include "Common/System/NativeApp.h"
 #include "Common/TimeUtil.h"
 #include "UI/TextureUtil.h"
 
@@ -223,10 +226,295 @@ std::unique_ptr<SCREEN_ManagedTexture> CreateTextureFromFileData(SCREEN_Draw::SC
     }
 }
 
+SCREEN_ThumbnailCache *g_thumbnailCache;
+
+// Box filter by an integer factor, the result is at most THUMBNAIL_MAX_SIZE wide and high.
+static uint8_t *ShrinkImage(uint8_t *image, int *width, int *height) {
+    int largest = std::max(*width, *height);
+    if (largest <= THUMBNAIL_MAX_SIZE)
+        return image;
+
+    int factor = (largest + THUMBNAIL_MAX_SIZE - 1) / THUMBNAIL_MAX_SIZE;
+    int w = std::max(1, *width / factor);
+    int h = std::max(1, *height / factor);
+    uint8_t *shrunk = (uint8_t *)malloc(w * h * 4);
+    if (!shrunk)
+        return image;
+
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            uint32_t sum[4] = {};
+            for (int sy = 0; sy < factor; sy++) {
+                const uint8_t *src = image + (((y * factor + sy) * *width) + x * factor) * 4;
+                for (int sx = 0; sx < factor * 4; sx++) {
+                    sum[sx & 3] += src[sx];
+                }
+            }
+            for (int c = 0; c < 4; c++) {
+                shrunk[(y * w + x) * 4 + c] = sum[c] / (factor * factor);
+            }
+        }
+    }
+    free(image);
+    *width = w;
+    *height = h;
+    return shrunk;
+}
+
+// reads <game without extension>.png or .zim, nullptr if there is none
+static uint8_t *DecodeThumbnail(const std::string &gamePath, int *width, int *height) {
+    std::string base = gamePath;
+    size_t dot = base.find_last_of('.');
+    if (dot != std::string::npos && dot > base.find_last_of('/'))
+        base = base.substr(0, dot);
+
+    for (const char *extension : { ".png", ".zim" }) {
+        size_t size;
+        uint8_t *data = SCREEN_ReadLocalFile((base + extension).c_str(), &size);
+        if (!data)
+            continue;
+
+        int levelWidth[16]{}, levelHeight[16]{};
+        uint8_t *image[16]{};
+        int num_levels = 0;
+        int zim_flags = 0;
+        SCREEN_Draw::SCREEN_DataFormat fmt;
+        bool success = LoadTextureLevels(data, size, DETECT, levelWidth, levelHeight, &num_levels, &fmt, image, &zim_flags);
+        delete[] data;
+        // only the full size level is used
+        for (int i = 1; i < 16; i++) {
+            if (image[i])
+                free(image[i]);
+        }
+        if (!success || !image[0])
+            continue;
+
+        *width = levelWidth[0];
+        *height = levelHeight[0];
+        return ShrinkImage(image[0], width, height);
+    }
+    return nullptr;
+}
+
+SCREEN_ThumbnailCache::SCREEN_ThumbnailCache(size_t vramBudget) : vramBudget_(vramBudget) {
+    int numWorkers = std::min(4, std::max(1, (int)std::thread::hardware_concurrency() / 2));
+    for (int i = 0; i < numWorkers; i++) {
+        workers_.push_back(std::thread([this] {
+            setCurrentThreadName("Thumbnails");
+            WorkerThread();
+        }));
+    }
+}
+
+SCREEN_ThumbnailCache::~SCREEN_ThumbnailCache() {
+    std::unique_lock<std::mutex> guard(lock_);
+    stop_ = true;
+    wake_.notify_all();
+    guard.unlock();
+
+    for (std::thread &worker : workers_) {
+        worker.join();
+    }
+    Clear();
+}
+
+void SCREEN_ThumbnailCache::WorkerThread() {
+    std::unique_lock<std::mutex> guard(lock_);
+
+    while (!stop_) {
+        if (requests_.empty() || stagingBytes_ >= THUMBNAIL_STAGING_BUDGET) {
+            wake_.wait(guard);
+            continue;
+        }
+
+        // newest first, the ones that scrolled out of sight are dropped
+        std::string gamePath = requests_.back();
+        requests_.pop_back();
+        auto it = thumbnails_.find(gamePath);
+        if (it == thumbnails_.end() || it->second.state != THUMBNAIL_QUEUED)
+            continue;
+        if (it->second.lastFrame < frame_ - 1) {
+            thumbnails_.erase(it);
+            continue;
+        }
+        it->second.state = THUMBNAIL_DECODING;
+        guard.unlock();
+
+        int width = 0, height = 0;
+        uint8_t *pixels = DecodeThumbnail(gamePath, &width, &height);
+
+        guard.lock();
+        // Clear() may have dropped it in the meantime
+        it = thumbnails_.find(gamePath);
+        if (it == thumbnails_.end() || it->second.state != THUMBNAIL_DECODING) {
+            if (pixels)
+                free(pixels);
+            continue;
+        }
+        if (pixels) {
+            it->second.state = THUMBNAIL_DECODED;
+            it->second.pixels = pixels;
+            it->second.width = width;
+            it->second.height = height;
+            it->second.bytes = (size_t)width * height * 4;
+            stagingBytes_ += it->second.bytes;
+            decoded_.push_back(gamePath);
+            SCREEN_NativeRequestRender();
+        } else {
+            SetMissing(it);
+        }
+    }
+}
+
+void SCREEN_ThumbnailCache::SetMissing(std::unordered_map<std::string, Thumbnail>::iterator it) {
+    it->second.state = THUMBNAIL_MISSING;
+    it->second.missingSince = time_now_d();
+    missing_.push_back(std::make_pair(it->second.missingSince, it->first));
+}
+
+SCREEN_Draw::SCREEN_Texture *SCREEN_ThumbnailCache::GetTexture(const std::string &gamePath) {
+    std::lock_guard<std::mutex> guard(lock_);
+
+    auto it = thumbnails_.find(gamePath);
+    if (it == thumbnails_.end()) {
+        Thumbnail &thumbnail = thumbnails_[gamePath];
+        thumbnail.lastFrame = frame_;
+        requests_.push_back(gamePath);
+        wake_.notify_one();
+        return nullptr;
+    }
+
+    Thumbnail &thumbnail = it->second;
+    thumbnail.lastFrame = frame_;
+    if (thumbnail.state != THUMBNAIL_READY)
+        return nullptr;
+    lru_.splice(lru_.begin(), lru_, thumbnail.lru);
+    return thumbnail.texture;
+}
+
+void SCREEN_ThumbnailCache::Evict(std::unordered_map<std::string, Thumbnail>::iterator it) {
+    Thumbnail &thumbnail = it->second;
+    if (thumbnail.texture) {
+        thumbnail.texture->Release();
+        vramBytes_ -= thumbnail.bytes;
+        lru_.erase(thumbnail.lru);
+    }
+    if (thumbnail.pixels) {
+        free(thumbnail.pixels);
+        stagingBytes_ -= thumbnail.bytes;
+    }
+    thumbnails_.erase(it);
+}
+
+// GL thread, once per frame
+void SCREEN_ThumbnailCache::Frame(SCREEN_Draw::SCREEN_DrawContext *draw) {
+    using namespace SCREEN_Draw;
+    std::lock_guard<std::mutex> guard(lock_);
+
+    frame_++;
+
+    // forgotten, so the map does not grow with every folder browsed and artwork added later shows up
+    double now = time_now_d();
+    while (!missing_.empty() && now - missing_.front().first > THUMBNAIL_MISSING_SECONDS) {
+        auto it = thumbnails_.find(missing_.front().second);
+        // an entry missing again since has a newer record
+        if (it != thumbnails_.end() && it->second.state == THUMBNAIL_MISSING && it->second.missingSince == missing_.front().first)
+            Evict(it);
+        missing_.pop_front();
+    }
+
+    int uploads = 0;
+    while (!decoded_.empty() && uploads < THUMBNAIL_UPLOADS_PER_FRAME) {
+        auto it = thumbnails_.find(decoded_.front());
+        decoded_.pop_front();
+        if (it == thumbnails_.end() || it->second.state != THUMBNAIL_DECODED)
+            continue;
+
+        // make room, the ones drawn in the last frame stay
+        Thumbnail &thumbnail = it->second;
+        while (vramBytes_ + thumbnail.bytes > vramBudget_ && !lru_.empty()) {
+            auto oldest = thumbnails_.find(lru_.back());
+            if (oldest->second.lastFrame >= frame_ - 1)
+                break;
+            Evict(oldest);
+        }
+        if (vramBytes_ + thumbnail.bytes > vramBudget_) {
+            // asked for again once it is in sight
+            Evict(it);
+            continue;
+        }
+
+        TextureDesc desc{};
+        desc.type = SCREEN_TextureType::LINEAR2D;
+        desc.format = SCREEN_DataFormat::R8G8B8A8_UNORM;
+        desc.width = thumbnail.width;
+        desc.height = thumbnail.height;
+        desc.depth = 1;
+        desc.mipLevels = 1;
+        desc.generateMips = false;
+        desc.tag = "thumbnail";
+        desc.initData.push_back(thumbnail.pixels);
+        thumbnail.texture = draw->CreateTexture(desc);
+
+        free(thumbnail.pixels);
+        thumbnail.pixels = nullptr;
+        stagingBytes_ -= thumbnail.bytes;
+        uploads++;
+
+        if (!thumbnail.texture) {
+            SetMissing(it);
+            continue;
+        }
+        thumbnail.state = THUMBNAIL_READY;
+        lru_.push_front(it->first);
+        thumbnail.lru = lru_.begin();
+        vramBytes_ += thumbnail.bytes;
+    }
+    // staging buffers were freed, the workers can go on
+    if (uploads)
+        wake_.notify_all();
+    // the rest is uploaded with the next frame
+    if (!decoded_.empty())
+        SCREEN_NativeRequestRender();
+}
+
+// textures are gone with the device, everything is read again
+void SCREEN_ThumbnailCache::Clear() {
+    std::lock_guard<std::mutex> guard(lock_);
+    while (!thumbnails_.empty()) {
+        Evict(thumbnails_.begin());
+    }
+    requests_.clear();
+    decoded_.clear();
+    missing_.clear();
+}
+
 void SCREEN_GameIconView::GetContentDimensions(const SCREEN_UIContext &dc, float &w, float &h) const {
     w = textureWidth_;
     h = textureHeight_;
 }
 
 void SCREEN_GameIconView::Draw(SCREEN_UIContext &dc) {
+    SCREEN_Draw::SCREEN_Texture *texture = g_thumbnailCache ? g_thumbnailCache->GetTexture(gamePath_) : nullptr;
+    if (!texture)
+        return;
+
+    textureWidth_ = texture->Width() * scale_;
+    textureHeight_ = texture->Height() * scale_;
+    DrawThumbnail(dc, texture, bounds_);
+}
+
+// fits the texture into the bounds, the aspect ratio is kept
+void DrawThumbnail(SCREEN_UIContext &dc, SCREEN_Draw::SCREEN_Texture *texture, const Bounds &bounds) {
+    float scale = std::min(bounds.w / texture->Width(), bounds.h / texture->Height());
+    float w = texture->Width() * scale;
+    float h = texture->Height() * scale;
+    float x = bounds.centerX() - w / 2;
+    float y = bounds.centerY() - h / 2;
+
+    dc.Flush();
+    dc.GetSCREEN_DrawContext()->BindTexture(0, texture);
+    dc.Draw()->DrawTexRect(x, y, x + w, y + h, 0, 0, 1, 1, 0xFFFFFFFF);
+    dc.Flush();
+    dc.RebindTexture();
 }
@@ -18,7 +18,15 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/GPU/thin3d.h"
 #include "Common/UI/View.h"
@@ -60,6 +68,70 @@ private:
 std::unique_ptr<SCREEN_ManagedTexture> CreateTextureFromFile(SCREEN_Draw::SCREEN_DrawContext *draw, const char *filename, ImageFileType fileType, bool generateMips);
 std::unique_ptr<SCREEN_ManagedTexture> CreateTextureFromFileData(SCREEN_Draw::SCREEN_DrawContext *draw, const uint8_t *data, int size, ImageFileType fileType, bool generateMips, const char *name);
 
+// Box art of the game browser: <game file name>.png or .zim next to the game.
+// Worker threads read and decode the images (downscaled to THUMBNAIL_MAX_SIZE),
+// the GL thread uploads a few of them per frame (Frame()). The textures are
+// kept in an LRU that never exceeds vramBudget bytes. Games without artwork are
+// remembered for THUMBNAIL_MISSING_SECONDS, then looked up again.
+#define THUMBNAIL_MAX_SIZE          256
+#define THUMBNAIL_VRAM_BUDGET       (48 * 1024 * 1024)
+#define THUMBNAIL_STAGING_BUDGET    (8 * 1024 * 1024)
+#define THUMBNAIL_UPLOADS_PER_FRAME 4
+#define THUMBNAIL_MISSING_SECONDS   10.0
+
+class SCREEN_ThumbnailCache {
+public:
+    SCREEN_ThumbnailCache(size_t vramBudget = THUMBNAIL_VRAM_BUDGET);
+    ~SCREEN_ThumbnailCache();
+
+    // nullptr while the artwork is loading or if there is none
+    SCREEN_Draw::SCREEN_Texture *GetTexture(const std::string &gamePath);
+    void Frame(SCREEN_Draw::SCREEN_DrawContext *draw);
+    void Clear();
+
+private:
+    enum ThumbnailState {
+        THUMBNAIL_QUEUED,
+        THUMBNAIL_DECODING,
+        THUMBNAIL_DECODED,
+        THUMBNAIL_READY,
+        THUMBNAIL_MISSING,
+    };
+    struct Thumbnail {
+        ThumbnailState state = THUMBNAIL_QUEUED;
+        SCREEN_Draw::SCREEN_Texture *texture = nullptr;
+        uint8_t *pixels = nullptr;  // staging buffer while decoded
+        int width = 0;
+        int height = 0;
+        size_t bytes = 0;
+        int lastFrame = 0;          // last frame the thumbnail was asked for
+        double missingSince = 0.0;
+        std::list<std::string>::iterator lru;
+    };
+
+    void WorkerThread();
+    void Evict(std::unordered_map<std::string, Thumbnail>::iterator it);
+    void SetMissing(std::unordered_map<std::string, Thumbnail>::iterator it);
+
+    std::unordered_map<std::string, Thumbnail> thumbnails_;
+    std::list<std::string> lru_;        // uploaded ones, most recently used first
+    std::deque<std::string> requests_;  // newest at the back
+    std::deque<std::string> decoded_;
+    std::deque<std::pair<double, std::string>> missing_;  // since when, oldest first
+    std::vector<std::thread> workers_;
+    std::mutex lock_;
+    std::condition_variable wake_;
+    size_t vramBudget_;
+    size_t vramBytes_ = 0;
+    size_t stagingBytes_ = 0;
+    int frame_ = 0;
+    bool stop_ = false;
+};
+
+extern SCREEN_ThumbnailCache *g_thumbnailCache;
+
+void DrawThumbnail(SCREEN_UIContext &dc, SCREEN_Draw::SCREEN_Texture *texture, const Bounds &bounds);
+
 class SCREEN_GameIconView : public SCREEN_UI::InertView {
 public:
     SCREEN_GameIconView(std::string gamePath, float scale, SCREEN_UI::LayoutParams *layoutParams = 0)
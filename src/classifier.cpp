@@ -0,0 +1,301 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "../include/log.h"
+#include "../include/library.h"
+#include "../include/classifier.h"
+
+// cartridge and disc magic numbers are in the first 512 bytes,
+// a SNES HiROM header behind a 512 byte copier header ends at 0x10200
+#define CLASSIFIER_MAGIC_SIZE   0x200
+#define CLASSIFIER_HEADER_SIZE  0x10200
+#define ISO_SECTOR_SIZE         2048
+#define ISO_MAX_DIR_SECTORS     16
+#define MEDNAFEN_MAX_SIZE       52428800 // less than 50MB must be either mednafen or mupen64plus
+
+typedef struct IsoImage {
+    int fd;
+    off_t sectorSize;   // 2048 (iso), 2352 or 2448 (raw)
+    off_t dataOffset;   // user data within a sector
+} T_IsoImage;
+
+static uint32_t readBE32(const unsigned char* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static uint32_t readLE32(const unsigned char* p)
+{
+    return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | (uint32_t)p[0];
+}
+
+static bool matchAt(const unsigned char* header, size_t length, size_t offset, const void* magic, size_t magicLength)
+{
+    if (offset + magicLength > length) return false;
+    return (memcmp(header + offset, magic, magicLength) == 0);
+}
+
+// internal header: checksum and its complement add up to 0xffff
+static bool isSNESHeader(const unsigned char* header, size_t length, size_t offset)
+{
+    if (offset + 0x20 > length) return false;
+    const unsigned char* h = header + offset;
+    unsigned int complement = h[0x1C] | (h[0x1D] << 8);
+    unsigned int checksum   = h[0x1E] | (h[0x1F] << 8);
+
+    if ((checksum ^ complement) != 0xFFFF) return false;
+    // map mode 0x20 .. 0x3f
+    return ((h[0x15] & 0xE0) == 0x20);
+}
+
+static bool readIsoSector(const T_IsoImage* iso, uint32_t lba, unsigned char* buffer)
+{
+    off_t offset = (off_t)lba * iso->sectorSize + iso->dataOffset;
+    return (pread(iso->fd, buffer, ISO_SECTOR_SIZE, offset) == ISO_SECTOR_SIZE);
+}
+
+// looks for the primary volume descriptor (sector 16) in the header
+static const unsigned char* findIsoPVD(const unsigned char* header, size_t length, T_IsoImage* iso)
+{
+    static const off_t layouts[][2] = {{2048, 0}, {2352, 16}, {2352, 24}, {2448, 16}, {2448, 24}};
+
+    for (const auto& layout : layouts)
+    {
+        size_t offset = 16 * layout[0] + layout[1];
+        if ((offset + ISO_SECTOR_SIZE <= length) && (header[offset] == 1) &&
+            matchAt(header, length, offset + 1, "CD001", 5))
+        {
+            iso->sectorSize = layout[0];
+            iso->dataOffset = layout[1];
+            return header + offset;
+        }
+    }
+    return nullptr;
+}
+
+// searches the root directory for a file name (without ";1")
+static bool findIsoFile(const T_IsoImage* iso, const unsigned char* pvd, const char* name, uint32_t* lba, uint32_t* size)
+{
+    unsigned char sector[ISO_SECTOR_SIZE];
+    const unsigned char* root = pvd + 156;
+    uint32_t rootLba  = readLE32(root + 2);
+    uint32_t rootSize = readLE32(root + 10);
+    uint32_t sectors  = (rootSize + ISO_SECTOR_SIZE - 1) / ISO_SECTOR_SIZE;
+    size_t nameLength = strlen(name);
+
+    if (sectors > ISO_MAX_DIR_SECTORS) sectors = ISO_MAX_DIR_SECTORS;
+
+    for (uint32_t i = 0; i < sectors; i++)
+    {
+        if (!readIsoSector(iso, rootLba + i, sector)) return false;
+
+        size_t pos = 0;
+        while (pos + 33 < ISO_SECTOR_SIZE)
+        {
+            const unsigned char* record = sector + pos;
+            unsigned int recordLength = record[0];
+            unsigned int idLength = record[32];
+
+            // records do not cross sector boundaries
+            if (recordLength == 0) break;
+            if ((pos + recordLength > ISO_SECTOR_SIZE) || (33 + idLength > recordLength)) break;
+
+            if ((idLength >= nameLength) &&
+                (strncasecmp((const char*)record + 33, name, nameLength) == 0) &&
+                ((idLength == nameLength) || (record[33 + nameLength] == ';')))
+            {
+                *lba  = readLE32(record + 2);
+                *size = readLE32(record + 10);
+                return true;
+            }
+            pos += recordLength;
+        }
+    }
+    return false;
+}
+
+static rom_type classifyIso(int fd, const unsigned char* header, size_t length)
+{
+    T_IsoImage iso;
+    const unsigned char* pvd;
+    unsigned char sector[ISO_SECTOR_SIZE + 1];
+    uint32_t lba, size;
+
+    iso.fd = fd;
+    pvd = findIsoPVD(header, length, &iso);
+    if (!pvd) return ROM_UNKNOWN;
+
+    // system identifier
+    if (memcmp(pvd + 8, "PSP GAME", 8) == 0) return ROM_PSP;
+    if (findIsoFile(&iso, pvd, "UMD_DATA.BIN", &lba, &size)) return ROM_PSP;
+
+    if (findIsoFile(&iso, pvd, "SYSTEM.CNF", &lba, &size) && readIsoSector(&iso, lba, sector))
+    {
+        sector[ISO_SECTOR_SIZE] = 0;
+        if (strstr((const char*)sector, "BOOT2")) return ROM_PS2;
+    }
+    return ROM_ISO9660;
+}
+
+static rom_type classifyMagic(const unsigned char* header, size_t length)
+{
+    static const unsigned char N64_Z64[4]       = {0x80, 0x37, 0x12, 0x40};
+    static const unsigned char N64_V64[4]       = {0x37, 0x80, 0x40, 0x12};
+    static const unsigned char N64_N64[4]       = {0x40, 0x12, 0x37, 0x80};
+    static const unsigned char INES[4]          = {'N', 'E', 'S', 0x1A};
+    static const unsigned char GAMEBOY_LOGO[4]  = {0xCE, 0xED, 0x66, 0x66};
+    static const unsigned char GBA_LOGO[4]      = {0x24, 0xFF, 0xAE, 0x51};
+
+    if (length < 4) return ROM_UNKNOWN;
+
+    if (matchAt(header, length, 0, N64_Z64, 4) ||
+        matchAt(header, length, 0, N64_V64, 4) ||
+        matchAt(header, length, 0, N64_N64, 4))
+    {
+        return ROM_N64;
+    }
+    if (matchAt(header, length, 0, INES, 4)) return ROM_NES;
+    if (matchAt(header, length, 0, "WBFS", 4)) return ROM_WII;
+    if ((length >= 0x20) && (readBE32(header + 0x18) == 0x5D1C9EA3)) return ROM_WII;
+    if ((length >= 0x20) && (readBE32(header + 0x1C) == 0xC2339F3D)) return ROM_GAMECUBE;
+
+    // IP.BIN, iso or raw sector
+    if (matchAt(header, length, 0x00, "SEGA SEGASATURN ", 16) ||
+        matchAt(header, length, 0x10, "SEGA SEGASATURN ", 16))
+    {
+        return ROM_SATURN;
+    }
+
+    // "SEGA MEGA DRIVE", "SEGA GENESIS", interleaved smd dump
+    if (matchAt(header, length, 0x100, "SEGA", 4)) return ROM_GENESIS;
+    if ((length >= 0x200) && (header[8] == 0xAA) && (header[9] == 0xBB)) return ROM_GENESIS;
+
+    if (matchAt(header, length, 0x104, GAMEBOY_LOGO, 4)) return ROM_GAMEBOY;
+    if (matchAt(header, length, 0x04, GBA_LOGO, 4)) return ROM_GBA;
+    return ROM_UNKNOWN;
+}
+
+static rom_type classifyImage(int fd, const unsigned char* header, size_t length, off_t fileSize)
+{
+    rom_type type = classifyIso(fd, header, length);
+    if (type != ROM_UNKNOWN) return type;
+
+    size_t copier = ((fileSize % 1024) == 512) ? 512 : 0;
+    if (isSNESHeader(header, length, copier + 0x7FC0) || isSNESHeader(header, length, copier + 0xFFC0))
+    {
+        return ROM_SNES;
+    }
+    return ROM_UNKNOWN;
+}
+
+rom_type classifyRom(const std::string& filename, off_t* size)
+{
+    DEBUG_PRINTF("   rom_type classifyRom(const std::string& filename=%s, off_t* size)\n",filename.c_str());
+    struct stat file_stat;
+    rom_type type = ROM_UNKNOWN;
+    ssize_t length;
+    int fd;
+
+    *size = 0;
+    fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return ROM_UNKNOWN;
+
+    if (fstat(fd, &file_stat) == 0)
+    {
+        *size = file_stat.st_size;
+        std::vector<unsigned char> header(CLASSIFIER_HEADER_SIZE);
+        length = pread(fd, header.data(), CLASSIFIER_MAGIC_SIZE, 0);
+        if (length > 0) type = classifyMagic(header.data(), length);
+
+        // disc images and SNES roms need a larger read
+        if ((type == ROM_UNKNOWN) && (length == CLASSIFIER_MAGIC_SIZE))
+        {
+            length = pread(fd, header.data(), CLASSIFIER_HEADER_SIZE, 0);
+            if (length > 0) type = classifyImage(fd, header.data(), length, file_stat.st_size);
+        }
+    }
+    close(fd);
+    return type;
+}
+
+emulator_target getRomTarget(rom_type type, const std::string& filename, off_t size)
+{
+    switch (type)
+    {
+        case ROM_GAMECUBE:
+        case ROM_WII:
+            return dolphin;
+        case ROM_N64:
+            return mupen64plus;
+        case ROM_NES:
+        case ROM_SNES:
+        case ROM_GENESIS:
+        case ROM_SATURN:
+        case ROM_GAMEBOY:
+        case ROM_GBA:
+            return mednafen;
+        case ROM_PSP:
+            return ppsspp;
+        case ROM_PS2:
+            return pcsx2;
+        default:
+            (void) 0;
+            break;
+    }
+
+    if (size < MEDNAFEN_MAX_SIZE)
+    {
+        std::string ext = filename.substr(filename.find_last_of(".") + 1);
+        if (ext.find("64") != std::string::npos)
+        {
+            return mupen64plus;
+        }
+        return mednafen;
+    }
+    if (type == ROM_ISO9660)
+    {
+        return ppsspp;
+    }
+    return pcsx2;
+}
+
+// emulator target for the library index
+int classifyLibraryFile(const std::string& filename)
+{
+    off_t size;
+    rom_type type = classifyRom(filename, &size);
+
+    if (size == 0) return LIBRARY_TARGET_UNKNOWN;
+    // Saturn games are replaced by a cue file when they are launched
+    if (type == ROM_SATURN) return LIBRARY_TARGET_UNKNOWN;
+    return getRomTarget(type, filename, size);
+}
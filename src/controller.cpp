@@ -21,6 +21,7 @@
    SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
 
 #include "../include/controller.h"
+#include "../include/controllerdb.h"
 #include "../include/gui.h"
 #include "../include/statemachine.h"
 #include "../include/marley.h"
@@ -54,11 +55,14 @@ bool initJoy(void)
     SDL_Init(SDL_INIT_GAMECONTROLLER);
     
     internal_db = gBaseDir + "internaldb.txt";
+    setControllerDB(CONTROLLER_DB_INTERNAL, internal_db);
+    compactControllerDB(CONTROLLER_DB_INTERNAL);
 
     SDL_GameControllerAddMappingsFromFile(internal_db.c_str());
     
     sdl_db = gBaseDir;
     sdl_db += "gamecontrollerdb.txt";
+    setControllerDB(CONTROLLER_DB_PUBLIC, sdl_db);
     if (( access( sdl_db.c_str(), F_OK ) == -1 ))
 	{
 		//file does not exist
@@ -271,13 +275,99 @@ bool checkControllerIsSupported(int i)
     return ok;
 }
 
+// name of the mapping in the controller database, lower case
+static string getMappingName(SDL_GameController* gameCtrl)
+{
+    string str;
+    char *mapping = SDL_GameControllerMapping(gameCtrl);
+    if (mapping) 
+    {
+        str = mapping;
+        SDL_free(mapping);
+        //remove guid
+        str = str.substr(str.find(",")+1,str.length()-(str.find(",")+1));
+        // extract name from db
+        str = str.substr(0,str.find(","));
+        
+        transform(str.begin(), str.end(), str.begin(),
+            [](unsigned char c){ return tolower(c); });
+    }
+    return str;
+}
+
+static bool isDesignated(int instance)
+{
+    for (int designation=0;designation<MAX_GAMEPADS;designation++)
+    {
+        for (int j=0;j<gDesignatedControllers[designation].numberOfDevices;j++)
+        {
+            if (gDesignatedControllers[designation].instance[j] == instance) return true;
+        }
+    }
+    return false;
+}
+
+// A mapping was added at runtime: controllers that SDL
+// did not recognize so far are opened as game controllers.
+static void refreshDesignatedControllers(void)
+{
+    DEBUG_PRINTF("   static void refreshDesignatedControllers(void)\n");
+    for (int designation=0;designation<MAX_GAMEPADS;designation++)
+    {
+        if (gDesignatedControllers[designation].controllerType != CTRL_TYPE_STD) continue;
+        for (int j=0;j<gDesignatedControllers[designation].numberOfDevices;j++)
+        {
+            int instance = gDesignatedControllers[designation].instance[j];
+            if ((instance == -1) || gDesignatedControllers[designation].gameCtrl[j]) continue;
+            
+            for (int k=0;k<SDL_NumJoysticks();k++)
+            {
+                if ((SDL_JoystickGetDeviceInstanceID(k) == instance) && SDL_IsGameController(k))
+                {
+                    gDesignatedControllers[designation].gameCtrl[j] = SDL_GameControllerOpen(k);
+                    break;
+                }
+            }
+            if (gDesignatedControllers[designation].gameCtrl[j])
+            {
+                gDesignatedControllers[designation].nameDB[j] = getMappingName(gDesignatedControllers[designation].gameCtrl[j]);
+                gDesignatedControllers[designation].mappingOK = true;
+            }
+        }
+    }
+    gUpdateMainScreen = true;
+}
+
+// The mapping is appended to the internal db and handed to SDL directly,
+// the joystick subsystem keeps running.
+static bool addMapping(const string& entry)
+{
+    DEBUG_PRINTF("   static bool addMapping(const string& entry=%s)\n",entry.c_str());
+    if (!addControllerMapping(CONTROLLER_DB_INTERNAL, entry)) return false;
+    printf("added to internal db: %s\n",entry.c_str());
+    
+    if (SDL_GameControllerAddMapping(entry.c_str()) == -1)
+    {
+        printf("Warning: SDL could not add mapping: %s\n",SDL_GetError());
+        return false;
+    }
+    refreshDesignatedControllers();
+    return true;
+}
+
 bool openJoy(int i)
 {
     DEBUG_PRINTF("   bool openJoy(int i=%d)\n",i);
     int designation, instance, devPerType;
     int device, numberOfDevices, ctrlType;
     bool mappingOK;
-    char *mapping;
+    Uint64 start = SDL_GetPerformanceCounter();
+    
+    // SDL reports a controller with a mapping twice (joystick and game controller)
+    if ((i<MAX_GAMEPADS_PLUGGED) && isDesignated(SDL_JoystickGetDeviceInstanceID(i)))
+    {
+        return true;
+    }
     
     if (i<MAX_GAMEPADS_PLUGGED)
     {
@@ -342,9 +432,6 @@ bool openJoy(int i)
                                 }
                                 gDesignatedControllers[designation].joy[device] = joy;
                                 gDesignatedControllers[designation].gameCtrl[device] = SDL_GameControllerFromInstanceID(instance);
-                                SDL_JoystickGUID guid = SDL_JoystickGetGUID(joy);
-                                checkMapping(guid, &mappingOK,gDesignatedControllers[designation].name[device]);
-                                gDesignatedControllers[designation].mappingOK = mappingOK;
                                 
                                 ctrlType = gDesignatedControllers[designation].controllerType;
                                 if (gDesignatedControllers[designation].numberOfDevices == devicesPerType[ctrlType])
@@ -352,23 +439,20 @@ bool openJoy(int i)
                                     gNumDesignatedControllers++;
                                 }
                                 
-                                mapping = SDL_GameControllerMapping(gDesignatedControllers[designation].gameCtrl[device]);
-                                if (mapping) 
+                                // a mapping from the closest match is added without
+                                // a restart, see refreshDesignatedControllers()
+                                SDL_JoystickGUID guid = SDL_JoystickGetGUID(joy);
+                                checkMapping(guid, &mappingOK,gDesignatedControllers[designation].name[device]);
+                                gDesignatedControllers[designation].mappingOK = mappingOK;
+                                
+                                if (!gDesignatedControllers[designation].gameCtrl[device] && SDL_IsGameController(i))
                                 {
-                                    string str = mapping;
-                                    SDL_free(mapping);
-                                    //remove guid
-                                    str = str.substr(str.find(",")+1,str.length()-(str.find(",")+1));
-                                    // extract name from db
-                                    str = str.substr(0,str.find(","));
-                                    
-                                    transform(str.begin(), str.end(), str.begin(),
-                                        [](unsigned char c){ return tolower(c); });
-                                    
-                                    gDesignatedControllers[designation].nameDB[device] = str;
+                                    gDesignatedControllers[designation].gameCtrl[device] = SDL_GameControllerOpen(i);
                                 }
+                                gDesignatedControllers[designation].nameDB[device] = getMappingName(gDesignatedControllers[designation].gameCtrl[device]);
                                 
-                                printf("adding to designated controller %i (instance %i)\n",designation,gDesignatedControllers[designation].instance[device]);
+                                printf("adding to designated controller %i (instance %i), ready after %.2f ms\n",designation,gDesignatedControllers[designation].instance[device],
+                                    (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
                                 //cancel loop
                                 designation = MAX_GAMEPADS;
                             }
@@ -406,52 +490,18 @@ bool openJoy(int i)
 
 
 
-bool findGuidInFile(string filename, string text2match, int length, string* lineRet)
-{
-    
-    const char* file = filename.c_str();
-    bool ok = false;
-    string line;
-    string text = text2match.substr(0,length);
-    DEBUG_PRINTF("   bool findGuidInFile(string filename=%s, string text2match=%s, int length=%d, string* lineRet)\n",filename.c_str(),text.c_str(),length);
-    lineRet[0] = "";
-    
-    ifstream fileHandle (file);
-    if (!fileHandle.is_open())
-    {
-        printf("Could not open file: findGuidInFile(%s,%s,%i)\n",filename.c_str(),text2match.c_str(),length);
-    }
-    else 
-    {
-        while ( getline (fileHandle,line) && !ok)
-        {
-            if (line.find(text.c_str()) == 0)
-            {
-                //printf("found!\n");
-                ok = true;
-                lineRet[0]=line;
-            }
-        }
-        fileHandle.close();
-    }
-   
-    return ok;
-}
-
-
 bool checkMapping(SDL_JoystickGUID guid, bool* mappingOK, string name)
 {
     DEBUG_PRINTF("   bool checkMapping(SDL_JoystickGUID guid, bool* mappingOK, string name=%s)\n",name.c_str());
     char guidStr[1024];
-    string line, append, filename;
+    string line, append;
     
     mappingOK[0] = false;
     
     //set up guidStr
     SDL_JoystickGetGUIDString(guid, guidStr, sizeof(guidStr));
     
-    filename = internal_db.c_str();
-    if (findGuidInFile(filename.c_str(), guidStr,32,&line))
+    if (findGuidInDB(CONTROLLER_DB_INTERNAL, guidStr,CONTROLLER_GUID_LENGTH,&line))
     {
         printf("GUID found in internal db\n");
         mappingOK[0] = true;
@@ -460,7 +510,7 @@ bool checkMapping(SDL_JoystickGUID guid, bool* mappingOK, string name)
     {
 
         //check public db
-        mappingOK[0] = findGuidInFile(sdl_db.c_str(), guidStr,32,&line);
+        mappingOK[0] = findGuidInDB(CONTROLLER_DB_PUBLIC, guidStr,CONTROLLER_GUID_LENGTH,&line);
         
         if (mappingOK[0])
         {
@@ -474,7 +524,7 @@ bool checkMapping(SDL_JoystickGUID guid, bool* mappingOK, string name)
             {
                 
                 //search in public db for similar
-                mappingOK[0] = findGuidInFile(sdl_db.c_str(),guidStr,i,&line);
+                mappingOK[0] = findGuidInDB(CONTROLLER_DB_PUBLIC,guidStr,i,&line);
                 
                 if (mappingOK[0])
                 {
@@ -494,23 +544,9 @@ bool checkMapping(SDL_JoystickGUID guid, bool* mappingOK, string name)
                     string entry=guidStr;
                     entry += "," + name + "," + append;
                     
-                    if (addControllerToInternalDB(entry)) 
+                    if (addMapping(entry)) 
                     {
-                        printf("added to internal db: %s\n",entry.c_str());
-                        removeDuplicatesInDB();
-
-                        int ret = SDL_GameControllerAddMappingsFromFile(internal_db.c_str());
-                        if ( ret == -1 )
-                        {
-                            printf( "Warning: Unable to open '%s' (should be ~/.marley/internaldb.txt)\n",internal_db.c_str());
-                        } else
-                        {
-                            mappingOK[0]=true; // now actually ok
-                            // reset SDL 
-                            closeAllJoy();
-                            SDL_QuitSubSystem(SDL_INIT_JOYSTICK|SDL_INIT_GAMECONTROLLER);
-                            initJoy();
-                        }
+                        mappingOK[0]=true; // now actually ok
                     }
                     
                     break;
@@ -739,26 +775,14 @@ void setMapping(void)
     }
     entry +=  ",platform:Linux,";
     
-    if (addControllerToInternalDB(entry)) 
-    {
-        printf("added to internal db: %s\n",entry.c_str());
-    }
+    // SDL applies the mapping to open controllers with this GUID
+    addMapping(entry);
     
-    removeDuplicatesInDB();
-
-    int ret = SDL_GameControllerAddMappingsFromFile(internal_db.c_str());
-    if ( ret == -1 )
-    {
-        printf( "Warning: Unable to open '%s' (should be ~/.marley/internaldb.txt)\n",internal_db.c_str());
-    }
     showTooltipSettingsScreen = "Added as '" + name + "'";
     gUpdateCurrentScreen = true;
     
-    // we're done here: reset everything
+    // we're done here
     resetStatemachine();
-    closeAllJoy();
-    SDL_QuitSubSystem(SDL_INIT_JOYSTICK|SDL_INIT_GAMECONTROLLER);
-    initJoy();
 }
 
 //this function should only be called on a new controller instance
@@ -0,0 +1,274 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "../include/log.h"
+#include "../include/controllerdb.h"
+
+typedef struct ControllerDB {
+    std::string filename;
+    bool loaded;
+    off_t size;
+    time_t mtime_sec;
+    long mtime_nsec;
+    std::vector<std::string> lines;
+    // per prefix length: prefix -> first line in file order (last for a journal)
+    std::unordered_map<std::string, size_t> prefixes[CONTROLLER_GUID_LENGTH + 1];
+    bool indexed[CONTROLLER_GUID_LENGTH + 1];
+    bool journal;           // last line of a GUID wins
+} T_ControllerDB;
+
+static T_ControllerDB gControllerDB[CONTROLLER_DB_COUNT];
+
+static void clearControllerDB(T_ControllerDB* db)
+{
+    db->loaded = false;
+    db->lines.clear();
+    for (int i = 0; i <= CONTROLLER_GUID_LENGTH; i++)
+    {
+        db->prefixes[i].clear();
+        db->indexed[i] = false;
+    }
+}
+
+void setControllerDB(int db, const std::string& filename)
+{
+    DEBUG_PRINTF("   void setControllerDB(int db=%d, const std::string& filename=%s)\n",db,filename.c_str());
+    if ((db < 0) || (db >= CONTROLLER_DB_COUNT)) return;
+    if (gControllerDB[db].filename == filename) return;
+
+    clearControllerDB(&gControllerDB[db]);
+    gControllerDB[db].filename = filename;
+    gControllerDB[db].journal = (db == CONTROLLER_DB_INTERNAL);
+}
+
+static bool statControllerDB(T_ControllerDB* db)
+{
+    struct stat fileStat;
+
+    if (stat(db->filename.c_str(),&fileStat) != 0) return false;
+    db->size       = fileStat.st_size;
+    db->mtime_sec  = fileStat.st_mtim.tv_sec;
+    db->mtime_nsec = fileStat.st_mtim.tv_nsec;
+    return true;
+}
+
+// (re)reads the file if it changed since it was loaded
+static bool loadControllerDB(T_ControllerDB* db)
+{
+    struct stat fileStat;
+    std::string line;
+
+    if (stat(db->filename.c_str(),&fileStat) != 0)
+    {
+        printf("Could not open file: loadControllerDB(%s)\n",db->filename.c_str());
+        clearControllerDB(db);
+        return false;
+    }
+
+    if (db->loaded && (db->size       == fileStat.st_size) &&
+                      (db->mtime_sec  == fileStat.st_mtim.tv_sec) &&
+                      (db->mtime_nsec == fileStat.st_mtim.tv_nsec))
+    {
+        return true;
+    }
+
+    clearControllerDB(db);
+    std::ifstream fileHandle(db->filename);
+    if (!fileHandle.is_open())
+    {
+        printf("Could not open file: loadControllerDB(%s)\n",db->filename.c_str());
+        return false;
+    }
+    while (getline(fileHandle,line))
+    {
+        db->lines.push_back(line);
+    }
+    fileHandle.close();
+
+    db->loaded     = true;
+    db->size       = fileStat.st_size;
+    db->mtime_sec  = fileStat.st_mtim.tv_sec;
+    db->mtime_nsec = fileStat.st_mtim.tv_nsec;
+    return true;
+}
+
+static void indexControllerDB(T_ControllerDB* db, int length)
+{
+    std::unordered_map<std::string, size_t>& prefixes = db->prefixes[length];
+
+    prefixes.reserve(db->lines.size());
+    for (size_t i = 0; i < db->lines.size(); i++)
+    {
+        const std::string& line = db->lines[i];
+        if (line.length() < (size_t) length) continue;
+        if (db->journal)
+        {
+            prefixes[line.substr(0,length)] = i;
+        }
+        else
+        {
+            // emplace keeps the first line with this prefix
+            prefixes.emplace(line.substr(0,length), i);
+        }
+    }
+    db->indexed[length] = true;
+}
+
+// same result as scanning the file for the first line (the last
+// line for a journal) starting with the first 'length' characters of the GUID
+bool findGuidInDB(int db, const std::string& guid, int length, std::string* line)
+{
+    DEBUG_PRINTF("   bool findGuidInDB(int db=%d, const std::string& guid=%s, int length=%d, std::string* line)\n",db,guid.c_str(),length);
+    line[0] = "";
+
+    if ((db < 0) || (db >= CONTROLLER_DB_COUNT)) return false;
+    if ((length <= 0) || (length > CONTROLLER_GUID_LENGTH)) return false;
+    if (guid.length() < (size_t) length) return false;
+
+    T_ControllerDB* controllerDB = &gControllerDB[db];
+    if (!loadControllerDB(controllerDB)) return false;
+    if (!controllerDB->indexed[length]) indexControllerDB(controllerDB, length);
+
+    auto it = controllerDB->prefixes[length].find(guid.substr(0,length));
+    if (it == controllerDB->prefixes[length].end()) return false;
+
+    line[0] = controllerDB->lines[it->second];
+    return true;
+}
+
+// appends one line to the database file and to the index,
+// the file is not read again
+bool addControllerMapping(int db, const std::string& entry)
+{
+    DEBUG_PRINTF("   bool addControllerMapping(int db=%d, const std::string& entry=%s)\n",db,entry.c_str());
+    if ((db < 0) || (db >= CONTROLLER_DB_COUNT)) return false;
+    if (entry.find('\n') != std::string::npos) return false;
+
+    T_ControllerDB* controllerDB = &gControllerDB[db];
+    struct stat fileStat;
+    bool newFile = (stat(controllerDB->filename.c_str(),&fileStat) != 0);
+    if (newFile)
+    {
+        printf("Creating internal game controller database %s\n",controllerDB->filename.c_str());
+        clearControllerDB(controllerDB);
+    }
+    else if (!loadControllerDB(controllerDB))
+    {
+        return false;
+    }
+
+    std::ofstream fileHandle(controllerDB->filename, std::ios_base::app);
+    if (!fileHandle)
+    {
+        printf("Could not write internal game controller database: %s, no entry added\n",controllerDB->filename.c_str());
+        return false;
+    }
+    fileHandle << entry << "\n";
+    fileHandle.close();
+    if (fileHandle.fail())
+    {
+        printf("Could not write internal game controller database: %s, no entry added\n",controllerDB->filename.c_str());
+        // the index does not know what made it to the file
+        clearControllerDB(controllerDB);
+        return false;
+    }
+
+    size_t index = controllerDB->lines.size();
+    controllerDB->lines.push_back(entry);
+    for (int length = 1; length <= CONTROLLER_GUID_LENGTH; length++)
+    {
+        if (!controllerDB->indexed[length] || (entry.length() < (size_t) length)) continue;
+        if (controllerDB->journal)
+        {
+            controllerDB->prefixes[length][entry.substr(0,length)] = index;
+        }
+        else
+        {
+            controllerDB->prefixes[length].emplace(entry.substr(0,length), index);
+        }
+    }
+    controllerDB->loaded = statControllerDB(controllerDB);
+    return true;
+}
+
+// rewrites a journal with the last line of every GUID only,
+// the file is left alone if there is nothing to drop
+bool compactControllerDB(int db)
+{
+    DEBUG_PRINTF("   bool compactControllerDB(int db=%d)\n",db);
+    std::vector<std::string> lines;
+    std::unordered_set<std::string> guids;
+    std::string filename, tmpFilename;
+    struct stat fileStat;
+
+    if ((db < 0) || (db >= CONTROLLER_DB_COUNT)) return false;
+    T_ControllerDB* controllerDB = &gControllerDB[db];
+    if (!controllerDB->journal) return false;
+    // nothing to do before the first mapping was added
+    if (stat(controllerDB->filename.c_str(),&fileStat) != 0) return true;
+    if (!loadControllerDB(controllerDB)) return false;
+
+    for (auto it = controllerDB->lines.rbegin(); it != controllerDB->lines.rend(); it++)
+    {
+        size_t comma = it->find(',');
+        if ((comma != std::string::npos) && !guids.insert(it->substr(0,comma)).second) continue;
+        lines.push_back(*it);
+    }
+    if (lines.size() == controllerDB->lines.size()) return true;
+    std::reverse(lines.begin(), lines.end());
+
+    filename = controllerDB->filename;
+    tmpFilename = filename + ".tmp";
+    std::ofstream fileHandle(tmpFilename, std::ios_base::trunc);
+    if (!fileHandle)
+    {
+        printf("Could not write internal game controller database: %s\n",tmpFilename.c_str());
+        return false;
+    }
+    for (const std::string& line : lines)
+    {
+        fileHandle << line << "\n";
+    }
+    fileHandle.close();
+    if (fileHandle.fail() || (rename(tmpFilename.c_str(), filename.c_str()) != 0))
+    {
+        printf("Could not write internal game controller database: %s\n",filename.c_str());
+        remove(tmpFilename.c_str());
+        return false;
+    }
+
+    printf("Internal game controller database: %lu replaced entries removed\n",controllerDB->lines.size() - lines.size());
+    clearControllerDB(controllerDB);
+    controllerDB->lines = lines;
+    controllerDB->loaded = statControllerDB(controllerDB);
+    return true;
+}
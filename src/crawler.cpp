@@ -0,0 +1,409 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "../include/log.h"
+#include "../include/emu.h"
+#include "../include/crawler.h"
+#include "../include/classifier.h"
+
+typedef struct CrawlerWorker {
+    std::mutex mutex;
+    std::deque<std::string> jobs;   // owner takes from the back, thieves from the front
+    std::thread thread;
+} T_CrawlerWorker;
+
+static T_CrawlerWorker gWorkers[CRAWLER_MAX_THREADS];
+static int gNumWorkers;
+static int gCrawlerMode;
+static std::atomic<int> gPendingJobs;
+static std::atomic<int> gActiveWorkers;
+static std::atomic<bool> gCrawlerCancel;
+static bool gCrawlerStarted = false;
+
+// idle workers sleep until a job is pushed or the last one is done,
+// gJobsPushed is only changed with gIdleMutex held
+static std::mutex gIdleMutex;
+static std::condition_variable gIdleCond;
+static std::atomic<unsigned int> gJobsPushed;
+
+// multiple producer, single consumer queue (D. Vyukov),
+// the workers push, the main thread pops
+static T_CrawlerResult gQueueStub;
+static std::atomic<T_CrawlerResult*> gQueueHead(&gQueueStub);
+static T_CrawlerResult* gQueueTail = &gQueueStub;
+
+static void pushCrawlerResult(T_CrawlerResult* result)
+{
+    result->next.store(nullptr, std::memory_order_relaxed);
+    T_CrawlerResult* prev = gQueueHead.exchange(result, std::memory_order_acq_rel);
+    prev->next.store(result, std::memory_order_release);
+}
+
+T_CrawlerResult* popCrawlerResult(void)
+{
+    T_CrawlerResult* tail = gQueueTail;
+    T_CrawlerResult* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &gQueueStub)
+    {
+        if (next == nullptr) return nullptr;
+        gQueueTail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next)
+    {
+        gQueueTail = next;
+        return tail;
+    }
+    if (tail != gQueueHead.load(std::memory_order_acquire))
+    {
+        // a worker is in the middle of a push
+        return nullptr;
+    }
+    pushCrawlerResult(&gQueueStub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next)
+    {
+        gQueueTail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+static void pushJob(int id, const std::string& directory)
+{
+    gPendingJobs++;
+    {
+        std::lock_guard<std::mutex> lock(gWorkers[id].mutex);
+        gWorkers[id].jobs.push_back(directory);
+    }
+    {
+        std::lock_guard<std::mutex> lock(gIdleMutex);
+        gJobsPushed++;
+    }
+    gIdleCond.notify_one();
+}
+
+static void finishJob(void)
+{
+    if (--gPendingJobs == 0)
+    {
+        // the workers waiting for more jobs can exit
+        std::lock_guard<std::mutex> lock(gIdleMutex);
+        gIdleCond.notify_all();
+    }
+}
+
+static bool popJob(int id, std::string* directory)
+{
+    std::lock_guard<std::mutex> lock(gWorkers[id].mutex);
+    if (gWorkers[id].jobs.empty()) return false;
+    *directory = gWorkers[id].jobs.back();
+    gWorkers[id].jobs.pop_back();
+    return true;
+}
+
+static bool stealJob(int id, std::string* directory)
+{
+    for (int i = 1; i < gNumWorkers; i++)
+    {
+        int victim = (id + i) % gNumWorkers;
+        std::lock_guard<std::mutex> lock(gWorkers[victim].mutex);
+        if (!gWorkers[victim].jobs.empty())
+        {
+            *directory = gWorkers[victim].jobs.front();
+            gWorkers[victim].jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// reads one folder (with trailing slash), an unchanged folder is
+// taken from the library index
+static bool readFolder(const std::string& directory, int mode, const std::atomic<bool>* cancel,
+                       T_LibraryDir* entry, bool* fromLibrary)
+{
+    struct stat dir_stat;
+    struct stat entry_stat;
+    int fd;
+    DIR* dir;
+    struct dirent* ent;
+
+    *fromLibrary = false;
+    if (fstatat(AT_FDCWD, directory.c_str(), &dir_stat, 0) < 0) return false;
+
+    // unchanged folder: take content from library index
+    if (getLibraryDir(directory, &dir_stat, entry))
+    {
+        *fromLibrary = true;
+        return true;
+    }
+
+    // classifications of the previous read are reused for unchanged files
+    T_LibraryDir previous;
+    std::unordered_map<std::string, const T_LibraryFile*> previousFiles;
+    if ((mode & CRAWL_CLASSIFY) && getLibraryDir(directory, nullptr, &previous))
+    {
+        for (const T_LibraryFile& file : previous.files)
+        {
+            previousFiles[file.name] = &file;
+        }
+    }
+
+    entry->mtime_sec  = dir_stat.st_mtim.tv_sec;
+    entry->mtime_nsec = dir_stat.st_mtim.tv_nsec;
+
+    fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    dir = fdopendir(fd);
+    if (dir == nullptr)
+    {
+        close(fd);
+        return false;
+    }
+
+    while (!*cancel && ((ent = readdir(dir)) != nullptr))
+    {
+        const char* name = ent->d_name;
+        if ((strcmp(name, ".") == 0) || (strcmp(name, "..") == 0)) continue;
+
+        // d_type saves a stat call per entry, some file systems do not provide it
+        unsigned char type = ent->d_type;
+        bool haveStat = false;
+        if (type == DT_UNKNOWN)
+        {
+            if (fstatat(fd, name, &entry_stat, AT_SYMLINK_NOFOLLOW) < 0) continue;
+            if (S_ISDIR(entry_stat.st_mode))
+            {
+                type = DT_DIR;
+            }
+            else if (S_ISLNK(entry_stat.st_mode))
+            {
+                type = DT_LNK;
+            }
+            else
+            {
+                type = DT_REG;
+                haveStat = true;
+            }
+        }
+
+        // symbolic links are treated as files (see isDirectory())
+        if (type == DT_DIR)
+        {
+            entry->subdirs.push_back(name);
+            continue;
+        }
+
+        // one stat per file, the size rejects most bios candidates
+        // before any string is built
+        if (!haveStat && (fstatat(fd, name, &entry_stat, 0) < 0)) continue;
+
+        if (isBiosSize(entry_stat.st_size))
+        {
+            T_LibraryFile bios;
+            bios.name   = name;
+            bios.size   = entry_stat.st_size;
+            bios.inode  = 0;
+            bios.target = LIBRARY_TARGET_UNKNOWN;
+            bios.status = LIBRARY_STATUS_NONE;
+            entry->biosFiles.push_back(bios);
+        }
+
+        if (mode & CRAWL_GAMES)
+        {
+            std::string str_with_path = directory + name;
+            std::list<std::string> cueReferences;
+            if (isGameCandidate(str_with_path, &cueReferences))
+            {
+                T_LibraryFile file;
+                file.name   = name;
+                file.size   = entry_stat.st_size;
+                file.inode  = entry_stat.st_ino;
+                file.target = LIBRARY_TARGET_UNKNOWN;
+                file.status = LIBRARY_STATUS_NONE;
+                if (mode & CRAWL_CLASSIFY)
+                {
+                    auto it = previousFiles.find(file.name);
+                    if ((it != previousFiles.end()) && (it->second->target != LIBRARY_TARGET_UNKNOWN) &&
+                        (it->second->size == file.size) && (it->second->inode == file.inode))
+                    {
+                        file.target = it->second->target;
+                        file.status = it->second->status;
+                        file.launch = it->second->launch;
+                    }
+                    else
+                    {
+                        file.target = classifyLibraryFile(str_with_path);
+                    }
+                }
+                entry->files.push_back(file);
+            }
+            for (const std::string& cueReference : cueReferences)
+            {
+                entry->cueReferences.push_back(cueReference);
+            }
+        }
+    }
+    closedir(dir);
+
+    // an aborted folder is incomplete and must not end up in the library index
+    return !*cancel;
+}
+
+static void processDirectory(int id, const std::string& directory)
+{
+    if (gCrawlerCancel) return;
+
+    T_CrawlerResult* result = new T_CrawlerResult;
+    result->directory = directory;
+    if (!readFolder(directory, gCrawlerMode, &gCrawlerCancel, &result->entry, &result->fromLibrary))
+    {
+        delete result;
+        return;
+    }
+    if (gCrawlerMode & CRAWL_RECURSIVE)
+    {
+        for (const std::string& subdir : result->entry.subdirs)
+        {
+            pushJob(id, directory + subdir + "/");
+        }
+    }
+    pushCrawlerResult(result);
+}
+
+static void crawlerThread(int id)
+{
+    std::string directory;
+
+    while (true)
+    {
+        // read before looking for work, a job pushed after this wakes us up below
+        unsigned int jobsPushed = gJobsPushed;
+        if (popJob(id, &directory) || stealJob(id, &directory))
+        {
+            processDirectory(id, directory);
+            finishJob();
+        }
+        else if (gPendingJobs == 0)
+        {
+            break;
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lock(gIdleMutex);
+            gIdleCond.wait(lock, [jobsPushed] { return (gJobsPushed != jobsPushed) || (gPendingJobs == 0); });
+        }
+    }
+    gActiveWorkers--;
+}
+
+bool startCrawler(const std::string& directory, int mode)
+{
+    DEBUG_PRINTF("   bool startCrawler(const std::string& directory=%s, int mode=%d)\n",directory.c_str(),mode);
+    if (gCrawlerStarted) return false;
+
+    gCrawlerMode = mode;
+    gCrawlerCancel = false;
+    gPendingJobs = 0;
+
+    // The workers mostly wait for readdir() and stat() to return,
+    // on network shares more threads than cores pay off.
+    if (mode & CRAWL_RECURSIVE)
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        gNumWorkers = cores * 2;
+        if (gNumWorkers < 4) gNumWorkers = 4;
+        if (gNumWorkers > CRAWLER_MAX_THREADS) gNumWorkers = CRAWLER_MAX_THREADS;
+    }
+    else
+    {
+        gNumWorkers = 1;
+    }
+
+    // load the index before the workers start reading it
+    loadLibraryIndex();
+
+    pushJob(0, directory);
+    gActiveWorkers = gNumWorkers;
+    for (int i = 0; i < gNumWorkers; i++)
+    {
+        gWorkers[i].thread = std::thread(crawlerThread, i);
+    }
+    gCrawlerStarted = true;
+    return true;
+}
+
+bool crawlerBusy(void)
+{
+    return (gActiveWorkers > 0);
+}
+
+bool readLibraryFolder(const std::string& directory, int mode, const std::atomic<bool>* cancel,
+                       T_LibraryDir* entry, bool* fromLibrary)
+{
+    DEBUG_PRINTF("   bool readLibraryFolder(const std::string& directory=%s, int mode=%d, ...)\n",directory.c_str(),mode);
+    loadLibraryIndex();
+    return readFolder(directory, mode, cancel, entry, fromLibrary);
+}
+
+void cancelCrawler(void)
+{
+    gCrawlerCancel = true;
+}
+
+void stopCrawler(void)
+{
+    DEBUG_PRINTF("   void stopCrawler(void)\n");
+    T_CrawlerResult* result;
+
+    if (!gCrawlerStarted) return;
+
+    for (int i = 0; i < gNumWorkers; i++)
+    {
+        if (gWorkers[i].thread.joinable()) gWorkers[i].thread.join();
+        gWorkers[i].jobs.clear();
+    }
+
+    while ((result = popCrawlerResult()) != nullptr)
+    {
+        delete result;
+    }
+    gCrawlerStarted = false;
+}
@@ -41,11 +41,15 @@
 #include "../include/gui.h"
 #include "../include/statemachine.h"
 #include "../include/controller.h"
+#include "../include/library.h"
+#include "../include/crawler.h"
+#include "../include/watcher.h"
+#include "../include/validator.h"
+#include "../include/firmware.h"
 
 #include <gtk/gtk.h>
 
 using namespace std;
-typedef unsigned long long int checksum64;
 
 #define PS1_BIOS_SIZE           524288
 #define SEGA_SATURN_BIOS_SIZE   524288
@@ -92,110 +96,126 @@ bool stopSearchingDuringSplash;
 #define SHOW_OSD_DURING_SPLASH_INFREQUENTLY 1000
 int intervalOSD = SHOW_OSD_DURING_SPLASH_FREQUENTLY;
 
-std::ifstream::pos_type filesize(const char* filename)
+// bios files found by the game search, handed to the firmware checks
+static string gBiosCandidatesPath;
+static std::list<string> gBiosCandidates_ps1;
+static std::list<string> gBiosCandidates_ps2;
+static bool gBiosCandidatesValid = false;
+
+bool isBiosSize(off_t size)
 {
-    DEBUG_PRINTF("   std::ifstream::pos_type filesize(const char* filename = %s)\n",filename);
-    std::ifstream in(filename, std::ifstream::ate | std::ifstream::binary);
-    return in.tellg(); 
+    return ((size == PS1_BIOS_SIZE) || (size == SEGA_SATURN_BIOS_SIZE) || (size == PS2_BIOS_SIZE));
 }
 
-checksum64 calcChecksum(const char * filename)
+// Runs the crawler (see crawler.h) and collects its results. The
+// workers read the folders, the main thread updates the splash screen.
+static void crawlFolders(const char * directory, int mode, std::list<string> *tmpList, std::list<string> *toBeRemoved,
+                         std::list<string> *tmpList_ps1, std::list<string> *tmpList_ps2)
 {
-    DEBUG_PRINTF("   checksum64 calcChecksum(const char * filename = %s)\n",filename);
-    ifstream ifs(filename, ios::binary|ios::ate);
-    ifstream::pos_type pos = ifs.tellg();
-    checksum64 checksum = 0;
-
-    int length = pos;
-
-    char *pChars = new char[length];
-    ifs.seekg(0, ios::beg);
-    ifs.read(pChars, length);
-    
-    for(int i = 0; i < length; i++)
-        checksum += pChars[i] + (pChars[i] ^ 0x55);
+    DEBUG_PRINTF("   static void crawlFolders(const char * directory=%s, int mode=%d, ...)\n",directory,mode);
+    T_CrawlerResult* result;
+    bool done = false;
+    bool idle;
+    string str_with_path_lower_case;
 
-    delete pChars;
-
-    return checksum;
-}
-bool IsBIOS_PCSX2(const char * filename);
-void findAllBiosFiles(const char * directory, std::list<string> *tmpList_ps1, std::list<string> *tmpList_ps2 = nullptr)
-{
     if (stopSearching) return;
-    //DEBUG_PRINTF("   void findAllFiles(const char * directory=%s, std::list<string> *tmpList, std::list<string> *toBeRemoved)\n",directory);
-    findAllFiles_counter++;
-    if (!(findAllFiles_counter % intervalOSD))
-    {
-        if (!splashScreenRunning) intervalOSD = SHOW_OSD_DURING_SPLASH_INFREQUENTLY;
-        string str = "Searching... Folder count: " + to_string(findAllFiles_counter) + ", folder name: "; 
-        str += directory;
-        DEBUG_PRINTF("   %s\n",str.c_str());
-        str += directory;
-        render_splash(str.c_str());
-        
-        event_loop();
-    }
-    
-    DEBUG_PRINTF("   void findAllBiosFiles(const char * directory = %s, std::list<string> *tmpList_ps1, std::list<string> *tmpList_ps2 = nullptr)\n",directory);
-    string str_with_path, str_without_path;
-    string ext, str_with_path_lower_case;
-    DIR *dir;
-    
-    struct dirent *ent;
-    if ((dir = opendir (directory)) != NULL) 
+    // a folder the library watcher is searching is searched again afterwards
+    cancelLibraryRescan();
+    if (!startCrawler(directory,mode)) return;
+
+    while (!done)
     {
-        // search all files and directories in directory
-        while (((ent = readdir (dir)) != NULL) && !stopSearching)
+        // all results are queued once the workers are finished
+        done = !crawlerBusy();
+        idle = true;
+        while ((result = popCrawlerResult()) != nullptr)
         {
-            str_with_path = directory;
-            str_with_path +=ent->d_name;
-            
-            if (isDirectory(str_with_path.c_str()))
+            idle = false;
+            findAllFiles_counter++;
+            if (!(findAllFiles_counter % intervalOSD))
             {
-                str_without_path =ent->d_name;
-                if ((str_without_path != ".") && (str_without_path != ".."))
+                if (!splashScreenRunning) intervalOSD = SHOW_OSD_DURING_SPLASH_INFREQUENTLY;
+                string str = "Searching... Folder count: " + to_string(findAllFiles_counter) + ", folder name: ";
+                str += result->directory;
+                DEBUG_PRINTF("   %s\n",str.c_str());
+                render_splash(str.c_str());
+
+                event_loop();
+            }
+
+            if (mode & CRAWL_GAMES)
+            {
+                for (const T_LibraryFile& file : result->entry.files)
                 {
-                    str_with_path +="/";
-                    findAllBiosFiles(str_with_path.c_str(),tmpList_ps1,tmpList_ps2);
+                    tmpList[0].push_back(result->directory + file.name);
                 }
+                for (const string& cueReference : result->entry.cueReferences)
+                {
+                    toBeRemoved[0].push_back(cueReference);
+                }
+                if (!result->fromLibrary && !stopSearching) setLibraryDir(result->directory,result->entry);
             }
-            else
+
+            if (mode & CRAWL_BIOS)
             {
-                ext = str_with_path.substr(str_with_path.find_last_of(".") + 1);
-                
-                std::transform(ext.begin(), ext.end(), ext.begin(),
-                    [](unsigned char c){ return std::tolower(c); });
-                
-                str_with_path_lower_case=str_with_path;
-                std::transform(str_with_path_lower_case.begin(), str_with_path_lower_case.end(), str_with_path_lower_case.begin(),
-                    [](unsigned char c){ return std::tolower(c); });
-                
-                if ((str_with_path_lower_case.find("battlenet") ==  string::npos) &&\
-                    (str_with_path_lower_case.find("ps3") ==  string::npos) &&\
-                    (str_with_path_lower_case.find("ps4") ==  string::npos) &&\
-                    (str_with_path_lower_case.find("xbox") ==  string::npos))
+                for (const T_LibraryFile& bios : result->entry.biosFiles)
                 {
-                    int file_size = filesize(str_with_path.c_str());
-                    
-                    if ((file_size == PS1_BIOS_SIZE)||(file_size == SEGA_SATURN_BIOS_SIZE))
-                    {
-                        tmpList_ps1[0].push_back(str_with_path);
-                    }
-                    else if (file_size == PS2_BIOS_SIZE)
+                    string str_with_path = result->directory + bios.name;
+                    str_with_path_lower_case = str_with_path;
+                    std::transform(str_with_path_lower_case.begin(), str_with_path_lower_case.end(), str_with_path_lower_case.begin(),
+                        [](unsigned char c){ return std::tolower(c); });
+
+                    if ((str_with_path_lower_case.find("battlenet") ==  string::npos) &&\
+                        (str_with_path_lower_case.find("ps3") ==  string::npos) &&\
+                        (str_with_path_lower_case.find("ps4") ==  string::npos) &&\
+                        (str_with_path_lower_case.find("xbox") ==  string::npos))
                     {
-#ifdef PCSX2
-                        if (IsBIOS_PCSX2(str_with_path.c_str()) && tmpList_ps2)
+                        if ((bios.size == PS1_BIOS_SIZE)||(bios.size == SEGA_SATURN_BIOS_SIZE))
                         {
-                            tmpList_ps2[0].push_back(str_with_path);
+                            tmpList_ps1[0].push_back(str_with_path);
                         }
+                        else if (bios.size == PS2_BIOS_SIZE)
+                        {
+#ifdef PCSX2
+                            if (isBiosPCSX2(str_with_path.c_str()) && tmpList_ps2)
+                            {
+                                tmpList_ps2[0].push_back(str_with_path);
+                            }
 #endif
+                        }
                     }
                 }
             }
+            delete result;
+            if (stopSearching) cancelCrawler();
         }
-        closedir (dir);
-    } 
+        if (idle && !done) SDL_Delay(1);
+    }
+    stopCrawler();
+
+    // the workers finish in any order
+    if (tmpList) tmpList[0].sort();
+    if (tmpList_ps1) tmpList_ps1[0].sort();
+    if (tmpList_ps2) tmpList_ps2[0].sort();
+}
+
+void invalidateBiosCandidates(void)
+{
+    gBiosCandidatesValid = false;
+}
+
+void findAllBiosFiles(const char * directory, std::list<string> *tmpList_ps1, std::list<string> *tmpList_ps2 = nullptr)
+{
+    DEBUG_PRINTF("   void findAllBiosFiles(const char * directory = %s, std::list<string> *tmpList_ps1, std::list<string> *tmpList_ps2 = nullptr)\n",directory);
+
+    // the game folder was already searched for bios files by buildGameList()
+    if (gBiosCandidatesValid && (gBiosCandidatesPath == directory))
+    {
+        tmpList_ps1[0] = gBiosCandidates_ps1;
+        if (tmpList_ps2) tmpList_ps2[0] = gBiosCandidates_ps2;
+        return;
+    }
+    crawlFolders(directory,CRAWL_BIOS | CRAWL_RECURSIVE,nullptr,nullptr,tmpList_ps1,tmpList_ps2);
 }
 
 bool copyFile(const char *SRC, const char* DEST)
@@ -424,6 +444,7 @@ void checkFirmwarePSX(void)
             }
         }
     }    
+    saveFirmwareCache();
     gPS1_firmware = found_jp_ps1 || found_na_ps1 || found_eu_ps1;
     gPS2_firmware = found_jp_ps2 || found_na_ps2 || found_eu_ps2;
     
@@ -574,6 +595,7 @@ void checkFirmwareSEGA_SATURN(void)
             }
         }
     }    
+    saveFirmwareCache();
     gSegaSaturn_firmware = found_jp_sega_saturn || found_na_eu_sega_saturn;
 }
 
@@ -1026,51 +1048,6 @@ bool isDirectory(const char *filename)
     return ok;
 }
 
-void stripList(list<string> *tmpList,list<string> *toBeRemoved)
-{
-    DEBUG_PRINTF("   void stripList(list<string> *tmpList,list<string> *toBeRemoved)\n");
-    list<string>::iterator iteratorTmpList;
-    list<string>::iterator iteratorToBeRemoved;
-    
-    string strRemove, strRemove_no_path, strList, strList_no_path;
-    int i,j;
-    
-    iteratorToBeRemoved = toBeRemoved[0].begin();
-    
-    for (i=0;i<toBeRemoved[0].size();i++)
-    {
-        strRemove = *iteratorToBeRemoved;
-        iteratorToBeRemoved++;
-        iteratorTmpList = tmpList[0].begin();
-        
-        strRemove_no_path = strRemove;
-        if(strRemove_no_path.find("/") != string::npos)
-        {
-            strRemove_no_path = strRemove.substr(strRemove_no_path.find_last_of("/") + 1);
-        }
-        
-        for (j=0;j<tmpList[0].size();j++)
-        {
-            strList = *iteratorTmpList;
-            
-            strList_no_path = strList;
-            if(strList_no_path.find("/") != string::npos)
-            {
-                strList_no_path = strList_no_path.substr(strList_no_path.find_last_of("/") + 1);
-            }
-
-            if ( strRemove_no_path == strList_no_path )
-            {
-                tmpList[0].erase(iteratorTmpList++);
-            }
-            else
-            {
-                iteratorTmpList++;
-            }
-        }
-    }
-}
-
 bool checkForCueFiles(string str_with_path,std::list<string> *toBeRemoved)
 {
     DEBUG_PRINTF("   bool checkForCueFiles(string str_with_path=%s,std::list<string> *toBeRemoved)\n",str_with_path.c_str());
@@ -1111,134 +1088,54 @@ bool checkForCueFiles(string str_with_path,std::list<string> *toBeRemoved)
     return file_exists;
 }
 
-void findAllFiles(const char * directory, std::list<string> *tmpList, std::list<string> *toBeRemoved, bool recursiveSearch=true)
+bool isGameCandidate(const string& str_with_path, std::list<string> *cueReferences)
 {
-    if (stopSearching) return;
-//    DEBUG_PRINTF("   void findAllFiles(const char * directory=%s, std::list<string> *tmpList, std::list<string> *toBeRemoved)\n",directory);
-    findAllFiles_counter++;
-    if (!(findAllFiles_counter % intervalOSD))
-    {
-        if (!splashScreenRunning) intervalOSD = SHOW_OSD_DURING_SPLASH_INFREQUENTLY;
-        string str = "Searching... Folder count: " + to_string(findAllFiles_counter) + ", folder name: ";
-        str += directory;
-        DEBUG_PRINTF("   %s\n",str.c_str());
-        str += directory;
-        render_splash(str.c_str());
-                
-        event_loop();
-    }
-    string str_with_path, str_without_path;
     string ext, str_with_path_lower_case;
-    DIR *dir;
-    
-    struct dirent *ent;
-    if ((dir = opendir (directory)) != NULL) 
+
+    ext = str_with_path.substr(str_with_path.find_last_of(".") + 1);
+
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+        [](unsigned char c){ return std::tolower(c); });
+
+    str_with_path_lower_case=str_with_path;
+    std::transform(str_with_path_lower_case.begin(), str_with_path_lower_case.end(), str_with_path_lower_case.begin(),
+        [](unsigned char c){ return std::tolower(c); });
+
+    for (int i=0;i<gFileTypes.size();i++)
     {
-        // search all files and directories in directory
-        while (((ent = readdir (dir)) != NULL) && !stopSearching)
+        if ((ext == gFileTypes[i])  && \
+            (str_with_path_lower_case.find("battlenet") ==  string::npos) &&\
+            (str_with_path_lower_case.find("ps3") ==  string::npos) &&\
+            (str_with_path_lower_case.find("ps4") ==  string::npos) &&\
+            (str_with_path_lower_case.find("xbox") ==  string::npos) &&\
+            (str_with_path_lower_case.find("bios") ==  string::npos) &&\
+            (str_with_path_lower_case.find("firmware") ==  string::npos))
         {
-            str_with_path = directory;
-            str_with_path +=ent->d_name;
-            
-            if (isDirectory(str_with_path.c_str()) && (recursiveSearch))
+            if (ext == "mdf")
             {
-                str_without_path =ent->d_name;
-                if ((str_without_path != ".") && (str_without_path != ".."))
-                {
-                    str_with_path +="/";
-                    findAllFiles(str_with_path.c_str(),tmpList,toBeRemoved);
-                }
+                string bin_file;
+                bin_file = str_with_path.substr(0,str_with_path.find_last_of(".")) + ".bin";
+                return !exists(bin_file.c_str());
             }
-            else
+            else if (ext == "cue")
             {
-                ext = str_with_path.substr(str_with_path.find_last_of(".") + 1);
-                
-                std::transform(ext.begin(), ext.end(), ext.begin(),
-                    [](unsigned char c){ return std::tolower(c); });
-                
-                str_with_path_lower_case=str_with_path;
-                std::transform(str_with_path_lower_case.begin(), str_with_path_lower_case.end(), str_with_path_lower_case.begin(),
-                    [](unsigned char c){ return std::tolower(c); });
-                
-                for (int i=0;i<gFileTypes.size();i++)
-                {
-                    if ((ext == gFileTypes[i])  && \
-                        (str_with_path_lower_case.find("battlenet") ==  string::npos) &&\
-                        (str_with_path_lower_case.find("ps3") ==  string::npos) &&\
-                        (str_with_path_lower_case.find("ps4") ==  string::npos) &&\
-                        (str_with_path_lower_case.find("xbox") ==  string::npos) &&\
-                        (str_with_path_lower_case.find("bios") ==  string::npos) &&\
-                        (str_with_path_lower_case.find("firmware") ==  string::npos))
-                    {
-                        if (ext == "mdf")
-                        {
-                            string bin_file;
-                            bin_file = str_with_path.substr(0,str_with_path.find_last_of(".")) + ".bin";
-                            if (!exists(bin_file.c_str())) tmpList[0].push_back(str_with_path);
-                        }
-                        else if (ext == "cue")
-                        {
-                            if(checkForCueFiles(str_with_path,toBeRemoved)) 
-                              tmpList[0].push_back(str_with_path);
-                        }
-                        else
-                        {
-                            tmpList[0].push_back(str_with_path);
-                        }
-                    }
-                }
+                return checkForCueFiles(str_with_path,cueReferences);
             }
-        }
-        closedir (dir);
-    } 
-}
-
-bool findInVector(vector<string>* vec, string str)
-{
-    //DEBUG_PRINTF("   bool findInVector(vector<string>* vec, string str=%s)\n",str.c_str());
-    bool ok = false;
-    string element;
-    
-    vector<string>::iterator it;
-    
-    for(it=vec[0].begin();it<vec[0].end();it++)
-    {
-        element = *it;
-        if (element == str)
-        {
-            ok = true;
-            break;
+            return true;
         }
     }
-    return ok;
+    return false;
 }
 
-void finalizeList(std::list<string> *tmpList)
+void findAllFiles(const char * directory, std::list<string> *tmpList, std::list<string> *toBeRemoved, bool recursiveSearch=true)
 {
-    DEBUG_PRINTF("   void finalizeList(std::list<string> *tmpList)\n");
-    list<string>::iterator iteratorTmpList;
-    string strList;
-    
-    iteratorTmpList = tmpList[0].begin();
-    
-    for (int i=0;i<tmpList[0].size();i++)
-    {
-        strList = *iteratorTmpList;
-        if (!findInVector(&gGame,strList)) //avoid duplicates
-        {
-            gGame.push_back(strList);
-        }
-        iteratorTmpList++;
-    }
-    
-    if (!gGame.size())
-    {
-        gGamesFound = false;
-    }
-    else
-    {
-        gGamesFound = true;
-    }
+    DEBUG_PRINTF("   void findAllFiles(const char * directory=%s, std::list<string> *tmpList, std::list<string> *toBeRemoved)\n",directory);
+    int mode = CRAWL_GAMES | CRAWL_CLASSIFY;
+
+    if (recursiveSearch) mode |= CRAWL_RECURSIVE;
+    // folders changed since buildGameList(), its bios files could be outdated
+    gBiosCandidatesValid = false;
+    crawlFolders(directory,mode,tmpList,toBeRemoved,nullptr,nullptr);
 }
 
 void buildGameList(void)
@@ -1247,15 +1144,34 @@ void buildGameList(void)
     std::list<string> tmpList;
     std::list<string> toBeRemoved;
     searchingForGames=true;
-    findAllFiles(gPathToGames.c_str(),&tmpList,&toBeRemoved);
+    // watch first, changes during the search are applied afterwards
+    watchLibraryFolder(gPathToGames);
+    // bios files are collected in the same pass, the firmware checks
+    // for the game folder do not read it again
+    gBiosCandidatesValid = false;
+    gBiosCandidates_ps1.clear();
+    gBiosCandidates_ps2.clear();
+    crawlFolders(gPathToGames.c_str(),CRAWL_GAMES | CRAWL_CLASSIFY | CRAWL_BIOS | CRAWL_RECURSIVE,
+                 &tmpList,&toBeRemoved,&gBiosCandidates_ps1,&gBiosCandidates_ps2);
+    if (!stopSearching)
+    {
+        gBiosCandidatesPath = gPathToGames;
+        gBiosCandidatesValid = true;
+    }
     stripList (&tmpList,&toBeRemoved); // strip cue file entries
     finalizeList(&tmpList);
+    saveLibraryIndex();
     searchingForGames=false;
+    // prepares the games for launching while the user browses
+    if (!stopSearching) startValidator(gGame);
 }
 
 
 void resetSearch(void)
 {
+    stopValidator();
+    stopLibraryWatcher();
+    gBiosCandidatesValid = false;
 
     gPathToFirmwarePS2="";
     found_jp_ps1=false;
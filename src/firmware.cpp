@@ -0,0 +1,243 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "../include/log.h"
+#include "../include/emu.h"
+#include "../include/firmware.h"
+
+#define FIRMWARE_CACHE_FILE     "firmware.db"
+#define FIRMWARE_CACHE_HEADER   "# marley firmware index 1"
+#define CHECKSUM_BLOCK_SIZE     65536
+
+typedef struct FirmwareEntry {
+    off_t size;
+    time_t mtime_sec;
+    long mtime_nsec;
+    bool checksumValid;
+    checksum64 checksum;
+    int pcsx2;              // IsBIOS_PCSX2(), -1 if not checked yet
+} T_FirmwareEntry;
+
+static std::unordered_map<std::string, T_FirmwareEntry> gFirmwareCache;
+static bool gFirmwareCacheLoaded = false;
+static bool gFirmwareCacheDirty = false;
+
+bool IsBIOS_PCSX2(const char * filename);
+
+static bool loadFirmwareCache(void)
+{
+    std::string line, filename;
+
+    if (gFirmwareCacheLoaded) return true;
+    gFirmwareCacheLoaded = true;
+
+    filename = gBaseDir + FIRMWARE_CACHE_FILE;
+    std::ifstream cacheFile(filename);
+    if (!cacheFile.is_open()) return false;
+
+    if (!getline(cacheFile,line) || (line != FIRMWARE_CACHE_HEADER))
+    {
+        printf("Ignoring firmware cache %s (unknown format)\n",filename.c_str());
+        return false;
+    }
+
+    while (getline(cacheFile,line))
+    {
+        T_FirmwareEntry entry;
+        const char* str = line.c_str();
+        char* end;
+
+        entry.size       = strtoll(str,&end,10);
+        entry.mtime_sec  = strtoll(end,&end,10);
+        entry.mtime_nsec = strtol(end,&end,10);
+        entry.checksum   = strtoull(end,&end,10);
+        entry.pcsx2      = strtol(end,&end,10);
+        if (*end != '\t') continue;
+        entry.checksumValid = true;
+        gFirmwareCache[std::string(end + 1)] = entry;
+    }
+    return true;
+}
+
+bool saveFirmwareCache(void)
+{
+    DEBUG_PRINTF("   bool saveFirmwareCache(void)\n");
+    std::string filename, tmpFilename;
+
+    if (!gFirmwareCacheDirty) return true;
+
+    filename = gBaseDir + FIRMWARE_CACHE_FILE;
+    tmpFilename = filename + ".tmp";
+
+    std::ofstream cacheFile(tmpFilename, std::ios_base::trunc);
+    if (!cacheFile)
+    {
+        printf("Could not write firmware cache %s\n",tmpFilename.c_str());
+        return false;
+    }
+
+    cacheFile << FIRMWARE_CACHE_HEADER << "\n";
+    for (auto& it : gFirmwareCache)
+    {
+        const T_FirmwareEntry& entry = it.second;
+        if (!entry.checksumValid) continue;
+        if (it.first.find('\n') != std::string::npos) continue;
+        cacheFile << entry.size << "\t" << entry.mtime_sec << "\t" << entry.mtime_nsec << "\t"
+                  << entry.checksum << "\t" << entry.pcsx2 << "\t" << it.first << "\n";
+    }
+    cacheFile.close();
+
+    if (cacheFile.fail() || (rename(tmpFilename.c_str(), filename.c_str()) != 0))
+    {
+        printf("Could not write firmware cache %s\n",filename.c_str());
+        remove(tmpFilename.c_str());
+        return false;
+    }
+    gFirmwareCacheDirty = false;
+    return true;
+}
+
+// cache entry of a file, a new one if the file changed
+static T_FirmwareEntry* getFirmwareEntry(const char * filename)
+{
+    struct stat file_stat;
+
+    if (stat(filename,&file_stat) != 0) return nullptr;
+    loadFirmwareCache();
+
+    T_FirmwareEntry& entry = gFirmwareCache[filename];
+    if ((entry.size       != file_stat.st_size) ||
+        (entry.mtime_sec  != file_stat.st_mtim.tv_sec) ||
+        (entry.mtime_nsec != file_stat.st_mtim.tv_nsec))
+    {
+        entry.size          = file_stat.st_size;
+        entry.mtime_sec     = file_stat.st_mtim.tv_sec;
+        entry.mtime_nsec    = file_stat.st_mtim.tv_nsec;
+        entry.checksumValid = false;
+        entry.checksum      = 0;
+        entry.pcsx2         = -1;
+    }
+    return &entry;
+}
+
+// Every byte c adds c + (c ^ 0x55) as signed char. 0x55 leaves the sign bit
+// alone, so this is the sum of all bytes plus the sum of all bytes xor 0x55.
+// The inner loop over a block has no dependencies and is vectorized.
+static int64_t checksumBlock(const signed char* data, size_t length)
+{
+    int32_t sum = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        sum += data[i] + (signed char)(data[i] ^ 0x55);
+    }
+    return sum;
+}
+
+static bool streamChecksum(const char * filename, checksum64* checksum)
+{
+    struct stat file_stat;
+    int64_t sum = 0;
+    int fd;
+
+    fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    if ((fstat(fd,&file_stat) != 0) || (file_stat.st_size == 0))
+    {
+        close(fd);
+        *checksum = 0;
+        return (file_stat.st_size == 0);
+    }
+
+    size_t length = file_stat.st_size;
+    void* map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED)
+    {
+        madvise(map, length, MADV_SEQUENTIAL);
+        const signed char* data = (const signed char*) map;
+        for (size_t pos = 0; pos < length; pos += CHECKSUM_BLOCK_SIZE)
+        {
+            size_t block = (length - pos < CHECKSUM_BLOCK_SIZE) ? length - pos : CHECKSUM_BLOCK_SIZE;
+            sum += checksumBlock(data + pos, block);
+        }
+        munmap(map, length);
+    }
+    else
+    {
+        signed char buffer[CHECKSUM_BLOCK_SIZE];
+        ssize_t block;
+        while ((block = read(fd, buffer, CHECKSUM_BLOCK_SIZE)) > 0)
+        {
+            sum += checksumBlock(buffer, block);
+        }
+    }
+    close(fd);
+    *checksum = (checksum64) sum;
+    return true;
+}
+
+checksum64 calcChecksum(const char * filename)
+{
+    DEBUG_PRINTF("   checksum64 calcChecksum(const char * filename = %s)\n",filename);
+    T_FirmwareEntry* entry = getFirmwareEntry(filename);
+
+    if (!entry) return 0;
+    if (!entry->checksumValid)
+    {
+        if (!streamChecksum(filename, &entry->checksum)) return 0;
+        entry->checksumValid = true;
+        gFirmwareCacheDirty = true;
+    }
+    return entry->checksum;
+}
+
+bool isBiosPCSX2(const char * filename)
+{
+    DEBUG_PRINTF("   bool isBiosPCSX2(const char * filename = %s)\n",filename);
+#ifdef PCSX2
+    T_FirmwareEntry* entry = getFirmwareEntry(filename);
+
+    if (!entry) return false;
+    if (entry->pcsx2 < 0)
+    {
+        entry->pcsx2 = IsBIOS_PCSX2(filename) ? 1 : 0;
+        // entries are only saved with a checksum
+        calcChecksum(filename);
+        gFirmwareCacheDirty = true;
+    }
+    return (entry->pcsx2 == 1);
+#else
+    (void) filename;
+    return false;
+#endif
+}
@@ -25,6 +25,8 @@
 #include "../include/statemachine.h"
 #include "../include/controller.h"
 #include "../include/emu.h"
+#include "../include/mediacache.h"
+#include "Common/Profiler/Profiler.h"
 #include <X11/Xlib.h>
 #include <gtk/gtk.h>
 #include "../resources/res.h"
@@ -40,6 +42,7 @@
 void loadConfigEarly(void);
 
 bool splashScreenRunning = true;
+bool gRedraw = true;
 extern bool gStartUp;
 extern bool playSystemSounds;
 
@@ -226,210 +229,89 @@ void hide_or_show_cursor_X11(bool hide)
     XFlush(display);
 }
 
+static const T_MediaFile gMediaFiles[] =
+{
+    {TEX_BACKGROUND,        "/pictures/../pictures/beach.bmp"},
+    {TEX_BARREL,            "/pictures/../pictures/barrel.bmp"},
+    {TEX_PS3,               "/pictures/../pictures/PS3-DualShock.bmp"},
+    {TEX_PS4,               "/pictures/../pictures/PS4-DualShock.bmp"},
+    {TEX_XBOX360,           "/pictures/../pictures/Xbox-360-S-Controller.bmp"},
+    {TEX_WIIMOTE,           "/pictures/../pictures/Wiimote.bmp"},
+    {TEX_GENERIC_CTRL,      "/pictures/../pictures/generic-controller.bmp"},
+    {TEX_RUDDER,            "/pictures/../pictures/rudder.bmp"},
+    {TEX_RUDDER_GREY,       "/pictures/../pictures/rudder_grey.bmp"},
+    {TEX_ICON_PLAY,         "/pictures/../pictures/Play.bmp"},
+    {TEX_ICON_PLAY_IN,      "/pictures/../pictures/Play_inactive.bmp"},
+    {TEX_ICON_SETUP,        "/pictures/../pictures/Setup.bmp"},
+    {TEX_ICON_SETUP_IN,     "/pictures/../pictures/Setup_inactive.bmp"},
+    {TEX_ICON_OFF,          "/pictures/../pictures/Off.bmp"},
+    {TEX_ICON_OFF_IN,       "/pictures/../pictures/Off_inactive.bmp"},
+    {TEX_ICON_NO_CTRL,      "/pictures/../pictures/noController.bmp"},
+    {TEX_ICON_NO_FW_PSX,    "/pictures/../pictures/firmware_PSX.bmp"},
+    {TEX_ICON_NO_GAMES,     "/pictures/../pictures/noGames.bmp"},
+    {TEX_ICON_GAMES_FLR,    "/pictures/../pictures/path_to_games.bmp"},
+    {TEX_ICON_GAMES_FLR_IN, "/pictures/../pictures/path_to_games_inactive.bmp"},
+    {TEX_ICON_FW_FLR,       "/pictures/../pictures/path_to_fw.bmp"},
+    {TEX_ICON_FW_FLR_IN,    "/pictures/../pictures/path_to_fw_inactive.bmp"},
+    {TEX_SNES,              "/pictures/../pictures/SNES-controller.bmp"},
+    {TEX_ICON_SHUTDOWN,     "/pictures/../pictures/shutdown.bmp"},
+    {TEX_ICON_SHUTDOWN_IN,  "/pictures/../pictures/shutdown_inactive.bmp"},
+    {TEX_ICON_CONF,         "/pictures/../pictures/config.bmp"},
+    {TEX_ICON_CONF_IN,      "/pictures/../pictures/config_inactive.bmp"}
+};
+const int NUM_MEDIA_FILES = sizeof(gMediaFiles) / sizeof(gMediaFiles[0]);
+
+static SDL_Surface* loadSurfaceFromFile(string str);
+
 bool loadMedia(void)
 {
     DEBUG_PRINTF("   bool loadMedia(void)\n");
+    SDL_Surface* surfaces[NUM_MEDIA_FILES];
     bool ok = true;
     
-    // background
-    gTextures[TEX_BACKGROUND] = loadTextureFromFile("/pictures/../pictures/beach.bmp");
-    if (!gTextures[TEX_BACKGROUND])
-    {
-        ok = false;
-    }
-    //barrel
-    gTextures[TEX_BARREL] = loadTextureFromFile("/pictures/../pictures/barrel.bmp");
-    if (!gTextures[TEX_BARREL])
-    {
-        ok = false;
-    }
-    
-    //PS3 dualshock
-    gTextures[TEX_PS3] = loadTextureFromFile("/pictures/../pictures/PS3-DualShock.bmp");
-    if (!gTextures[TEX_PS3])
+    // bitmaps packed at the last start, nothing to decode
+    if (loadMediaCache(gRenderer, gMediaFiles, NUM_MEDIA_FILES, gTextures))
     {
-        ok = false;
+        return true;
     }
     
-    //PS4 dualshock
-    gTextures[TEX_PS4] = loadTextureFromFile("/pictures/../pictures/PS4-DualShock.bmp");
-    if (!gTextures[TEX_PS4])
+    for (int i = 0; i < NUM_MEDIA_FILES; i++)
     {
-        ok = false;
-    }
-
-    //XBox 360 controller
-    gTextures[TEX_XBOX360] = loadTextureFromFile("/pictures/../pictures/Xbox-360-S-Controller.bmp");
-    if (!gTextures[TEX_XBOX360])
-    {
-        ok = false;
-    }
-    
-    //Wiimote
-    gTextures[TEX_WIIMOTE] = loadTextureFromFile("/pictures/../pictures/Wiimote.bmp");
-    if (!gTextures[TEX_WIIMOTE])
-    {
-        ok = false;
-    }
-    
-    //Generic controller
-    gTextures[TEX_GENERIC_CTRL] = loadTextureFromFile("/pictures/../pictures/generic-controller.bmp");
-    if (!gTextures[TEX_GENERIC_CTRL])
-    {
-        ok = false;
-    }
-    
-    //rudder to start configuration run
-    gTextures[TEX_RUDDER] = loadTextureFromFile("/pictures/../pictures/rudder.bmp");
-    if (!gTextures[TEX_RUDDER])
-    {
-        ok = false;
-    }
-    
-    //rudder to start configuration run
-    gTextures[TEX_RUDDER_GREY] = loadTextureFromFile("/pictures/../pictures/rudder_grey.bmp");
-    if (!gTextures[TEX_RUDDER_GREY])
-    {
-        ok = false;
-    }
-    
-    //play icon
-    gTextures[TEX_ICON_PLAY] = loadTextureFromFile("/pictures/../pictures/Play.bmp");
-    if (!gTextures[TEX_ICON_PLAY])
-    {
-        ok = false;
-    }
-    
-    //play icon inactive
-    gTextures[TEX_ICON_PLAY_IN] = loadTextureFromFile("/pictures/../pictures/Play_inactive.bmp");
-    if (!gTextures[TEX_ICON_PLAY_IN])
-    {
-        ok = false;
-    }
-    
-    //Setup icon
-    gTextures[TEX_ICON_SETUP] = loadTextureFromFile("/pictures/../pictures/Setup.bmp");
-    if (!gTextures[TEX_ICON_SETUP])
-    {
-        ok = false;
-    }
-    
-    //Setup icon inactive
-    gTextures[TEX_ICON_SETUP_IN] = loadTextureFromFile("/pictures/../pictures/Setup_inactive.bmp");
-    if (!gTextures[TEX_ICON_SETUP_IN])
-    {
-        ok = false;
-    }
-    
-    //Off icon
-    gTextures[TEX_ICON_OFF] = loadTextureFromFile("/pictures/../pictures/Off.bmp");
-    if (!gTextures[TEX_ICON_OFF])
-    {
-        ok = false;
-    }
-    
-    //Off icon inactive
-    gTextures[TEX_ICON_OFF_IN] = loadTextureFromFile("/pictures/../pictures/Off_inactive.bmp");
-    if (!gTextures[TEX_ICON_OFF_IN])
-    {
-        ok = false;
-    }
-    
-    //no controller
-    gTextures[TEX_ICON_NO_CTRL] = loadTextureFromFile("/pictures/../pictures/noController.bmp");
-    if (!gTextures[TEX_ICON_NO_CTRL])
-    {
-        ok = false;
-    }  
-    
-    //no PSX firmware
-    gTextures[TEX_ICON_NO_FW_PSX] = loadTextureFromFile("/pictures/../pictures/firmware_PSX.bmp");
-    if (!gTextures[TEX_ICON_NO_FW_PSX])
-    {
-        ok = false;
-    }
-    
-    //no games
-    gTextures[TEX_ICON_NO_GAMES] = loadTextureFromFile("/pictures/../pictures/noGames.bmp");
-    if (!gTextures[TEX_ICON_NO_GAMES])
-    {
-        ok = false;
-    }
-
-    //games folder
-    gTextures[TEX_ICON_GAMES_FLR] = loadTextureFromFile("/pictures/../pictures/path_to_games.bmp");
-    if (!gTextures[TEX_ICON_GAMES_FLR])
-    {
-        ok = false;
-    }
-    
-    //games folder
-    gTextures[TEX_ICON_GAMES_FLR_IN] = loadTextureFromFile("/pictures/../pictures/path_to_games_inactive.bmp");
-    if (!gTextures[TEX_ICON_GAMES_FLR_IN])
-    {
-        ok = false;
-    }
-    
-    //firmware folder
-    gTextures[TEX_ICON_FW_FLR] = loadTextureFromFile("/pictures/../pictures/path_to_fw.bmp");
-    if (!gTextures[TEX_ICON_FW_FLR])
-    {
-        ok = false;
-    }
-    
-    //firmware folder
-    gTextures[TEX_ICON_FW_FLR_IN] = loadTextureFromFile("/pictures/../pictures/path_to_fw_inactive.bmp");
-    if (!gTextures[TEX_ICON_FW_FLR_IN])
-    {
-        ok = false;
-    }
-    
-    //SNES controller
-    gTextures[TEX_SNES] = loadTextureFromFile("/pictures/../pictures/SNES-controller.bmp");
-    if (!gTextures[TEX_SNES])
-    {
-        ok = false;
-    }
-    
-    //shutdown icon
-    gTextures[TEX_ICON_SHUTDOWN] = loadTextureFromFile("/pictures/../pictures/shutdown.bmp");
-    if (!gTextures[TEX_ICON_SHUTDOWN])
-    {
-        ok = false;
-    }
-    
-    //shutdown icon inactive
-    gTextures[TEX_ICON_SHUTDOWN_IN] = loadTextureFromFile("/pictures/../pictures/shutdown_inactive.bmp");
-    if (!gTextures[TEX_ICON_SHUTDOWN_IN])
-    {
-        ok = false;
+        int texture = gMediaFiles[i].texture;
+        gTextures[texture] = nullptr;
+        surfaces[i] = loadSurfaceFromFile(gMediaFiles[i].resource);
+        if (surfaces[i])
+        {
+            gTextures[texture] = SDL_CreateTextureFromSurface(gRenderer,surfaces[i]);
+            if (!gTextures[texture])
+            {
+                printf("texture for %s could not be created.\n",gMediaFiles[i].resource);
+            }
+        }
+        if (!gTextures[texture])
+        {
+            ok = false;
+        }
     }
     
-    //config icon
-    gTextures[TEX_ICON_CONF] = loadTextureFromFile("/pictures/../pictures/config.bmp");
-    if (!gTextures[TEX_ICON_CONF])
+    if (ok)
     {
-        ok = false;
+        saveMediaCache(gMediaFiles, NUM_MEDIA_FILES, surfaces);
     }
-    
-    //config icon inactive
-    gTextures[TEX_ICON_CONF_IN] = loadTextureFromFile("/pictures/../pictures/config_inactive.bmp");
-    if (!gTextures[TEX_ICON_CONF_IN])
+    for (int i = 0; i < NUM_MEDIA_FILES; i++)
     {
-        ok = false;
+        if (surfaces[i]) SDL_FreeSurface(surfaces[i]);
     }
-
-    
-    
     return ok;
 }
 
 bool freeTextures(void)
 {
     DEBUG_PRINTF("   bool freeTextures(void)\n");
-    for (int i;i<NUM_TEXTURES;i++)
+    for (int i=0;i<NUM_TEXTURES;i++)
     {
-        SDL_DestroyTexture(gTextures[i]);
+        if (gTextures[i]) SDL_DestroyTexture(gTextures[i]);
+        gTextures[i] = nullptr;
     }
     return true;
 }
@@ -466,11 +348,9 @@ void setAppIcon(void)
 	}
 }
 
-SDL_Texture* loadTextureFromFile(string str)
+static SDL_Surface* loadSurfaceFromFile(string str)
 {
-    //DEBUG_PRINTF("   SDL_Texture* loadTextureFromFile(string str=%s)\n",str.c_str());
     SDL_Surface* surf = nullptr;
-    SDL_Texture* texture = nullptr;
     
     size_t file_size = 0;
     
@@ -486,21 +366,31 @@ SDL_Texture* loadTextureFromFile(string str)
 		{
 			printf("File %s could not be loaded\n",str.c_str());
 		}
-		else
-		{
-			texture =SDL_CreateTextureFromSurface(gRenderer,surf);
-			if (!texture)
-			{
-				printf("texture for background could not be created.\n");
-			}
-			SDL_FreeSurface(surf);
-		}
 	}
 	else
 	{
 		printf("Failed to retrieve resource data for %s\n",str.c_str());
 	}
-	return texture;
+	return surf;
+}
+
+SDL_Texture* loadTextureFromFile(string str)
+{
+    //DEBUG_PRINTF("   SDL_Texture* loadTextureFromFile(string str=%s)\n",str.c_str());
+    SDL_Surface* surf = nullptr;
+    SDL_Texture* texture = nullptr;
+    
+    surf = loadSurfaceFromFile(str);
+    if (surf)
+    {
+        texture =SDL_CreateTextureFromSurface(gRenderer,surf);
+        if (!texture)
+        {
+            printf("texture for background could not be created.\n");
+        }
+        SDL_FreeSurface(surf);
+    }
+    return texture;
 }
 
 SDL_Texture* loadTextureFromFile_disk(string str)
@@ -682,6 +572,7 @@ void closeGUI(void)
     
 void renderIcons(void)
 {
+    PROFILE_THIS_SCOPE("renderIcons", PROFILE_DRAW);
     //render destination 
     SDL_Rect destination;
     SDL_Surface* surfaceMessage = nullptr; 
@@ -770,6 +661,14 @@ void renderIcons(void)
                 SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 200);
                 SDL_RenderFillRect(gRenderer, &destination);
                 
+                // an mdf image being converted before launch
+                if (gConversionPercent >= 0)
+                {
+                    destination.w = destination.w * gConversionPercent / 100;
+                    SDL_SetRenderDrawColor(gRenderer, 60, 22, 55, 200);
+                    SDL_RenderFillRect(gRenderer, &destination);
+                }
+                
                 if(gGame[gCurrentGame].find("/") != string::npos)
                 {
                     name_short = gGame[gCurrentGame].substr(gGame[gCurrentGame].find_last_of("/") + 1);
@@ -789,6 +688,11 @@ void renderIcons(void)
                     name_short = name_short.substr(0,58);
                 }
                 
+                if (gConversionPercent >= 0)
+                {
+                    name_short = "Converting " + name_short.substr(0,38) + "... " + to_string(gConversionPercent) + "%";
+                }
+                
                 if (gState == STATE_LAUNCH)
                 {
                     surfaceMessage = TTF_RenderText_Solid(gFont, name_short.c_str(), active); 
@@ -991,6 +895,7 @@ bool createRenderer(void)
         //draw background to main window
         //SDL_RenderCopy(gRenderer,gTextures[TEX_BACKGROUND],nullptr,nullptr);
         SDL_RenderPresent(gRenderer);
+        gRedraw = true;
     }
     
     
@@ -1023,8 +928,111 @@ bool restoreGUI(void)
     return ok;
 }
     
-void renderScreen(void)
+// frame-time graph of the profiler (F3 or --perf-hud), one stacked bar per frame
+static void renderProfilerHUD(void)
+{
+    const int barWidth = 3;
+    const int graphHeight = 150;
+    const float graphMaxMs = 50.0f;
+    const float scale = graphHeight / graphMaxMs;
+    SCREEN_ProfileFrame frames[SCREEN_PROFILE_HISTORY];
+    SDL_Rect destination;
+    char text[64];
+    
+    if (!SCREEN_ProfilerHUDVisible()) return;
+    int count = SCREEN_ProfilerGetFrames(frames, SCREEN_PROFILE_HISTORY);
+    
+    int left = 10 + xOffset;
+    int bottom = WINDOW_HEIGHT - 10 + yOffset;
+    int top = bottom - graphHeight;
+    int graphWidth = SCREEN_PROFILE_HISTORY * barWidth;
+    
+    destination = { left - 5, top - 5, graphWidth + 240, graphHeight + 10 };
+    SDL_SetRenderDrawColor(gRenderer, 0, 0, 0, 176);
+    SDL_RenderFillRect(gRenderer, &destination);
+    
+    float averageMs[PROFILE_CATEGORY_COUNT] = {};
+    float workMs = 0.0f;
+    float maxWorkMs = 0.0f;
+    for (int i = 0; i < count; i++)
+    {
+        // newest frame on the right
+        int x = left + (SCREEN_PROFILE_HISTORY - count + i) * barWidth;
+        int y = bottom;
+        float frameWorkMs = 0.0f;
+        for (int c = 0; c < PROFILE_CATEGORY_COUNT; c++)
+        {
+            float ms = frames[i].categoryMs[c];
+            int height = (int)(ms * scale);
+            if (height > y - top) height = y - top;
+            if (height > 0)
+            {
+                uint32_t color = SCREEN_ProfilerCategoryColor((SCREEN_ProfileCategory)c);
+                SDL_SetRenderDrawColor(gRenderer, color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF, 255);
+                destination = { x, y - height, barWidth - 1, height };
+                SDL_RenderFillRect(gRenderer, &destination);
+                y -= height;
+            }
+            averageMs[c] += ms;
+            // the present mostly waits for vsync
+            if (c != PROFILE_SWAP) frameWorkMs += ms;
+        }
+        workMs += frameWorkMs;
+        if (frameWorkMs > maxWorkMs) maxWorkMs = frameWorkMs;
+    }
+    
+    // 60 and 30 fps
+    SDL_SetRenderDrawColor(gRenderer, 255, 255, 255, 128);
+    SDL_RenderDrawLine(gRenderer, left, bottom - (int)(1000.0f / 60.0f * scale), left + graphWidth, bottom - (int)(1000.0f / 60.0f * scale));
+    SDL_RenderDrawLine(gRenderer, left, bottom - (int)(1000.0f / 30.0f * scale), left + graphWidth, bottom - (int)(1000.0f / 30.0f * scale));
+    
+    int y = top;
+    for (int c = 0; c <= PROFILE_CATEGORY_COUNT; c++)
+    {
+        SDL_Color color = {255, 255, 255};
+        if (c < PROFILE_CATEGORY_COUNT)
+        {
+            uint32_t categoryColor = SCREEN_ProfilerCategoryColor((SCREEN_ProfileCategory)c);
+            color = { (Uint8)(categoryColor & 0xFF), (Uint8)((categoryColor >> 8) & 0xFF), (Uint8)((categoryColor >> 16) & 0xFF) };
+            snprintf(text, sizeof(text), "%s %.2f ms", SCREEN_ProfilerCategoryName((SCREEN_ProfileCategory)c),
+                count ? averageMs[c] / count : 0.0f);
+        }
+        else
+        {
+            snprintf(text, sizeof(text), "work %.2f ms, max %.2f ms", count ? workMs / count : 0.0f, maxWorkMs);
+        }
+        SDL_Surface* surfaceMessage = TTF_RenderText_Solid(gFont, text, color);
+        if (!surfaceMessage) continue;
+        SDL_Texture* message = SDL_CreateTextureFromSurface(gRenderer, surfaceMessage);
+        destination = { left + graphWidth + 5, y, surfaceMessage->w * 3 / 4, surfaceMessage->h * 3 / 4 };
+        SDL_RenderCopy(gRenderer, message, nullptr, &destination);
+        y += destination.h;
+        SDL_DestroyTexture(message);
+        SDL_FreeSurface(surfaceMessage);
+    }
+}
+
+// checkType() only runs when a designated controller changed
+static int getControllerTexture(int designatedCtrl)
+{
+    static string name[2];
+    static string nameDB[2];
+    static int ctrlTex[2];  // TEX_BACKGROUND: not checked yet
+    
+    if ((gDesignatedControllers[designatedCtrl].name[0] != name[designatedCtrl]) ||
+        (gDesignatedControllers[designatedCtrl].nameDB[0] != nameDB[designatedCtrl]) ||
+        (ctrlTex[designatedCtrl] == TEX_BACKGROUND))
+    {
+        name[designatedCtrl]    = gDesignatedControllers[designatedCtrl].name[0];
+        nameDB[designatedCtrl]  = gDesignatedControllers[designatedCtrl].nameDB[0];
+        ctrlTex[designatedCtrl] = checkType(name[designatedCtrl],nameDB[designatedCtrl]);
+    }
+    return ctrlTex[designatedCtrl];
+}
+
+static void renderScene(void)
 {
+    PROFILE_THIS_SCOPE("renderScene", PROFILE_DRAW);
     //render destination 
     SDL_Rect destination;
     
@@ -1037,10 +1045,6 @@ void renderScreen(void)
     //designated controller 0: Load image and render to screen
     if (gDesignatedControllers[0].numberOfDevices != 0)
     {
-        string name = gDesignatedControllers[0].name[0];
-        string nameDB = gDesignatedControllers[0].nameDB[0];
-        string str;
-        
         if (gSetupIsRunning)
         {
             destination = { x_offset_50+xOffset, y_offset_140+yOffset, x_offset_720, y_offset_200 };
@@ -1082,7 +1086,7 @@ void renderScreen(void)
             }
         }
         
-        ctrlTex = checkType(name,nameDB);
+        ctrlTex = getControllerTexture(0);
         
         destination = { x_offset_900+xOffset, y_offset_130+yOffset, x_offset_250, y_offset_250 };
         SDL_RenderCopyEx( gRenderer, gTextures[ctrlTex], nullptr, &destination, 0, nullptr, SDL_FLIP_NONE );
@@ -1091,11 +1095,6 @@ void renderScreen(void)
     //designated controller 1: load image and render to screen
     if (gDesignatedControllers[1].numberOfDevices != 0)
     {
-        string str;
-        string name = gDesignatedControllers[1].name[0];
-        string nameDB = gDesignatedControllers[1].nameDB[0];
-        ctrlTex = TEX_GENERIC_CTRL;
-        
         if (gSetupIsRunning)
         {
             
@@ -1139,14 +1138,24 @@ void renderScreen(void)
             }
         }
         
-        ctrlTex = checkType(name,nameDB);
+        ctrlTex = getControllerTexture(1);
         
         destination = { x_offset_900+xOffset, y_offset_370+yOffset, x_offset_250, y_offset_250 };
         SDL_RenderCopyEx( gRenderer, gTextures[ctrlTex], nullptr, &destination, 0, nullptr, SDL_FLIP_NONE );
     }
     renderIcons();
-    SDL_RenderPresent( gRenderer );
+}
 
+void renderScreen(void)
+{
+    renderScene();
+    renderProfilerHUD();
+    {
+        // SDL batches the draw calls, they are submitted here
+        PROFILE_THIS_SCOPE("SDL_RenderPresent", PROFILE_SWAP);
+        SDL_RenderPresent( gRenderer );
+    }
+    SCREEN_ProfilerEndFrame();
 }
 void restartGUI(void)
 {
@@ -0,0 +1,491 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <string_view>
+#include <list>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "../include/log.h"
+#include "../include/emu.h"
+#include "../include/statemachine.h"
+#include "../include/library.h"
+
+#define LIBRARY_INDEX_FILE      "library.db"
+#define LIBRARY_INDEX_HEADER    "# marley library index 3"
+// without validation status and launch file, still read
+#define LIBRARY_INDEX_HEADER_2  "# marley library index 2"
+
+std::unordered_map<std::string, T_LibraryDir> gLibrary;
+bool gLibraryLoaded = false;
+bool gLibraryDirty = false;
+// the crawler threads read the index while the main thread updates it
+std::mutex gLibraryMutex;
+
+static std::string nextField(const std::string& line, size_t* pos)
+{
+    size_t end = line.find('\t', *pos);
+    std::string field;
+
+    if (end == std::string::npos)
+    {
+        field = line.substr(*pos);
+        *pos = line.length();
+    }
+    else
+    {
+        field = line.substr(*pos, end - *pos);
+        *pos = end + 1;
+    }
+    return field;
+}
+
+static bool loadLibraryIndexLocked(void)
+{
+    std::string line, filename;
+    T_LibraryDir* currentDir = nullptr;
+    size_t pos;
+    bool version2;
+
+    if (gLibraryLoaded) return true;
+    gLibraryLoaded = true;
+    gLibraryDirty = false;
+    gLibrary.clear();
+
+    filename = gBaseDir + LIBRARY_INDEX_FILE;
+    std::ifstream libraryFile(filename);
+    if (!libraryFile.is_open())
+    {
+        return false;
+    }
+
+    if (!getline(libraryFile,line) || ((line != LIBRARY_INDEX_HEADER) && (line != LIBRARY_INDEX_HEADER_2)))
+    {
+        printf("Ignoring library index %s (unknown format)\n",filename.c_str());
+        return false;
+    }
+    version2 = (line == LIBRARY_INDEX_HEADER_2);
+
+    while (getline(libraryFile,line))
+    {
+        if (line.length() < 2) continue;
+        pos = 2;
+        switch (line[0])
+        {
+            case 'D':
+            {
+                T_LibraryDir entry;
+                entry.mtime_sec  = strtoll(nextField(line,&pos).c_str(),nullptr,10);
+                entry.mtime_nsec = strtol(nextField(line,&pos).c_str(),nullptr,10);
+                currentDir = &gLibrary[line.substr(pos)];
+                *currentDir = entry;
+                break;
+            }
+            case 'S':
+                if (currentDir) currentDir->subdirs.push_back(line.substr(pos));
+                break;
+            case 'G':
+                if (currentDir)
+                {
+                    T_LibraryFile file;
+                    file.size   = strtoll(nextField(line,&pos).c_str(),nullptr,10);
+                    file.inode  = strtoull(nextField(line,&pos).c_str(),nullptr,10);
+                    file.target = atoi(nextField(line,&pos).c_str());
+                    file.status = LIBRARY_STATUS_NONE;
+                    if (!version2)
+                    {
+                        file.status = atoi(nextField(line,&pos).c_str());
+                        file.launch = nextField(line,&pos);
+                    }
+                    file.name   = line.substr(pos);
+                    currentDir->files.push_back(file);
+                }
+                break;
+            case 'C':
+                if (currentDir) currentDir->cueReferences.push_back(line.substr(pos));
+                break;
+            case 'B':
+                if (currentDir)
+                {
+                    T_LibraryFile file;
+                    file.size   = strtoll(nextField(line,&pos).c_str(),nullptr,10);
+                    file.inode  = 0;
+                    file.target = LIBRARY_TARGET_UNKNOWN;
+                    file.status = LIBRARY_STATUS_NONE;
+                    file.name   = line.substr(pos);
+                    currentDir->biosFiles.push_back(file);
+                }
+                break;
+            default:
+                (void) 0;
+                break;
+        }
+    }
+    libraryFile.close();
+    printf("Library index loaded: %lu folders\n",gLibrary.size());
+    return true;
+}
+
+bool loadLibraryIndex(void)
+{
+    DEBUG_PRINTF("   bool loadLibraryIndex(void)\n");
+    std::lock_guard<std::mutex> lock(gLibraryMutex);
+    return loadLibraryIndexLocked();
+}
+
+static bool saveLibraryIndexLocked(void)
+{
+    std::string filename, tmpFilename;
+
+    if (!gLibraryDirty) return true;
+
+    filename = gBaseDir + LIBRARY_INDEX_FILE;
+    tmpFilename = filename + ".tmp";
+
+    std::ofstream libraryFile(tmpFilename, std::ios_base::trunc);
+    if (!libraryFile)
+    {
+        printf("Could not write library index %s\n",tmpFilename.c_str());
+        return false;
+    }
+
+    libraryFile << LIBRARY_INDEX_HEADER << "\n";
+    for (auto& it : gLibrary)
+    {
+        const T_LibraryDir& dir = it.second;
+
+        libraryFile << "D\t" << dir.mtime_sec << "\t" << dir.mtime_nsec << "\t" << it.first << "\n";
+        for (const std::string& subdir : dir.subdirs)
+        {
+            libraryFile << "S\t" << subdir << "\n";
+        }
+        for (const T_LibraryFile& file : dir.files)
+        {
+            libraryFile << "G\t" << file.size << "\t" << file.inode << "\t" << file.target << "\t"
+                        << file.status << "\t" << file.launch << "\t" << file.name << "\n";
+        }
+        for (const std::string& cueReference : dir.cueReferences)
+        {
+            libraryFile << "C\t" << cueReference << "\n";
+        }
+        for (const T_LibraryFile& file : dir.biosFiles)
+        {
+            libraryFile << "B\t" << file.size << "\t" << file.name << "\n";
+        }
+    }
+    libraryFile.close();
+
+    if (libraryFile.fail() || (rename(tmpFilename.c_str(), filename.c_str()) != 0))
+    {
+        printf("Could not write library index %s\n",filename.c_str());
+        remove(tmpFilename.c_str());
+        return false;
+    }
+    gLibraryDirty = false;
+    return true;
+}
+
+bool saveLibraryIndex(void)
+{
+    DEBUG_PRINTF("   bool saveLibraryIndex(void)\n");
+    std::lock_guard<std::mutex> lock(gLibraryMutex);
+    return saveLibraryIndexLocked();
+}
+
+bool getLibraryDir(const std::string& directory, const struct stat* dirStat, T_LibraryDir* entry)
+{
+    std::lock_guard<std::mutex> lock(gLibraryMutex);
+    if (!gLibraryLoaded) loadLibraryIndexLocked();
+
+    auto it = gLibrary.find(directory);
+    if (it == gLibrary.end()) return false;
+
+    // without dirStat, the entry is returned even if it is outdated
+    if (dirStat && ((it->second.mtime_sec  != dirStat->st_mtim.tv_sec) ||
+                    (it->second.mtime_nsec != dirStat->st_mtim.tv_nsec)))
+    {
+        return false;
+    }
+    *entry = it->second;
+    return true;
+}
+
+static void removeLibraryTree(const std::string& directory)
+{
+    auto it = gLibrary.find(directory);
+    if (it == gLibrary.end()) return;
+
+    std::vector<std::string> subdirs = it->second.subdirs;
+    gLibrary.erase(it);
+    for (const std::string& subdir : subdirs)
+    {
+        removeLibraryTree(directory + subdir + "/");
+    }
+}
+
+void setLibraryDir(const std::string& directory, const T_LibraryDir& entry)
+{
+    std::lock_guard<std::mutex> lock(gLibraryMutex);
+    if (!gLibraryLoaded) loadLibraryIndexLocked();
+
+    // names with line breaks cannot be stored in the index,
+    // such folders are read every time
+    if (directory.find('\n') != std::string::npos) return;
+    for (const std::string& subdir : entry.subdirs)
+        if (subdir.find('\n') != std::string::npos) return;
+    for (const T_LibraryFile& file : entry.files)
+        if ((file.name.find('\n') != std::string::npos) || (file.launch.find_first_of("\t\n") != std::string::npos)) return;
+    for (const std::string& cueReference : entry.cueReferences)
+        if (cueReference.find('\n') != std::string::npos) return;
+    for (const T_LibraryFile& file : entry.biosFiles)
+        if (file.name.find('\n') != std::string::npos) return;
+
+    T_LibraryDir newEntry = entry;
+
+    // folders that disappeared from this directory
+    // are dropped from the index including their content
+    auto it = gLibrary.find(directory);
+    if (it != gLibrary.end())
+    {
+        std::vector<std::string> oldSubdirs = it->second.subdirs;
+        for (const std::string& oldSubdir : oldSubdirs)
+        {
+            bool found = false;
+            for (const std::string& subdir : entry.subdirs)
+            {
+                if (subdir == oldSubdir)
+                {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) removeLibraryTree(directory + oldSubdir + "/");
+        }
+
+        // keep classifications and validations of files that did not change
+        for (const T_LibraryFile& oldFile : gLibrary[directory].files)
+        {
+            if ((oldFile.target == LIBRARY_TARGET_UNKNOWN) && (oldFile.status == LIBRARY_STATUS_NONE)) continue;
+            for (T_LibraryFile& file : newEntry.files)
+            {
+                if ((file.name == oldFile.name) && (file.size == oldFile.size) && (file.inode == oldFile.inode))
+                {
+                    file.target = oldFile.target;
+                    file.status = oldFile.status;
+                    file.launch = oldFile.launch;
+                    break;
+                }
+            }
+        }
+    }
+
+    gLibrary[directory] = newEntry;
+    gLibraryDirty = true;
+}
+
+static T_LibraryFile* findLibraryFile(const std::string& filename)
+{
+    size_t slash = filename.find_last_of("/");
+    if (slash == std::string::npos) return nullptr;
+
+    if (!gLibraryLoaded) loadLibraryIndexLocked();
+
+    auto it = gLibrary.find(filename.substr(0,slash + 1));
+    if (it == gLibrary.end()) return nullptr;
+
+    std::string name = filename.substr(slash + 1);
+    for (T_LibraryFile& file : it->second.files)
+    {
+        if (file.name == name) return &file;
+    }
+    return nullptr;
+}
+
+int getLibraryTarget(const std::string& filename)
+{
+    DEBUG_PRINTF("   int getLibraryTarget(const std::string& filename=%s)\n",filename.c_str());
+    struct stat fileStat;
+    std::lock_guard<std::mutex> lock(gLibraryMutex);
+    T_LibraryFile* file = findLibraryFile(filename);
+
+    if (!file || (file->target == LIBRARY_TARGET_UNKNOWN)) return LIBRARY_TARGET_UNKNOWN;
+
+    // the file could have been replaced in place
+    if ((stat(filename.c_str(),&fileStat) != 0) ||
+        (fileStat.st_size != file->size) || (fileStat.st_ino != file->inode))
+    {
+        return LIBRARY_TARGET_UNKNOWN;
+    }
+    return file->target;
+}
+
+void setLibraryTarget(const std::string& filename, int target)
+{
+    DEBUG_PRINTF("   void setLibraryTarget(const std::string& filename=%s, int target=%d)\n",filename.c_str(),target);
+    struct stat fileStat;
+    std::lock_guard<std::mutex> lock(gLibraryMutex);
+    T_LibraryFile* file = findLibraryFile(filename);
+
+    if (!file) return;
+    if (stat(filename.c_str(),&fileStat) != 0) return;
+
+    if ((fileStat.st_size != file->size) || (fileStat.st_ino != file->inode))
+    {
+        file->status = LIBRARY_STATUS_NONE;
+        file->launch.clear();
+    }
+    file->size   = fileStat.st_size;
+    file->inode  = fileStat.st_ino;
+    file->target = target;
+    gLibraryDirty = true;
+    saveLibraryIndexLocked();
+}
+
+bool getLibraryFile(const std::string& filename, T_LibraryFile* file)
+{
+    std::lock_guard<std::mutex> lock(gLibraryMutex);
+    T_LibraryFile* libraryFile = findLibraryFile(filename);
+
+    if (!libraryFile) return false;
+    *file = *libraryFile;
+    return true;
+}
+
+// stores the result of a validation, the index is written by saveLibraryIndex()
+bool setLibraryFile(const std::string& filename, const T_LibraryFile& file)
+{
+    std::lock_guard<std::mutex> lock(gLibraryMutex);
+    T_LibraryFile* libraryFile = findLibraryFile(filename);
+
+    if (!libraryFile || (libraryFile->name != file.name)) return false;
+    if (file.launch.find_first_of("\t\n") != std::string::npos) return false;
+    *libraryFile = file;
+    gLibraryDirty = true;
+    return true;
+}
+
+// the file was written in place, its size and inode could be unchanged
+void invalidateLibraryFile(const std::string& filename)
+{
+    DEBUG_PRINTF("   void invalidateLibraryFile(const std::string& filename=%s)\n",filename.c_str());
+    std::lock_guard<std::mutex> lock(gLibraryMutex);
+    T_LibraryFile* file = findLibraryFile(filename);
+
+    if (!file) return;
+    if ((file->target == LIBRARY_TARGET_UNKNOWN) && (file->status == LIBRARY_STATUS_NONE)) return;
+    file->target = LIBRARY_TARGET_UNKNOWN;
+    file->status = LIBRARY_STATUS_NONE;
+    file->launch.clear();
+    gLibraryDirty = true;
+}
+
+// for a validated game: the emulator target (LIBRARY_TARGET_UNKNOWN
+// if it cannot be launched) and the file to hand over to the emulator.
+// needsCueSheet is set if that file is a cue sheet the launcher has to write first.
+// Nothing is read from the disk, changes are reported by the library watcher.
+bool getLibraryLaunch(const std::string& filename, int* target, std::string* launchFile, bool* needsCueSheet)
+{
+    DEBUG_PRINTF("   bool getLibraryLaunch(const std::string& filename=%s, int* target, std::string* launchFile, bool* needsCueSheet)\n",filename.c_str());
+    std::lock_guard<std::mutex> lock(gLibraryMutex);
+    T_LibraryFile* file = findLibraryFile(filename);
+
+    if (!file || (file->status == LIBRARY_STATUS_NONE)) return false;
+
+    *needsCueSheet = (file->status == LIBRARY_STATUS_NO_CUE);
+
+    if (file->status == LIBRARY_STATUS_BROKEN)
+    {
+        *target = LIBRARY_TARGET_UNKNOWN;
+        *launchFile = filename;
+        return true;
+    }
+    *target = file->target;
+    if (file->launch.empty())
+    {
+        *launchFile = filename;
+    }
+    else
+    {
+        *launchFile = filename.substr(0,filename.find_last_of("/") + 1) + file->launch;
+    }
+    return true;
+}
+
+static std::string_view getBaseName(const std::string& filename)
+{
+    std::string_view name(filename);
+    size_t slash = name.find_last_of("/");
+    if (slash != std::string_view::npos) name.remove_prefix(slash + 1);
+    return name;
+}
+
+// removes the files referenced by cue files (toBeRemoved) from tmpList,
+// entries are compared by their name without path
+void stripList(std::list<std::string> *tmpList, std::list<std::string> *toBeRemoved)
+{
+    DEBUG_PRINTF("   void stripList(std::list<std::string> *tmpList, std::list<std::string> *toBeRemoved)\n");
+    std::unordered_set<std::string_view> removeNames;
+
+    if (toBeRemoved[0].empty()) return;
+
+    removeNames.reserve(toBeRemoved[0].size());
+    for (const std::string& strRemove : toBeRemoved[0])
+    {
+        removeNames.insert(getBaseName(strRemove));
+    }
+
+    for (auto it = tmpList[0].begin(); it != tmpList[0].end();)
+    {
+        if (removeNames.count(getBaseName(*it)))
+        {
+            it = tmpList[0].erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+// appends tmpList to gGame, avoiding duplicates
+void finalizeList(std::list<std::string> *tmpList)
+{
+    DEBUG_PRINTF("   void finalizeList(std::list<std::string> *tmpList)\n");
+    std::unordered_set<std::string> games;
+
+    games.reserve(gGame.size() + tmpList[0].size());
+    games.insert(gGame.begin(), gGame.end());
+    for (const std::string& game : tmpList[0])
+    {
+        if (games.insert(game).second) gGame.push_back(game);
+    }
+
+    gGamesFound = (gGame.size() > 0);
+}
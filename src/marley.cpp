@@ -27,6 +27,8 @@
 #include "../include/emu.h"
 #include "../include/wii.h"
 #include "../include/global.h"
+#include "../include/watcher.h"
+#include "../include/validator.h"
 #include <sys/stat.h>
 #include <unistd.h>
 #include <string>
@@ -35,8 +37,12 @@
 #include <errno.h>
 #include <gtk/gtk.h>
 #include "../resources/res.h"
+#include "Common/Profiler/Profiler.h"
 
 #define PI 3.14159
+// the main loop sleeps until input arrives, the wiimote and
+// the library watcher are polled in between
+#define IDLE_TIMEOUT_MS 50
 
 double angle0L = 0;
 double angle1L = 0;
@@ -61,6 +67,11 @@ void event_loop(void);
 Uint32 splash_callbackfunc(Uint32 interval, void *param);
 void checkFirmwareSEGA_SATURN(void);
 void resetSearch(void);
+#ifdef DOLPHIN
+extern bool dolphin_warm_start;
+extern bool dolphin_rewind;
+extern bool dolphin_precompile_shaders;
+#endif
 TTF_Font* gFont = nullptr;
 int gActiveController=-1;
 bool ALT = false;
@@ -292,12 +303,19 @@ int main( int argc, char* argv[] )
             printf("\nOptions:\n\n");
             printf("  --version             : print version\n");
             printf("  --fullscreen, -f      : start in fullscreen mode\n");
-            printf("  --killX11pointer, -k  : switch off the mouse pointer for the entire desktop\n\n");
+            printf("  --killX11pointer, -k  : switch off the mouse pointer for the entire desktop\n");
+            printf("  --cold-start          : initialize Dolphin from scratch for every game\n");
+            printf("  --rewind              : keep snapshots of Dolphin games in memory to step back\n");
+            printf("  --precompile-shaders  : compile the shaders of all Dolphin games played before the game starts\n");
+            printf("  --perf-hud            : show the frame-time graph\n");
+            printf("  --trace=<file>        : write a Chrome trace (chrome://tracing) of the launcher to <file>\n\n");
             printf("Use your controller or arrow keys/enter on your keyboard to navigate.\n\n");
             printf("Use \"l\" to print a list of detected controllers to the command line.\n\n");
             printf("Use \"f\" to toggle fullscreen.\n\n");
             printf("Use \"p\" to print the current gamepad mapping(s).\n\n");
             printf("Use \"F5\" to save and \"F7\" to load game states.\n\n");
+            printf("Use \"Backspace\" to rewind Dolphin games started with --rewind.\n\n");
+            printf("Use \"F3\" to toggle the frame-time graph.\n\n");
             printf("Use the guide button to exit a game with no questions asked. The guide button is the big one in the middle.\n\n");
             printf("Use \"ESC\" to exit.\n\n");
             printf("Visit https://github.com/beaumanvienna/marley for more information.\n\n");
@@ -320,6 +338,37 @@ int main( int argc, char* argv[] )
             printf("Updating resources\n");
         }
         
+        if (str.find("--cold-start") == 0)
+        {
+#ifdef DOLPHIN
+            dolphin_warm_start = false;
+#endif
+        }
+        
+        if (str.find("--rewind") == 0)
+        {
+#ifdef DOLPHIN
+            dolphin_rewind = true;
+#endif
+        }
+        
+        if (str.find("--precompile-shaders") == 0)
+        {
+#ifdef DOLPHIN
+            dolphin_precompile_shaders = true;
+#endif
+        }
+        
+        if (str.find("--perf-hud") == 0)
+        {
+            SCREEN_ProfilerSetHUD(true);
+        }
+        
+        if (str.find("--trace=") == 0)
+        {
+            SCREEN_ProfilerStartTrace(str.substr(8));
+        }
+        
         if (str.find("-t") == 0)
         {
             pcsx2_window_tear_down=true;
@@ -350,19 +399,29 @@ int main( int argc, char* argv[] )
         // launch into new interface
         statemachine(SDL_CONTROLLER_BUTTON_A);
 
-        //main loop
+        //main loop, the screen is only rendered when something changed
         while( !gQuit )
         {
-            SDL_Delay(33); // 30 fps
+            SDL_WaitEventTimeout(nullptr, IDLE_TIMEOUT_MS);
 #ifdef DOLPHIN
             mainLoopWii();
 #endif
+            if (pollLibraryWatcher()) gRedraw = true;
+            pollLaunchConversion();
             event_loop();
-            renderScreen();
+            if (gRedraw)
+            {
+                gRedraw = false;
+                renderScreen();
+            }
         }
         
     }
 
+    SCREEN_ProfilerStopTrace();
+    cancelGameConversion();
+    stopValidator();
+    
     //Free resources, shut down SDL
     closeAll();
 #ifdef DOLPHIN
@@ -371,6 +430,20 @@ int main( int argc, char* argv[] )
     return 0;
 }
 
+// sticks resting near the center keep sending axis events
+static bool isIdleEvent(const SDL_Event& event)
+{
+    switch (event.type)
+    {
+        case SDL_JOYAXISMOTION:
+            return (abs(event.jaxis.value) <= ANALOG_DEAD_ZONE);
+        case SDL_CONTROLLERAXISMOTION:
+            return true;
+        default:
+            return false;
+    }
+}
+
 void event_loop(void)
 {
     int k,l,m;
@@ -381,6 +454,9 @@ void event_loop(void)
     //Handle events on queue
     while( SDL_PollEvent( &event ) != 0 )
     {
+        PROFILE_THIS_SCOPE("SDL event", PROFILE_EVENTS);
+        if (!isIdleEvent(event)) gRedraw = true;
+        
         // main event loop
         switch (event.type)
         {
@@ -434,6 +510,9 @@ void event_loop(void)
                         case SDLK_p:
                             printJoyInfoAll();
                             break;
+                        case SDLK_F3:
+                            SCREEN_ProfilerSetHUD(!SCREEN_ProfilerHUDVisible());
+                            break;
                         case SDLK_ESCAPE:
                             DEBUG_PRINTF("   ++++++++++++++++++++++++++++++++++++++++++ case SDLK_ESCAPE: ++++++++++++++++++++++++++++++++++++++++++ \n");
                             stopSearching=true;
@@ -452,7 +531,11 @@ void event_loop(void)
                                 }
                             } else
                             {
-                                if (gState == STATE_OFF)
+                                if (gConversionPercent >= 0)
+                                {
+                                    cancelGameConversion();
+                                }
+                                else if (gState == STATE_OFF)
                                 {
                                     gQuit=true;
                                 }
@@ -649,13 +732,6 @@ void event_loop(void)
     }
 }
 
-void restoreSDL(void)
-{
-    DEBUG_PRINTF("   void restoreSDL(void)\n");
-    restoreController();
-    restoreGUI();
-}
-
 //Motion on gamepad x
 void joyMotion(SDL_Event event, int designatedCtrl, double* x, double* y)
 {
@@ -808,8 +884,8 @@ void loadConfig(ifstream* configFile)
             entry = line.substr(pos+1,line.length()-pos);
             if ( setPathToGames(entry) )
             {
-                checkFirmwarePSX();
                 buildGameList();
+                checkFirmwarePSX();
             }
         } else
         if(line.find("ui_theme") != std::string::npos)
@@ -1038,108 +1114,3 @@ bool searchAllFolders(void)
     
     return canceled;
 }
-
-void removeDuplicatesInDB(void)
-{
-    DEBUG_PRINTF("   void removeDuplicatesInDB(void)\n");
-    // If duplicate GUIDs are found,
-    // this function keeps only the 1st encounter.
-    // This is why addControllerToInternalDB()
-    // is inserting new entries at the beginning.
-    string line, guidStr;
-    long guid;
-    vector<string> entryVec;
-    vector<string> guidVec;
-    string filename;
-    bool found;
-    
-    filename = gBaseDir + "internaldb.txt";
-    
-    ifstream internalDB(filename);
-    if (!internalDB.is_open())
-    {
-        printf("Could not open file: removeDuplicate(), file %s \n",filename.c_str());
-    }
-    else 
-    {
-        while ( getline (internalDB,line))
-        {
-            found = false;
-            if (line.find(",") != std::string::npos)
-            {
-                guidStr = line.substr(0,line.find(","));
-                for (int i = 0;i < guidVec.size();i++)
-                {
-                    if (guidVec[i]==guidStr)
-                    {
-                        found=true;
-                        break;
-                    }
-                }
-            }
-            if (!found)
-            {
-                guidVec.push_back(guidStr);
-                entryVec.push_back(line);
-            }
-        }
-        
-        internalDB.close();
-
-        ofstream internal_db_output_filehandle;
-        internal_db_output_filehandle.open(filename.c_str(), ios_base::out);
-        if (internal_db_output_filehandle.fail())
-        {
-            printf("Could not write internal game controller database: %s, no entry added\n",filename.c_str());
-        }
-        else 
-        {
-            for (int i=0;i < entryVec.size();i++)
-            {
-                internal_db_output_filehandle << entryVec[i] << + "\n";
-            }
-            internal_db_output_filehandle.close();
-        }
-    }
-}
-
-bool addControllerToInternalDB(string entry)
-{
-    DEBUG_PRINTF("   bool addControllerToInternalDB(string entry=%s)\n",entry.c_str());
-    bool ok = false;
-    string line;
-    string filename = gBaseDir + "internaldb.txt";
-    vector<string> internal_db_entries;
-    
-    ifstream internal_db_input_filehandle(filename);
-    
-    if (internal_db_input_filehandle.is_open())
-    {
-        while ( getline (internal_db_input_filehandle,line))
-        {
-            internal_db_entries.push_back(line);
-        }
-        internal_db_input_filehandle.close();
-    } else
-    {
-        printf("Creating internal game controller database %s\n",filename.c_str());
-    }
-    
-    ofstream internal_db_output_filehandle;
-    internal_db_output_filehandle.open(filename.c_str(), ios_base::out);
-    if (internal_db_output_filehandle.fail())
-    {
-        printf("Could not write internal game controller database: %s, no entry added\n",filename.c_str());
-    }
-    else 
-    {
-        internal_db_output_filehandle << entry << + "\n"; 
-        for (int i = 0; i < internal_db_entries.size(); i++)
-        {
-            internal_db_output_filehandle << internal_db_entries[i] << + "\n"; 
-        }
-        internal_db_output_filehandle.close();
-        ok = true;
-    }
-    return ok;
-}
@@ -22,6 +22,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+
+#include "../include/mdf2iso.h"
 
 #define VERSION "0.3.1"
 
@@ -84,6 +95,17 @@ const char ISO_9660[8] = { (char) 0x01,
 #define MDF_AUDIO 3
 #define UNKNOWN -1
 
+#define MDF_BLOCK_SECTORS 2048      // about 5 MB per read
+#define MDF_BLOCK_BUFFERS 3
+#define MDF_BUFFER_ALIGNMENT 4096
+
+static std::atomic<long> gMdf2IsoSectors(0);
+static std::atomic<long> gMdf2IsoTotal(0);
+static std::atomic<bool> gMdf2IsoCancel(false);
+static std::atomic<bool> gMdf2IsoRunning(false);
+static std::thread gMdf2IsoThread;
+static int gMdf2IsoResult;
+
 int toc_file (char *destfilename, int sub)
 {
   int ret=0;
@@ -187,6 +209,7 @@ void main_percent (int percent_bar)
   //int progress_bar, progress_space;
  
   if (percent_bar==previous_percent) return;  // Nothing changed, don't waste CPU cycles.
+  previous_percent=percent_bar;
   
   printf("%3d%% [:%.*s>%.*s:]\r",percent_bar,20-(percent_bar/5),"                    ",
                                                   percent_bar/5,"====================");
@@ -257,19 +280,248 @@ char mdftype(FILE *f)
 }
 
 
+typedef struct MdfBlock {
+    char *data;
+    size_t length;
+    long sectors;
+} T_MdfBlock;
+
+static bool readFully(int fd, char *buffer, size_t length, off_t offset)
+{
+    while (length > 0)
+    {
+        ssize_t bytes = pread(fd, buffer, length, offset);
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes <= 0) return false;
+        buffer += bytes;
+        offset += bytes;
+        length -= bytes;
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const char *buffer, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t bytes = write(fd, buffer, length);
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes <= 0) return false;
+        buffer += bytes;
+        length -= bytes;
+    }
+    return true;
+}
+
+// Copies the data part of every sector to destfilename. A reader thread
+// reads blocks of MDF_BLOCK_SECTORS sectors and strips them in place
+// (the data part moves to the front of the block), this thread writes them.
+static int convertSectors(const char *basefilename, const char *destfilename, long source_length,
+                          int sector_size, int sector_data, int seek_head)
+{
+    std::vector<T_MdfBlock> blocks(MDF_BLOCK_BUFFERS);
+    std::deque<T_MdfBlock*> freeBlocks, fullBlocks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool readDone = false, readError = false, writeError = false;
+    int fdsource, fddest, readErrno = 0, writeErrno = 0, ret = 0;
+    long written = 0;
+
+    gMdf2IsoTotal = source_length;
+    gMdf2IsoSectors = 0;
+
+    if ((fdsource = open(basefilename, O_RDONLY | O_CLOEXEC)) < 0)
+    {
+        printf ("Could not open %s: %s\n", basefilename, strerror(errno));
+        return -1;
+    }
+    if ((fddest = open(destfilename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) < 0)
+    {
+        printf ("Unable to open %s for output: %s\n",destfilename,strerror(errno));
+        close(fdsource);
+        return -1;
+    }
+    posix_fadvise(fdsource, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    for (T_MdfBlock& block : blocks)
+    {
+        if (posix_memalign((void**) &block.data, MDF_BUFFER_ALIGNMENT, (size_t) MDF_BLOCK_SECTORS * sector_size) != 0)
+        {
+            block.data = nullptr;
+            continue;
+        }
+        freeBlocks.push_back(&block);
+    }
+    if (freeBlocks.empty())
+    {
+        printf ("Out of memory converting %s\n", basefilename);
+        close(fdsource);
+        close(fddest);
+        return -1;
+    }
+
+    std::thread reader([&]()
+    {
+        for (long sector = 0; sector < source_length; sector += MDF_BLOCK_SECTORS)
+        {
+            T_MdfBlock *block;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&]() { return !freeBlocks.empty() || writeError; });
+                if (writeError) break;
+                block = freeBlocks.front();
+                freeBlocks.pop_front();
+            }
+
+            block->sectors = (source_length - sector < MDF_BLOCK_SECTORS) ? source_length - sector : MDF_BLOCK_SECTORS;
+            block->length = (size_t) block->sectors * sector_data;
+            bool ok = !gMdf2IsoCancel &&
+                      readFully(fdsource, block->data, (size_t) block->sectors * sector_size, (off_t) sector * sector_size);
+            if (ok && ((sector_data != sector_size) || seek_head))
+            {
+                for (long i = 0; i < block->sectors; i++)
+                {
+                    memmove(block->data + i * sector_data, block->data + i * sector_size + seek_head, sector_data);
+                }
+            }
+
+            int error = errno;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!ok)
+            {
+                readError = true;
+                readErrno = error;
+                freeBlocks.push_back(block);
+                break;
+            }
+            fullBlocks.push_back(block);
+            condition.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        readDone = true;
+        condition.notify_all();
+    });
+
+    for (;;)
+    {
+        T_MdfBlock *block;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&]() { return !fullBlocks.empty() || readDone; });
+            if (fullBlocks.empty()) break;
+            block = fullBlocks.front();
+            fullBlocks.pop_front();
+        }
+
+        bool ok = writeFully(fddest, block->data, block->length);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        freeBlocks.push_back(block);
+        if (!ok)
+        {
+            writeError = true;
+            writeErrno = errno;
+            condition.notify_all();
+            break;
+        }
+        written += block->sectors;
+        gMdf2IsoSectors = written;
+        main_percent(written*100/source_length);
+        condition.notify_all();
+    }
+    reader.join();
+
+    if (gMdf2IsoCancel)
+    {
+        printf ("Conversion of %s cancelled\n", basefilename);
+        ret = -1;
+    }
+    else if (readError)
+    {
+        printf ("Error reading from %s: %s\n",basefilename, strerror (readErrno));
+        ret = -1;
+    }
+    else if (writeError)
+    {
+        printf ("Error writing to %s: %s\n",destfilename, strerror (writeErrno));
+        ret = -1;
+    }
+    if ((close(fddest) != 0) && (ret == 0))
+    {
+        printf ("Error writing to %s: %s\n",destfilename, strerror (errno));
+        ret = -1;
+    }
+    close(fdsource);
+    for (T_MdfBlock& block : blocks)
+    {
+        free(block.data);
+    }
+    return ret;
+}
+
+// raw data sectors, with or without subchannel data
+bool isRawMdf(const std::string& filename)
+{
+    FILE *fsource;
+    int type;
+
+    if ((fsource = fopen(filename.c_str(), "rb")) == nullptr) return false;
+    type = mdftype(fsource);
+    fclose(fsource);
+    return (type == SYNC) || (type == SYNC_MDF);
+}
+
+bool startMdf2Iso(const std::string& filename, const std::string& destfilename_no_path)
+{
+    if (gMdf2IsoThread.joinable()) return false;
+
+    gMdf2IsoSectors = 0;
+    gMdf2IsoTotal = 0;
+    gMdf2IsoCancel = false;
+    gMdf2IsoRunning = true;
+    gMdf2IsoThread = std::thread([filename, destfilename_no_path]()
+    {
+        std::string arg1 = "mdf2iso", arg2 = "--cue", arg3 = filename, arg4 = destfilename_no_path;
+        char *argv[4] = { &arg1[0], &arg2[0], &arg3[0], &arg4[0] };
+
+        gMdf2IsoResult = mdf2iso_main (4, argv);
+        gMdf2IsoRunning = false;
+    });
+    return true;
+}
+
+// false when the conversion has finished
+bool getMdf2IsoProgress(int* percent)
+{
+    long total = gMdf2IsoTotal;
+    percent[0] = total ? (int) (gMdf2IsoSectors * 100 / total) : 0;
+    return gMdf2IsoRunning;
+}
+
+void cancelMdf2Iso(void)
+{
+    gMdf2IsoCancel = true;
+}
+
+int finishMdf2Iso(void)
+{
+    if (!gMdf2IsoThread.joinable()) return -1;
+    gMdf2IsoThread.join();
+    return gMdf2IsoResult;
+}
+
 // === Main program code ===
 
 int mdf2iso_main (int argc, char **argv)
 {
-    int seek_ecc, sector_size, seek_head, sector_data;//, n_mdf;
+    int sector_size, seek_head, sector_data;//, n_mdf;
     int cue = 0, cue_mode = 0, sub = 1, toc = 0, sub_toc = 0;
     int opts = 0;
     long i, source_length;
-    char buf[2448];
     char *destfilename=nullptr;
     char *basefilename=nullptr;
     char *destfilename_no_path=nullptr;
-    FILE *fdest, *fsource;
+    FILE *fsource;
 
     // Print identification
     printf ("mdf2iso v%s by Salvatore Santagati\n", VERSION);
@@ -339,7 +591,6 @@ int mdf2iso_main (int argc, char **argv)
 			{
                 cue_mode = 1;
 			    sub = 0;
-			    seek_ecc = 0;
                 sector_size = 2352;
                 sector_data = 2352;
                 seek_head = 0;
@@ -347,14 +598,12 @@ int mdf2iso_main (int argc, char **argv)
             if (toc == 0)
 			{
                 //NORMAL IMAGE
-                seek_ecc = 288;
 			    sector_size = 2352;
 			    sector_data = 2048;
 			    seek_head = 16;
             }
 			else
 			{
-			   seek_ecc = 0;
 			   sector_size = 2352;
 			   sector_data = 2352;
 			   seek_head = 0;
@@ -366,7 +615,6 @@ int mdf2iso_main (int argc, char **argv)
                 cue_mode = 1;
 
                 // BAD SECTOR TO NORMAL IMAGE
-                seek_ecc = 96;
                 sector_size = 2448;
                 sector_data = 2352;
                 seek_head = 0;
@@ -374,7 +622,6 @@ int mdf2iso_main (int argc, char **argv)
             else if (toc == 0)
 		    {
                 // BAD SECTOR
-                seek_ecc = 384;
                 sector_size = 2448;
                 sector_data = 2048;
                 seek_head = 16;
@@ -382,7 +629,6 @@ int mdf2iso_main (int argc, char **argv)
             else
 		    {
                 //BAD SECTOR
-                seek_ecc = 0;
                 sector_size = 2448;
                 sector_data = 2448;
                 seek_head = 0;
@@ -393,7 +639,6 @@ int mdf2iso_main (int argc, char **argv)
             //BAD SECTOR AUDIO
 		    seek_head = 0;
 		    sector_size = 2448;
-		    seek_ecc = 96;
 		    sector_data = 2352;
 		    cue = 0;
             break;
@@ -404,51 +649,20 @@ int mdf2iso_main (int argc, char **argv)
             return -1;
     }
 
+    fseek (fsource, 0L, SEEK_END);
+    source_length = ftell (fsource) / sector_size;
+    fclose (fsource);
+
     //  *** Create destination file ***
-    
-    // Try opening the destination file for output
-    if ((fdest = fopen (destfilename, "wb")) == nullptr)
+
+    if (convertSectors(basefilename, destfilename, source_length, sector_size, sector_data, seek_head))
     {
-        printf ("Unable to open %s for output: %s\n",destfilename,strerror(errno));
+        remove(destfilename);
         free(destfilename);
-        fclose(fsource);
         return -1;
     }
-
-    
-    fseek (fsource, 0L, SEEK_END);
-	source_length = ftell (fsource) / sector_size;
-	fseek (fsource, 0L, SEEK_SET);
-	
-	for (i = 0; i < source_length; i++)
-	{
-        fseek (fsource, seek_head, SEEK_CUR);
-        if (fread(buf, sizeof (char), sector_data, fsource)!=sector_data)
-		{
-            printf ("Error reading from %s: %s\n",basefilename, strerror (errno));
-            fclose(fsource);
-            fclose(fdest);
-            remove(destfilename);
-            free(destfilename);
-			return -1;
-        }
-        if (fwrite (buf, sizeof (char), sector_data, fdest)!=sector_data)
-		{
-            printf ("Error writing to %s: %s\n",destfilename, strerror (errno));
-            fclose(fsource);
-            fclose(fdest);
-            remove(destfilename);
-            free(destfilename);
-			return -1;
-        }
-		fseek (fsource, seek_ecc, SEEK_CUR);
-        main_percent(i*100/source_length);
-    }
     printf ("100%% [:=====================:]\n");
 
-	fclose (fsource);
-	fclose (fdest);
-
     // *** create Toc or Cue file is requested ***
     if (cue == 1) if (cuesheets(destfilename,destfilename_no_path))
     {
@@ -0,0 +1,389 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "../include/log.h"
+#include "../include/emu.h"
+#include "../include/mediacache.h"
+#include "Common/Render/TextureAtlas.h"
+
+#define MEDIA_CACHE_FILE        "media.atlas"
+#define MEDIA_CACHE_MAGIC       "MARLEYMC"
+#define MEDIA_CACHE_VERSION     1
+#define MEDIA_CACHE_SOURCE      "/proc/self/exe"
+#define MEDIA_PAGE_SIZE         2048
+#define MEDIA_PAGE_ALIGNMENT    4096
+#define MEDIA_BYTES_PER_PIXEL   4
+
+// File layout: header, page table, per page an AtlasHeader followed by
+// its AtlasImage records (name = bitmap file name), then the pixels of
+// every page (page aligned, ARGB8888, pitch = page width * 4).
+typedef struct MediaCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numPages;
+    int64_t sourceSize;
+    int64_t sourceMtimeSec;
+    int64_t sourceMtimeNsec;
+} T_MediaCacheHeader;
+
+typedef struct MediaCachePage {
+    int32_t width;
+    int32_t height;
+    uint64_t atlasOffset;
+    uint64_t pixelOffset;
+} T_MediaCachePage;
+
+typedef struct MediaPlacement {
+    int page;
+    int x;
+    int y;
+} T_MediaPlacement;
+
+static bool statMediaSource(T_MediaCacheHeader* header)
+{
+    struct stat fileStat;
+
+    if (stat(MEDIA_CACHE_SOURCE,&fileStat) != 0) return false;
+    header->sourceSize      = fileStat.st_size;
+    header->sourceMtimeSec  = fileStat.st_mtim.tv_sec;
+    header->sourceMtimeNsec = fileStat.st_mtim.tv_nsec;
+    return true;
+}
+
+static const char* getMediaName(const char* resource)
+{
+    const char* slash = strrchr(resource, '/');
+    return slash ? slash + 1 : resource;
+}
+
+static int findMedia(const T_MediaFile* media, int count, const AtlasImage& image)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (strncmp(getMediaName(media[i].resource), image.name, sizeof(image.name)) == 0) return i;
+    }
+    return -1;
+}
+
+// ARGB8888 is the native format of the opengl renderer, the pixels are
+// uploaded as they are
+static SDL_Texture* createMediaTexture(SDL_Renderer* renderer, const void* pixels, int width, int height, int pitch)
+{
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, width, height);
+    if (!texture) return nullptr;
+    if (SDL_UpdateTexture(texture, nullptr, pixels, pitch) != 0)
+    {
+        SDL_DestroyTexture(texture);
+        return nullptr;
+    }
+    // bitmaps without alpha channel were stored with alpha 0xff,
+    // blending them is the same as copying them
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    return texture;
+}
+
+bool loadMediaCache(SDL_Renderer* renderer, const T_MediaFile* media, int count, SDL_Texture** textures)
+{
+    DEBUG_PRINTF("   bool loadMediaCache(SDL_Renderer* renderer, const T_MediaFile* media, int count=%d, SDL_Texture** textures)\n",count);
+    T_MediaCacheHeader source;
+    std::vector<SDL_Texture*> loaded(count, nullptr);
+    std::string filename;
+    struct stat fileStat;
+    int found = 0;
+    int fd;
+
+    if ((gBaseDir == "") || !statMediaSource(&source)) return false;
+
+    filename = gBaseDir + MEDIA_CACHE_FILE;
+    fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    if ((fstat(fd,&fileStat) != 0) || ((size_t) fileStat.st_size < sizeof(T_MediaCacheHeader)))
+    {
+        close(fd);
+        return false;
+    }
+    size_t length = fileStat.st_size;
+    void* map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const uint8_t* data = (const uint8_t*) map;
+    const T_MediaCacheHeader* header = (const T_MediaCacheHeader*) data;
+    if ((memcmp(header->magic, MEDIA_CACHE_MAGIC, sizeof(header->magic)) != 0) ||
+        (header->version         != MEDIA_CACHE_VERSION) ||
+        (header->sourceSize      != source.sourceSize) ||
+        (header->sourceMtimeSec  != source.sourceMtimeSec) ||
+        (header->sourceMtimeNsec != source.sourceMtimeNsec))
+    {
+        printf("Media cache %s is outdated\n",filename.c_str());
+        munmap(map, length);
+        return false;
+    }
+
+    bool ok = (sizeof(T_MediaCacheHeader) + header->numPages * sizeof(T_MediaCachePage) <= length);
+    const T_MediaCachePage* pages = (const T_MediaCachePage*) (data + sizeof(T_MediaCacheHeader));
+    for (uint32_t p = 0; ok && (p < header->numPages); p++)
+    {
+        const T_MediaCachePage& page = pages[p];
+        size_t pitch = (size_t) page.width * MEDIA_BYTES_PER_PIXEL;
+        if ((page.width <= 0) || (page.height <= 0) ||
+            (page.atlasOffset + sizeof(AtlasHeader) > length) ||
+            (page.pixelOffset + pitch * page.height > length))
+        {
+            ok = false;
+            break;
+        }
+        const AtlasHeader* atlas = (const AtlasHeader*) (data + page.atlasOffset);
+        if ((atlas->magic != ATLAS_MAGIC) || (atlas->numImages < 0) ||
+            (page.atlasOffset + sizeof(AtlasHeader) + atlas->numImages * sizeof(AtlasImage) > length))
+        {
+            ok = false;
+            break;
+        }
+
+        const AtlasImage* images = (const AtlasImage*) (atlas + 1);
+        const uint8_t* pixels = data + page.pixelOffset;
+        for (int i = 0; i < atlas->numImages; i++)
+        {
+            const AtlasImage& image = images[i];
+            int x = lroundf(image.u1 * page.width);
+            int y = lroundf(image.v1 * page.height);
+            int index = findMedia(media, count, image);
+            if ((index < 0) || loaded[index] || (image.w <= 0) || (image.h <= 0) ||
+                (x < 0) || (y < 0) || (x + image.w > page.width) || (y + image.h > page.height))
+            {
+                ok = false;
+                break;
+            }
+            loaded[index] = createMediaTexture(renderer, pixels + y * pitch + x * MEDIA_BYTES_PER_PIXEL, image.w, image.h, pitch);
+            if (!loaded[index])
+            {
+                ok = false;
+                break;
+            }
+            found++;
+        }
+    }
+    munmap(map, length);
+
+    if (ok && (found == count))
+    {
+        for (int i = 0; i < count; i++)
+        {
+            textures[media[i].texture] = loaded[i];
+        }
+        return true;
+    }
+
+    printf("Ignoring media cache %s (%s)\n",filename.c_str(), ok ? "bitmaps missing" : "damaged");
+    for (SDL_Texture* texture : loaded)
+    {
+        if (texture) SDL_DestroyTexture(texture);
+    }
+    return false;
+}
+
+// shelf packing, highest bitmaps first
+static void packMediaPages(const std::vector<SDL_Surface*>& surfaces, std::vector<T_MediaPlacement>* placements, std::vector<T_MediaCachePage>* pages)
+{
+    std::vector<int> order(surfaces.size());
+    int x = 0, y = 0, shelfHeight = 0;
+
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&surfaces](int a, int b) { return surfaces[a]->h > surfaces[b]->h; });
+
+    placements->resize(surfaces.size());
+    pages->clear();
+    pages->push_back(T_MediaCachePage{});
+    for (int i : order)
+    {
+        SDL_Surface* surface = surfaces[i];
+        if (x + surface->w > MEDIA_PAGE_SIZE)
+        {
+            x = 0;
+            y += shelfHeight;
+            shelfHeight = 0;
+        }
+        if (y + surface->h > MEDIA_PAGE_SIZE)
+        {
+            pages->push_back(T_MediaCachePage{});
+            x = 0;
+            y = 0;
+            shelfHeight = 0;
+        }
+
+        T_MediaCachePage& page = pages->back();
+        T_MediaPlacement& placement = (*placements)[i];
+        placement.page = pages->size() - 1;
+        placement.x    = x;
+        placement.y    = y;
+        page.width     = std::max(page.width, x + surface->w);
+        page.height    = std::max(page.height, y + surface->h);
+
+        x += surface->w;
+        shelfHeight = std::max(shelfHeight, surface->h);
+    }
+}
+
+static bool writeMediaCache(const std::string& filename, T_MediaCacheHeader* header, const T_MediaFile* media,
+                            const std::vector<SDL_Surface*>& surfaces, const std::vector<T_MediaPlacement>& placements,
+                            std::vector<T_MediaCachePage>& pages)
+{
+    std::vector<int> numImages(pages.size(), 0);
+    std::vector<uint8_t> pixels;
+    size_t offset;
+
+    for (const T_MediaPlacement& placement : placements)
+    {
+        numImages[placement.page]++;
+    }
+    offset = sizeof(T_MediaCacheHeader) + pages.size() * sizeof(T_MediaCachePage);
+    for (size_t p = 0; p < pages.size(); p++)
+    {
+        pages[p].atlasOffset = offset;
+        offset += sizeof(AtlasHeader) + numImages[p] * sizeof(AtlasImage);
+    }
+    for (size_t p = 0; p < pages.size(); p++)
+    {
+        offset = (offset + MEDIA_PAGE_ALIGNMENT - 1) & ~((size_t) MEDIA_PAGE_ALIGNMENT - 1);
+        pages[p].pixelOffset = offset;
+        offset += (size_t) pages[p].width * MEDIA_BYTES_PER_PIXEL * pages[p].height;
+    }
+
+    std::ofstream cacheFile(filename, std::ios_base::binary | std::ios_base::trunc);
+    if (!cacheFile) return false;
+
+    memcpy(header->magic, MEDIA_CACHE_MAGIC, sizeof(header->magic));
+    header->version  = MEDIA_CACHE_VERSION;
+    header->numPages = pages.size();
+    cacheFile.write((const char*) header, sizeof(T_MediaCacheHeader));
+    cacheFile.write((const char*) pages.data(), pages.size() * sizeof(T_MediaCachePage));
+
+    for (size_t p = 0; p < pages.size(); p++)
+    {
+        AtlasHeader atlas = { ATLAS_MAGIC, 0, 0, numImages[p] };
+        cacheFile.write((const char*) &atlas, sizeof(AtlasHeader));
+        for (size_t i = 0; i < placements.size(); i++)
+        {
+            if (placements[i].page != (int) p) continue;
+            AtlasImage image;
+            memset(&image, 0, sizeof(AtlasImage));
+            image.u1 = (float) placements[i].x / pages[p].width;
+            image.v1 = (float) placements[i].y / pages[p].height;
+            image.u2 = (float) (placements[i].x + surfaces[i]->w) / pages[p].width;
+            image.v2 = (float) (placements[i].y + surfaces[i]->h) / pages[p].height;
+            image.w  = surfaces[i]->w;
+            image.h  = surfaces[i]->h;
+            strncpy(image.name, getMediaName(media[i].resource), sizeof(image.name) - 1);
+            cacheFile.write((const char*) &image, sizeof(AtlasImage));
+        }
+    }
+
+    for (size_t p = 0; p < pages.size(); p++)
+    {
+        size_t pitch = (size_t) pages[p].width * MEDIA_BYTES_PER_PIXEL;
+        pixels.assign(pitch * pages[p].height, 0);
+        for (size_t i = 0; i < placements.size(); i++)
+        {
+            if (placements[i].page != (int) p) continue;
+            SDL_Surface* surface = surfaces[i];
+            for (int row = 0; row < surface->h; row++)
+            {
+                memcpy(&pixels[(placements[i].y + row) * pitch + placements[i].x * MEDIA_BYTES_PER_PIXEL],
+                       (const uint8_t*) surface->pixels + row * surface->pitch,
+                       surface->w * MEDIA_BYTES_PER_PIXEL);
+            }
+        }
+        // zero padding up to the page aligned pixels
+        while ((size_t) cacheFile.tellp() < pages[p].pixelOffset)
+        {
+            cacheFile.put(0);
+        }
+        cacheFile.write((const char*) pixels.data(), pixels.size());
+    }
+    cacheFile.close();
+    return !cacheFile.fail();
+}
+
+// packs the decoded bitmaps, 'surfaces' is in the order of 'media'
+bool saveMediaCache(const T_MediaFile* media, int count, SDL_Surface** surfaces)
+{
+    DEBUG_PRINTF("   bool saveMediaCache(const T_MediaFile* media, int count=%d, SDL_Surface** surfaces)\n",count);
+    std::vector<SDL_Surface*> converted(count, nullptr);
+    std::vector<T_MediaPlacement> placements;
+    std::vector<T_MediaCachePage> pages;
+    std::string filename, tmpFilename;
+    T_MediaCacheHeader header;
+    bool ok = true;
+
+    if ((gBaseDir == "") || (count <= 0) || !statMediaSource(&header)) return false;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!surfaces[i] || (strlen(getMediaName(media[i].resource)) >= sizeof(AtlasImage::name)))
+        {
+            ok = false;
+            break;
+        }
+        converted[i] = SDL_ConvertSurfaceFormat(surfaces[i], SDL_PIXELFORMAT_ARGB8888, 0);
+        if (!converted[i] || (converted[i]->w > MEDIA_PAGE_SIZE) || (converted[i]->h > MEDIA_PAGE_SIZE))
+        {
+            ok = false;
+            break;
+        }
+    }
+
+    if (ok)
+    {
+        filename = gBaseDir + MEDIA_CACHE_FILE;
+        tmpFilename = filename + ".tmp";
+        packMediaPages(converted, &placements, &pages);
+        ok = writeMediaCache(tmpFilename, &header, media, converted, placements, pages);
+        if (!ok || (rename(tmpFilename.c_str(), filename.c_str()) != 0))
+        {
+            printf("Could not write media cache %s\n",filename.c_str());
+            remove(tmpFilename.c_str());
+            ok = false;
+        }
+    }
+
+    for (SDL_Surface* surface : converted)
+    {
+        if (surface) SDL_FreeSurface(surface);
+    }
+    return ok;
+}
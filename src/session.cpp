@@ -0,0 +1,138 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <string>
+#include <SDL.h>
+
+#include "../include/log.h"
+#include "../include/gui.h"
+#include "../include/controller.h"
+#include "../include/session.h"
+
+void setAppIcon(void);
+
+static SDL_Window* gLauncherWindow = nullptr;
+static SDL_Window* gSessionWindow = nullptr;
+static bool gSessionRunning = false;
+static double gSessionRestoreTime = 0.0;
+
+bool beginEmulatorSession(bool ownWindow)
+{
+    DEBUG_PRINTF("   bool beginEmulatorSession(bool ownWindow=%d)\n",ownWindow);
+    Uint32 window_flags = SDL_GetWindowFlags(gWindow);
+    
+    if (!(window_flags & SDL_WINDOW_FULLSCREEN_DESKTOP) && !(window_flags & SDL_WINDOW_FULLSCREEN))
+    {
+        SDL_GetWindowSize(gWindow,&window_width,&window_height);
+        SDL_GetWindowPosition(gWindow,&window_x,&window_y);
+    }
+    gLauncherWindow = gWindow;
+    gSessionRunning = true;
+    // the screen manager (no gRenderer) keeps its GL context on the
+    // launcher window, every core gets a window of its own then
+    if (!gRenderer) ownWindow = true;
+    if (!ownWindow) return true;
+
+    std::string str = "marley ";
+    str += PACKAGE_VERSION;
+    gSessionWindow = SDL_CreateWindow( str.c_str(), 
+                            window_x,
+                            window_y,
+                            window_width, 
+                            window_height, 
+                            window_flags & (SDL_WINDOW_FULLSCREEN_DESKTOP | SDL_WINDOW_OPENGL | SDL_WINDOW_RESIZABLE | SDL_WINDOW_BORDERLESS) );
+    if (!gSessionWindow)
+    {
+        printf("Could not create a window for the emulator session. SDL error: %s\n", SDL_GetError());
+        gSessionRunning = false;
+        return false;
+    }
+    
+    // the core finds its window in gWindow
+    gWindow = gSessionWindow;
+    setAppIcon();
+    SDL_ShowCursor(SDL_DISABLE);
+    SDL_HideWindow(gLauncherWindow);
+    return true;
+}
+
+void endEmulatorSession(void)
+{
+    DEBUG_PRINTF("   void endEmulatorSession(void)\n");
+    Uint64 start = SDL_GetPerformanceCounter();
+    std::string str;
+    
+    if (!gSessionRunning) return;
+    gSessionRunning = false;
+    
+    restoreController();
+    
+    if (gSessionWindow)
+    {
+        gWindow = gLauncherWindow;
+        SDL_DestroyWindow(gSessionWindow);
+        gSessionWindow = nullptr;
+        SDL_ShowWindow(gWindow);
+        SDL_RaiseWindow(gWindow);
+    }
+    
+    // The screen manager keeps its GL context and textures on the hidden
+    // launcher window, it only renders the next frame (SDLMain.cpp).
+    if (gRenderer)
+    {
+        if (SDL_GetRenderer(gWindow) != gRenderer)
+        {
+            // the core did not leave the window as it found it
+            printf("Launcher window lost during emulator session, starting over\n");
+            restartGUI();
+        }
+        else
+        {
+            if (SDL_GetWindowFlags(gWindow) & (SDL_WINDOW_FULLSCREEN_DESKTOP | SDL_WINDOW_FULLSCREEN))
+            {
+                setFullscreen();
+            }
+            else
+            {
+                setWindowed();
+            }
+            
+            str = "marley ";
+            str += PACKAGE_VERSION;
+            SDL_SetWindowTitle(gWindow, str.c_str());
+            
+            // the renderer's GL context was not current during the session,
+            // its state is untouched, only the window could have changed
+            SDL_RenderSetViewport(gRenderer, nullptr);
+            SDL_SetRenderDrawBlendMode(gRenderer, SDL_BLENDMODE_BLEND);
+            SDL_ShowCursor(SDL_DISABLE);
+        }
+    }
+    
+    gSessionRestoreTime = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    printf("Back in the %s after %.2f ms\n", gRenderer ? "launcher" : "screen manager", gSessionRestoreTime);
+}
+
+double getSessionRestoreTime(void)
+{
+    return gSessionRestoreTime;
+}
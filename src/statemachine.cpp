@@ -28,6 +28,12 @@
 #include "../include/gui.h"
 #include "../include/controller.h"
 #include "../include/emu.h"
+#include "../include/library.h"
+#include "../include/watcher.h"
+#include "../include/classifier.h"
+#include "../include/session.h"
+#include "../include/mdf2iso.h"
+#include "../include/validator.h"
 #include <algorithm>
 #include <X11/Xlib.h>
 #include <fstream>
@@ -81,7 +87,6 @@ bool checkTrigger(int cmd);
 void initOpenGL(void);
 void setAppIcon(void);
 void hide_or_show_cursor_X11(bool hide);
-std::ifstream::pos_type filesize(const char* filename);
 
 void startControllerConf(int controllerNum)
 {
@@ -116,9 +121,114 @@ void resetStatemachine(void)
 
 bool exists(const char *fileName);
 bool copyFile(const char *SRC, const char* DEST);
-int mdf2iso_main (int argc, char **argv);
-void create_cue_file(string filename)
+void launch_emulator(void);
+
+int gConversionPercent = -1;
+static bool gConversionRunning = false;
+
+// Saturn mdf images mednafen cannot read are converted before the launch,
+// the UI keeps running and polls the progress
+bool startGameConversion(const string& filename)
+{
+    DEBUG_PRINTF("   bool startGameConversion(const string& filename=%s)\n",filename.c_str());
+    off_t size;
+    string ext = filename.substr(filename.find_last_of(".") + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+      [](unsigned char c){ return std::tolower(c); });
+    string bin_filename = filename.substr(0,filename.find_last_of(".")) + ".bin";
+
+    if (gConversionRunning) return false;
+    if ((ext.find("mdf") == string::npos) || exists(bin_filename.c_str())) return false;
+    if (classifyRom(filename, &size) != ROM_SATURN) return false;
+    // mednafen reads raw mdf images in place
+    if (isRawMdf(filename)) return false;
+
+    gConversionRunning = startMdf2Iso(filename, bin_filename.substr(bin_filename.find_last_of("/") + 1));
+    return gConversionRunning;
+}
+
+// true while the conversion is running, afterwards ok tells if the game can be launched
+bool pollGameConversion(int* percent, bool* ok)
+{
+    *ok = false;
+    if (!gConversionRunning) return false;
+    if (getMdf2IsoProgress(percent)) return true;
+
+    gConversionRunning = false;
+    *ok = (finishMdf2Iso() == 0);
+    if (!*ok) printf("The game is not launched, its conversion failed or was cancelled\n");
+    return false;
+}
+
+// returns after mdf2iso removed the incomplete bin file
+void cancelGameConversion(void)
+{
+    DEBUG_PRINTF("   void cancelGameConversion(void)\n");
+    if (!gConversionRunning) return;
+    cancelMdf2Iso();
+    finishMdf2Iso();
+    gConversionRunning = false;
+    gConversionPercent = -1;
+    gRedraw = true;
+}
+
+// main loop of the SDL launcher, renderScreen() shows gConversionPercent
+void pollLaunchConversion(void)
+{
+    int percent = 0;
+    bool ok;
+
+    if (gConversionPercent < 0) return;
+    if (pollGameConversion(&percent, &ok))
+    {
+        if (percent != gConversionPercent)
+        {
+            gConversionPercent = percent;
+            gRedraw = true;
+        }
+        return;
+    }
+    gConversionPercent = -1;
+    gRedraw = true;
+    if (ok) launch_emulator();
+}
+
+// writes a cue file for a bin file with a single data track.
+// A cue file of the same name has an incorrect file reference in it
+// such as FILE "game.BIN" when the actual file is called "game.bin",
+// a backup is created of the original file.
+static bool writeCueSheet(const string& binFilename)
+{
+    DEBUG_PRINTF("   bool writeCueSheet(const string& binFilename=%s)\n",binFilename.c_str());
+    string cue_filename = binFilename.substr(0,binFilename.find_last_of(".")) + ".cue";
+    string cue_filename_backup = cue_filename + ".backup";
+
+    if (exists(cue_filename.c_str())) copyFile(cue_filename.c_str(),cue_filename_backup.c_str());
+
+    std::ofstream cue_file(cue_filename.c_str(), std::ios_base::trunc);
+    if (!cue_file)
+    {
+        printf("Could not create cue file for %s\n",binFilename.c_str());
+        return false;
+    }
+    cue_file << "FILE \"" << binFilename.substr(binFilename.find_last_of("/") + 1) << "\" BINARY\n";
+    cue_file << "  TRACK 01 MODE2/2352\n";
+    cue_file << "    INDEX 01 00:00:00";
+    cue_file.close();
+    if (cue_file.fail())
+    {
+        printf("Could not create cue file for %s\n",binFilename.c_str());
+        return false;
+    }
+    return true;
+}
+
+// launchFile is set to the file to hand over to mednafen
+bool create_cue_file(const string& filename, string* launchFile)
 {
+    // Called for games the validator has not prepared yet, and for bin
+    // files the validator found without a cue sheet (it does not write
+    // into the game folders).
     // A few words on how Marley is handling cue files: Cue files are
     // detected in emu.cpp and added to the list of available games. That
     // is, if the FILE reference in the cue file points to a valid file. In
@@ -129,176 +239,82 @@ void create_cue_file(string filename)
     // This here function creates a cue file. If an invalid cue file 
     // exists, meaning the cue file's reference is broken,
     // create_cue_file creates a backup. The original cue file is overwritten.
-    // If only an mdf file exists, a cue and a bin file are created.
+    // If only an mdf file exists, mednafen reads it in place (raw data
+    // tracks, CDAccess_Image). Other mdf files have been converted to cue
+    // and bin by startGameConversion() before the launch.
+    // The game list is not changed, the cue file shows up in it when the
+    // library watcher reports it.
     
     string ext = filename.substr(filename.find_last_of(".") + 1);
     std::transform(ext.begin(), ext.end(), ext.begin(),
       [](unsigned char c){ return std::tolower(c); });
     string bin_filename = filename.substr(0,filename.find_last_of(".")) + ".bin";
     string cue_filename = filename.substr(0,filename.find_last_of(".")) + ".cue";
-    string cue_filename_backup = cue_filename + ".backup";
+    *launchFile = filename;
     if (ext.find("bin") != string::npos) 
     {
-        // If the cue file already exists, it has in incorrect file reference in it
-        // such as FILE "game.BIN" when the actual file is called "game.bin".
-        // A back up is created of the original file
-        if (exists(cue_filename.c_str())) copyFile(cue_filename.c_str(),cue_filename_backup.c_str());
-        
-        std::ofstream cue_file;
-
-        cue_file.open(cue_filename.c_str(), std::ios_base::trunc); 
-        if(cue_file) 
-        {
-            cue_file << "FILE \"";
-            if (filename.find_last_of("/") != string::npos)
-            {
-                cue_file << filename.substr(filename.find_last_of("/")+1);
-            }
-            else
-            {
-                cue_file << filename;
-            }
-            cue_file << "\" BINARY\n";
-            cue_file << "  TRACK 01 MODE2/2352\n";
-            cue_file << "    INDEX 01 00:00:00";
-            cue_file.close();
-            // replace bin file
-        }
-        else
-        {
-            printf("Could not create cue file for %s\n",filename.c_str());
-        }
+        // If the cue file already exists, it has in incorrect file reference in it.
+        if (!writeCueSheet(filename)) return false;
     }
     else if ((ext.find("mdf") != string::npos) && (!exists(bin_filename.c_str())))
     {
-        string bin_filename_no_path = bin_filename;
-        if (bin_filename.find("/") != string::npos)
+        if (isRawMdf(filename))
         {
-            bin_filename_no_path = bin_filename.substr(bin_filename.find_last_of("/") + 1);
+            // mednafen reads the mdf file in place
+            return true;
         }
-        char *argv[4]; 
-        char arg1[10] = "mdf2iso"; 
-        char arg2[10] = "--cue";
-        char arg3[1024];
-        char arg4[1024];
-        strcpy(arg3, filename.c_str());  
-        strcpy(arg4, bin_filename_no_path.c_str());
-
-        argv[0] = arg1;
-        argv[1] = arg2;
-        argv[2] = arg3;
-        argv[3] = arg4;
-        
-        mdf2iso_main (4, argv);
+        printf("Cannot launch %s: it was not converted\n",filename.c_str());
+        return false;
     }
-    gGame[gCurrentGame] = cue_filename;
+    else if ((ext.find("mdf") != string::npos) && (!exists(cue_filename.c_str())))
+    {
+        printf("Cannot launch %s: %s is missing\n",filename.c_str(),cue_filename.c_str());
+        return false;
+    }
+    *launchFile = cue_filename;
+    return true;
 }
 
-#define BUFSIZE 1024
-enum emulator_target
-{
-    unknown,
-    mednafen,
-    dolphin,
-    mupen64plus,
-    ppsspp,
-    pcsx2
-};
-emulator_target getEmulatorTarget(string filename)
+// launchFile is set to the file to hand over to the emulator,
+// the game list is left alone
+emulator_target getEmulatorTarget(const string& filename, string* launchFile)
 {
-    string cmd = "file -b \"" + filename + "\"";
-    string file_type;
-    char buf[BUFSIZE];
-    FILE *fp;
-    bool ok = false;
+    static const char* emulatorNames[] = {"unknown", "mednafen", "dolphin", "mupen64plus", "ppsspp", "pcsx2"};
     emulator_target emu = unknown;
+    rom_type type;
+    off_t size;
+    int libraryTarget;
+    bool needsCueSheet;
     
-    if ((fp = popen(cmd.c_str(), "r")) == nullptr) 
-    {
-        printf("Error opening pipe for command %s\n",cmd.c_str());
-    }
-    else
+    *launchFile = filename;
+    
+    // prepared by the validator, no file access
+    if (getLibraryLaunch(filename, &libraryTarget, launchFile, &needsCueSheet))
     {
-        if (fgets(buf, BUFSIZE, fp) != nullptr) 
-        {
-            file_type = buf;
-            ok = true;
-        }
-        
-        if(pclose(fp))  
+        if (libraryTarget == LIBRARY_TARGET_UNKNOWN)
         {
-            printf("Command '%s' not found or exited with error status\n",cmd.c_str());
-            ok = false;
+            printf("Cannot launch %s: missing FILE references\n",filename.c_str());
         }
+        if (needsCueSheet && !writeCueSheet(filename)) return unknown;
+        return (emulator_target)libraryTarget;
     }
     
-    if (ok)
+    // classified before and unchanged since
+    libraryTarget = getLibraryTarget(filename);
+    if (libraryTarget != LIBRARY_TARGET_UNKNOWN)
     {
-        
-        std::transform(file_type.begin(), file_type.end(), file_type.begin(),
-            [](unsigned char c){ return std::tolower(c); });
-        
-        if ((file_type.find("nintendo wii") != string::npos) || (file_type.find("nintendo gamecube") != string::npos))
-        {
-            emu = dolphin; 
-            printf("dolphin ");
-        }
-        else if (file_type.find("game boy") != string::npos)
-        {
-            emu = mednafen;
-            printf("mednafen ");
-        }
-        else if ((file_type.find("sega mega drive") != string::npos) || (file_type.find("genesis") != string::npos))
-        {
-            emu = mednafen;
-            printf("mednafen ");
-        }
-        else if (file_type.find("sega saturn") != string::npos)
-        {
-            create_cue_file(filename);
-            emu = mednafen;
-            printf("mednafen ");
-        }
-        else if (file_type.find("nes rom") != string::npos)
-        {
-            emu = mednafen;
-            printf("mednafen ");
-        }
-        else if (file_type.find("nintendo 64") != string::npos)
-        {
-            emu = mupen64plus;
-            printf("mupen64plus ");
-        }
-        else
-        {
-            long fsize = filesize(filename.c_str());
-            if (fsize < 52428800) // less than 50MB must be either mednafen or mupen64plus
-            {
-                string ext = filename.substr(filename.find_last_of(".") + 1);
-                if (ext.find("64") != string::npos) 
-                {
-                    emu = mupen64plus;
-                }
-                else
-                {
-                    emu = mednafen;
-                }
-            }
-            else
-            {
-                if (file_type.find("iso 9660 cd-rom filesystem data") != string::npos)
-                {
-                    emu = ppsspp;
-                    printf("ppsspp ");
-                }
-                else 
-                {
-                    emu = pcsx2;
-                    printf("pcsx2 ");
-                }
-            }
-        }
+        return (emulator_target)libraryTarget;
     }
+    
+    type = classifyRom(filename, &size);
+    if ((type == ROM_SATURN) && !create_cue_file(filename, launchFile))
+    {
+        return unknown;
+    }
+    emu = getRomTarget(type, filename, size);
+    printf("%s ",emulatorNames[emu]);
+    
+    if (type != ROM_SATURN) setLibraryTarget(filename, emu);
 
     return emu;
 }
@@ -364,6 +380,7 @@ void launch_emulator(void)
         
         int n;
         string str;
+        bool sessionWindow;
         Uint32 window_flags;
         window_flags=SDL_GetWindowFlags(gWindow);
         if (!(window_flags & SDL_WINDOW_FULLSCREEN_DESKTOP) && !(window_flags & SDL_WINDOW_FULLSCREEN))
@@ -374,17 +391,36 @@ void launch_emulator(void)
         
         argc = 2;
         emulator_target emulatorTarget;
+        string launchFile;
+        // the validator does not compete with the game for the disk
+        stopValidator();
         if (launch_request_from_screen_manager)
-          emulatorTarget = getEmulatorTarget(game_screen_manager);
+          emulatorTarget = getEmulatorTarget(game_screen_manager, &launchFile);
         else
-          emulatorTarget = getEmulatorTarget(gGame[gCurrentGame]);
+          emulatorTarget = getEmulatorTarget(gGame[gCurrentGame], &launchFile);
         switch((int)emulatorTarget)
         {
 #ifdef PCSX2
             case pcsx2:
             
-                if (pcsx2_window_tear_down) tear_down_and_create_new_window();
                 pcsx2_window_tear_down_auto_request = 0;
+                sessionWindow = false;
+                // the screen manager (no gRenderer) keeps its GL context on
+                // the launcher window, it cannot be torn down meanwhile
+                if (pcsx2_window_tear_down && gRenderer)
+                {
+                    tear_down_and_create_new_window();
+                }
+                else
+                {
+                    // PCSX2 gets a window of its own, the launcher stays resident
+                    sessionWindow = beginEmulatorSession(true);
+                    if (!sessionWindow)
+                    {
+                        if (!gRenderer) break;
+                        tear_down_and_create_new_window();
+                    }
+                }
                 str = "pcsx2";
                 strcpy(arg1, str.c_str()); 
                 
@@ -394,10 +430,7 @@ void launch_emulator(void)
                 str = "--fullboot";
                 strcpy(arg3, str.c_str());
                 
-                if (launch_request_from_screen_manager)
-                  str = game_screen_manager;
-                else
-                  str = gGame[gCurrentGame];
+                str = launchFile;
                 strcpy(arg4, str.c_str());
 
                 argv[0] = arg1;
@@ -420,9 +453,18 @@ void launch_emulator(void)
                     pcsx2_main(argc,argv);
                     if (pcsx2_window_tear_down_auto_request == 1)
                     {
-                        // try again with window tear down
-                        pcsx2_window_tear_down = true;
-                        tear_down_and_create_new_window();
+                        // try again with a new window
+                        if (sessionWindow)
+                        {
+                            endEmulatorSession();
+                            sessionWindow = beginEmulatorSession(true);
+                        }
+                        if (!sessionWindow)
+                        {
+                            if (!gRenderer) break;
+                            pcsx2_window_tear_down = true;
+                            tear_down_and_create_new_window();
+                        }
                         str = "pcsx2";
                         strcpy(arg1, str.c_str()); 
                         
@@ -432,10 +474,7 @@ void launch_emulator(void)
                         str = "--fullboot";
                         strcpy(arg3, str.c_str());
                         
-                        if (launch_request_from_screen_manager)
-                          str = game_screen_manager;
-                        else
-                          str = gGame[gCurrentGame];
+                        str = launchFile;
                         strcpy(arg4, str.c_str());
 
                         argv[0] = arg1;
@@ -456,25 +495,26 @@ void launch_emulator(void)
 
                             }
                             pcsx2_main(argc,argv);
-                            restartGUI();
                         } 
                         else
                         {
                             printf("jc SDL_GetWindowWMInfo(gWindow, &sdlWindowInfo) failed\n");
                         }
-                        
-                        
-                        
-                        
                     }
-                    restartGUI();
                 } 
                 else
                 {
                     printf("jc SDL_GetWindowWMInfo(gWindow, &sdlWindowInfo) failed\n");
                 }
                 
-
+                if (sessionWindow)
+                {
+                    endEmulatorSession();
+                }
+                else
+                {
+                    restartGUI();
+                }
                 break;
 #endif
 
@@ -485,17 +525,15 @@ void launch_emulator(void)
                 str = "mupen64plus";
                 strcpy(arg1, str.c_str()); 
                 
-                if (launch_request_from_screen_manager)
-                  str = game_screen_manager;
-                else
-                  str = gGame[gCurrentGame];
+                str = launchFile;
                 strcpy(arg2, str.c_str()); 
                 
                 argv[0] = arg1;
                 argv[1] = arg2;
                 printf("arg1: %s arg2: %s \n",arg1,arg2);
+                beginEmulatorSession(false);
                 mupen64plus_main(argc,argv);
-                restoreSDL();
+                endEmulatorSession();
                 break;
 #endif
 
@@ -506,18 +544,16 @@ void launch_emulator(void)
                 str = "ppsspp";
                 strcpy(arg1, str.c_str()); 
                 
-                if (launch_request_from_screen_manager)
-                  str = game_screen_manager;
-                else
-                  str = gGame[gCurrentGame];
+                str = launchFile;
                 strcpy(arg2, str.c_str()); 
                 
                 argv[0] = arg1;
                 argv[1] = arg2;
                 printf("arg1: %s arg2: %s \n",arg1,arg2);
+                beginEmulatorSession(false);
                 ppsspp_main(argc,argv);
                 
-                restoreSDL();
+                endEmulatorSession();
                 break;
 #endif
 
@@ -527,20 +563,18 @@ void launch_emulator(void)
                 str = "dolphin-emu";
                 strcpy(arg1, str.c_str()); 
                 
-                if (launch_request_from_screen_manager)
-                  str = game_screen_manager;
-                else
-                  str = gGame[gCurrentGame];
+                str = launchFile;
                 strcpy(arg2, str.c_str()); 
                 
                 argv[0] = arg1;
                 argv[1] = arg2;
                 printf("arg1: %s arg2: %s \n",arg1,arg2);
                 marley_wiimote = false;
+                beginEmulatorSession(false);
                 dolphin_main(argc,argv);
                 marley_wiimote = true;
                 delay_after_shutdown = 10;
-                restoreSDL();
+                endEmulatorSession();
                 break;
 #endif
         
@@ -550,23 +584,22 @@ void launch_emulator(void)
                 str = "mednafen"; 
                 strcpy(arg1, str.c_str()); 
                 
-                if (launch_request_from_screen_manager)
-                  str = game_screen_manager;
-                else
-                  str = gGame[gCurrentGame];
+                str = launchFile;
                 strcpy(arg2, str.c_str()); 
                 
                 argv[0] = arg1;
                 argv[1] = arg2;
                 printf("arg1: %s arg2: %s \n",arg1,arg2);
+                beginEmulatorSession(false);
                 mednafen_main(argc,argv);
-                restoreSDL();
+                endEmulatorSession();
                 break;
 #endif
             default:
                 (void) 0;
                 break;
         }
+        startValidator(gGame);
     }
 }
 
@@ -581,6 +614,13 @@ void statemachine(int cmd)
     int n;
     string str;
     
+    // only a cancel is taken while an mdf image is converted
+    if (gConversionPercent >= 0)
+    {
+        if ((cmd == SDL_CONTROLLER_BUTTON_GUIDE) || (cmd == SDL_CONTROLLER_BUTTON_B)) cancelGameConversion();
+        return;
+    }
+    
     if (!gControllerConf)
     {
         switch (cmd)
@@ -792,6 +832,7 @@ void statemachine(int cmd)
                     case STATE_CONFIG:
                         freeTextures();
                         SDL_DestroyRenderer( gRenderer );
+                        gRenderer = nullptr;
                         do
                         {
                             str = "screen_manager";
@@ -804,16 +845,14 @@ void statemachine(int cmd)
                             launch_request_from_screen_manager = false;
                             restart_screen_manager = false;
                             
+                            // games are launched from within screen_manager_main(),
+                            // it stays resident until marley is closed
                             screen_manager_main(screen_man_argc,screen_man_argv);
                             if (shutdown_now)
                             {
                                 shutdown_computer();
-                            } else
-                            if (launch_request_from_screen_manager)
-                            {
-                                launch_emulator();
                             }
-                        } while (launch_request_from_screen_manager || restart_screen_manager);
+                        } while (restart_screen_manager);
                         gQuit=true;
                         break;
                     case STATE_OFF:
@@ -868,6 +907,7 @@ void statemachine(int cmd)
                                     checkFirmwarePSX();
                                     if (stopSearching)
                                     {
+                                        stopLibraryWatcher();
                                         gGame.clear();
                                         gGamesFound=false;
                                         gPS1_firmware=false;
@@ -932,6 +972,13 @@ void statemachine(int cmd)
                         }
                         break;
                     case STATE_LAUNCH:
+                        // an mdf image is converted first, see pollLaunchConversion()
+                        if (startGameConversion(gGame[gCurrentGame]))
+                        {
+                            gConversionPercent = 0;
+                            gRedraw = true;
+                            break;
+                        }
                         launch_emulator();
                         break;
                     default:
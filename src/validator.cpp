@@ -0,0 +1,225 @@
+/* Marley Copyright (c) 2021 Marley Development Team 
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <string>
+#include <vector>
+#include <list>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "../include/log.h"
+#include "../include/library.h"
+#include "../include/classifier.h"
+#include "../include/mdf2iso.h"
+#include "../include/validator.h"
+
+bool exists(const char *fileName);
+bool checkForCueFiles(std::string str_with_path,std::list<std::string> *toBeRemoved);
+
+static std::thread gValidatorThread;
+static std::atomic<bool> gValidatorCancel(false);
+static std::atomic<bool> gValidatorBusy(false);
+
+static std::string getExtension(const std::string& filename)
+{
+    std::string ext = filename.substr(filename.find_last_of(".") + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+      [](unsigned char c){ return std::tolower(c); });
+    return ext;
+}
+
+static std::string getFileName(const std::string& filename)
+{
+    size_t slash = filename.find_last_of("/");
+    return (slash == std::string::npos) ? filename : filename.substr(slash + 1);
+}
+
+// true if the cue file next to the bin file references it
+static bool hasCueSheet(const std::string& binFilename)
+{
+    std::string cue_filename = binFilename.substr(0,binFilename.find_last_of(".")) + ".cue";
+    std::list<std::string> references;
+
+    if (!exists(cue_filename.c_str())) return false;
+    if (!checkForCueFiles(cue_filename, &references)) return false;
+    return (std::find(references.begin(), references.end(), getFileName(binFilename)) != references.end());
+}
+
+// Saturn games are launched with a cue file, or in place for raw mdf images.
+// Other mdf images are converted when they are launched (mdf2iso.h).
+// Nothing is written into the game folders, a missing cue sheet is
+// reported and written by the launcher when the game is started.
+static bool prepareSaturnGame(const std::string& filename, T_LibraryFile* file)
+{
+    std::string ext = getExtension(filename);
+
+    if (ext == "bin")
+    {
+        std::string cue_filename = filename.substr(0,filename.find_last_of(".")) + ".cue";
+        if (!hasCueSheet(filename))
+        {
+            printf("Validator: %s has no cue sheet, it is written at launch\n",filename.c_str());
+            file->status = LIBRARY_STATUS_NO_CUE;
+        }
+        file->launch = getFileName(cue_filename);
+        return true;
+    }
+    if ((ext == "mdf") && isRawMdf(filename))
+    {
+        return true;
+    }
+    return false;
+}
+
+// the bin files launched with a cue file that turned broken get their
+// cue sheet written at launch again
+static void invalidateCueLaunch(const std::string& cueFilename, std::list<std::string> references)
+{
+    std::string directory = cueFilename.substr(0,cueFilename.find_last_of("/")+1);
+    std::string cueName = getFileName(cueFilename);
+
+    references.push_back(cueName.substr(0,cueName.find_last_of(".")) + ".bin");
+    for (const std::string& reference : references)
+    {
+        T_LibraryFile bin;
+        if (!getLibraryFile(directory + reference, &bin)) continue;
+        if ((bin.launch != cueName) || (bin.status != LIBRARY_STATUS_READY)) continue;
+
+        printf("Validator: %s lost its cue sheet, it is written at launch\n",(directory + reference).c_str());
+        bin.status = LIBRARY_STATUS_NO_CUE;
+        setLibraryFile(directory + reference, bin);
+    }
+}
+
+// returns true if the library entry of the game was updated
+static bool validateGame(const std::string& filename)
+{
+    T_LibraryFile file;
+    struct stat fileStat;
+    std::string ext;
+
+    // games outside the library index are prepared when they are launched
+    if (!getLibraryFile(filename, &file)) return false;
+    if (stat(filename.c_str(), &fileStat) != 0) return false;
+
+    bool unchanged = ((fileStat.st_size == file.size) && (fileStat.st_ino == file.inode));
+    ext = getExtension(filename);
+
+    // the FILE references of cue files are checked on every pass, they are cheap,
+    // so are the cue sheets bin files are launched with, they can be deleted or
+    // rewritten while the bin file stays the same
+    bool cueLaunch = ((ext == "bin") && !file.launch.empty());
+    if (unchanged && (file.status != LIBRARY_STATUS_NONE) && !cueLaunch && (ext != "cue")) return false;
+
+    T_LibraryFile validated = file;
+    validated.size   = fileStat.st_size;
+    validated.inode  = fileStat.st_ino;
+    validated.status = LIBRARY_STATUS_READY;
+    validated.launch.clear();
+
+    if (!unchanged || (file.target == LIBRARY_TARGET_UNKNOWN))
+    {
+        off_t size;
+        rom_type type = classifyRom(filename, &size);
+        if (size == 0) return false;
+        validated.target = getRomTarget(type, filename, size);
+        if ((type == ROM_SATURN) && !prepareSaturnGame(filename, &validated)) return false;
+    }
+    else
+    {
+        validated.launch = file.launch;
+        if (cueLaunch && !hasCueSheet(filename))
+        {
+            if (file.status != LIBRARY_STATUS_NO_CUE)
+            {
+                printf("Validator: %s lost its cue sheet, it is written at launch\n",filename.c_str());
+            }
+            validated.status = LIBRARY_STATUS_NO_CUE;
+        }
+    }
+
+    if (ext == "cue")
+    {
+        std::list<std::string> references;
+        if (!checkForCueFiles(filename, &references))
+        {
+            printf("Validator: %s has missing FILE references\n",filename.c_str());
+            validated.status = LIBRARY_STATUS_BROKEN;
+            if (file.status != LIBRARY_STATUS_BROKEN) invalidateCueLaunch(filename, references);
+        }
+    }
+
+    if (unchanged && (validated.status == file.status) && (validated.target == file.target) &&
+        (validated.launch == file.launch))
+    {
+        return false;
+    }
+    return setLibraryFile(filename, validated);
+}
+
+static void validatorThread(std::vector<std::string> games)
+{
+    int updated = 0;
+
+    for (const std::string& game : games)
+    {
+        if (gValidatorCancel) break;
+        if (validateGame(game)) updated++;
+    }
+    if (updated)
+    {
+        printf("Validator: %d of %lu games prepared\n",updated,games.size());
+        saveLibraryIndex();
+    }
+    gValidatorBusy = false;
+}
+
+// validates the games on a background thread, a running pass is cancelled
+void startValidator(const std::vector<std::string>& games)
+{
+    DEBUG_PRINTF("   void startValidator(const std::vector<std::string>& games)\n");
+    stopValidator();
+    if (games.empty()) return;
+
+    gValidatorCancel = false;
+    gValidatorBusy = true;
+    gValidatorThread = std::thread(validatorThread, games);
+}
+
+// returns after the game being validated is done
+void stopValidator(void)
+{
+    DEBUG_PRINTF("   void stopValidator(void)\n");
+    if (!gValidatorThread.joinable()) return;
+
+    gValidatorCancel = true;
+    gValidatorThread.join();
+}
+
+bool validatorBusy(void)
+{
+    return gValidatorBusy;
+}
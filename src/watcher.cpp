@@ -0,0 +1,479 @@
+/* Marley Copyright (c) 2021 Marley Development Team
+   https://github.com/beaumanvienna/marley
+
+   Permission is hereby granted, free of charge, to any person
+   obtaining a copy of this software and associated documentation files
+   (the "Software"), to deal in the Software without restriction,
+   including without limitation the rights to use, copy, modify, merge,
+   publish, distribute, sublicense, and/or sell copies of the Software,
+   and to permit persons to whom the Software is furnished to do so,
+   subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be
+   included in all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+   IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+   CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+   TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+   SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#include "../include/log.h"
+#include "../include/emu.h"
+#include "../include/statemachine.h"
+#include "../include/library.h"
+#include "../include/crawler.h"
+#include "../include/watcher.h"
+#include "../include/validator.h"
+
+#define WATCH_MASK          (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+#define WATCH_BUFFER_SIZE   65536
+
+typedef struct LibrarySync {
+    std::string directory;  // with trailing slash
+    bool recursive;
+    bool all;               // part of the search after an event queue overflow
+} T_LibrarySync;
+
+static int gWatchFd = -1;
+static std::unordered_map<int, std::string> gWatches;   // watch descriptor -> folder with trailing slash
+static std::vector<std::string> gWatchRoots;
+static std::unordered_map<std::string, int> gFolderGeneration;
+static int gWatchGeneration = 0;
+static int gRescanGeneration = 0;
+static bool gWatchLimitReached = false;
+
+// Folders are searched one at a time on the crawler threads, the UI thread
+// collects the results in pollLibraryWatcher() and replaces the entries of
+// the folder in gGame once the search is complete.
+static std::deque<T_LibrarySync> gSyncQueue;
+static T_LibrarySync gSync;
+static bool gSyncRunning = false;
+static std::list<string> gSyncGames;
+static std::list<string> gSyncCueReferences;
+
+static bool isInFolder(const std::string& filename, const std::string& directory, bool recursive)
+{
+    if (filename.compare(0, directory.length(), directory) != 0) return false;
+    return (recursive || (filename.find('/', directory.length()) == std::string::npos));
+}
+
+static bool addWatch(const std::string& directory)
+{
+    int wd = inotify_add_watch(gWatchFd, directory.c_str(), WATCH_MASK | IN_ONLYDIR);
+    if (wd < 0)
+    {
+        if ((errno == ENOSPC) && !gWatchLimitReached)
+        {
+            printf("Library watcher: inotify watch limit reached, see /proc/sys/fs/inotify/max_user_watches\n");
+            gWatchLimitReached = true;
+        }
+        return false;
+    }
+    // a renamed folder keeps its watch descriptor
+    gWatches[wd] = directory;
+    return true;
+}
+
+static void addWatchTree(const std::string& directory)
+{
+    DIR* dir;
+    struct dirent* ent;
+    struct stat entry_stat;
+
+    if (!addWatch(directory)) return;
+
+    if ((dir = opendir(directory.c_str())) == nullptr) return;
+    while ((ent = readdir(dir)) != nullptr)
+    {
+        if ((strcmp(ent->d_name, ".") == 0) || (strcmp(ent->d_name, "..") == 0)) continue;
+
+        bool isDir = (ent->d_type == DT_DIR);
+        if (ent->d_type == DT_UNKNOWN)
+        {
+            isDir = ((fstatat(dirfd(dir), ent->d_name, &entry_stat, AT_SYMLINK_NOFOLLOW) == 0) && S_ISDIR(entry_stat.st_mode));
+        }
+        if (isDir) addWatchTree(directory + ent->d_name + "/");
+    }
+    closedir(dir);
+}
+
+static void removeWatchTree(const std::string& directory)
+{
+    for (auto it = gWatches.begin(); it != gWatches.end();)
+    {
+        if (isInFolder(it->second, directory, true))
+        {
+            inotify_rm_watch(gWatchFd, it->first);
+            it = gWatches.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+static bool isWatched(const std::string& directory)
+{
+    for (const std::string& root : gWatchRoots)
+    {
+        if (isInFolder(directory, root, true)) return true;
+    }
+    return false;
+}
+
+static void queueSync(const std::string& directory, bool recursive, bool all)
+{
+    for (T_LibrarySync& sync : gSyncQueue)
+    {
+        if (sync.directory == directory)
+        {
+            sync.recursive = sync.recursive || recursive;
+            sync.all = sync.all || all;
+            return;
+        }
+        if (sync.recursive && isInFolder(directory, sync.directory, true)) return;
+    }
+    gSyncQueue.push_back({directory, recursive, all});
+}
+
+static void abortSync(void)
+{
+    if (!gSyncRunning) return;
+    cancelCrawler();
+    stopCrawler();
+    gSyncGames.clear();
+    gSyncCueReferences.clear();
+    gSyncRunning = false;
+}
+
+static void startNextSync(void)
+{
+    while (!gSyncRunning && !gSyncQueue.empty())
+    {
+        T_LibrarySync sync = gSyncQueue.front();
+        // dropped from the watched folders since, e.g. by a new game search
+        if (!isWatched(sync.directory))
+        {
+            gSyncQueue.pop_front();
+            continue;
+        }
+        int mode = CRAWL_GAMES | CRAWL_CLASSIFY;
+        if (sync.recursive) mode |= CRAWL_RECURSIVE;
+        // the crawler is in use by a game search, tried again on the next poll
+        if (!startCrawler(sync.directory, mode)) return;
+
+        gSyncQueue.pop_front();
+        gSync = sync;
+        gSyncRunning = true;
+        // folders changed since buildGameList(), its bios files could be outdated
+        invalidateBiosCandidates();
+    }
+}
+
+// takes the folders read by the crawler so far, true when the search is done
+static bool collectSync(void)
+{
+    T_CrawlerResult* result;
+    struct stat dir_stat;
+    // all results are queued once the workers are finished
+    bool done = !crawlerBusy();
+
+    while ((result = popCrawlerResult()) != nullptr)
+    {
+        for (const T_LibraryFile& file : result->entry.files)
+        {
+            gSyncGames.push_back(result->directory + file.name);
+        }
+        for (const std::string& cueReference : result->entry.cueReferences)
+        {
+            gSyncCueReferences.push_back(cueReference);
+        }
+        if (!result->fromLibrary) setLibraryDir(result->directory, result->entry);
+
+        // sub folders are watched once they are read, a folder
+        // that changed in between is searched again
+        if (gSync.recursive && addWatch(result->directory) &&
+            (stat(result->directory.c_str(), &dir_stat) == 0) &&
+            ((dir_stat.st_mtim.tv_sec != result->entry.mtime_sec) ||
+             (dir_stat.st_mtim.tv_nsec != result->entry.mtime_nsec)))
+        {
+            queueSync(result->directory, false, false);
+        }
+        delete result;
+    }
+    return done;
+}
+
+// replaces the entries of the folder in gGame with the search result
+static void finishSync(void)
+{
+    DEBUG_PRINTF("   static void finishSync(void) directory=%s, recursive=%d\n",gSync.directory.c_str(),gSync.recursive);
+    stopCrawler();
+    gSyncRunning = false;
+    stripList(&gSyncGames,&gSyncCueReferences); // strip cue file entries
+
+    std::unordered_set<std::string> found(gSyncGames.begin(), gSyncGames.end());
+    for (auto it = gGame.begin(); it != gGame.end();)
+    {
+        if (isInFolder(*it, gSync.directory, gSync.recursive) && !found.count(*it))
+        {
+            it = gGame.erase(it);
+        }
+        else
+        {
+            found.erase(*it);
+            it++;
+        }
+    }
+    for (const std::string& game : gSyncGames)
+    {
+        if (found.erase(game)) gGame.push_back(game);
+    }
+    gSyncGames.clear();
+    gSyncCueReferences.clear();
+
+    gWatchGeneration++;
+    if (gSync.all)
+    {
+        gRescanGeneration = gWatchGeneration;
+    }
+    else
+    {
+        gFolderGeneration[gSync.directory] = gWatchGeneration;
+    }
+}
+
+static void removeFolder(const std::string& directory)
+{
+    DEBUG_PRINTF("   static void removeFolder(const std::string& directory=%s)\n",directory.c_str());
+    for (auto it = gGame.begin(); it != gGame.end();)
+    {
+        if (isInFolder(*it, directory, true))
+        {
+            it = gGame.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+// true if a parent folder is in the set as well
+static bool hasParentIn(const std::string& directory, const std::set<std::string>& folders)
+{
+    for (const std::string& folder : folders)
+    {
+        if ((folder.length() < directory.length()) && isInFolder(directory, folder, true)) return true;
+    }
+    return false;
+}
+
+bool watchLibraryFolder(const std::string& directory)
+{
+    DEBUG_PRINTF("   bool watchLibraryFolder(const std::string& directory=%s)\n",directory.c_str());
+    std::string root = directory;
+
+    if (root.empty()) return false;
+    if (root.back() != '/') root += "/";
+
+    if (gWatchFd < 0)
+    {
+        gWatchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (gWatchFd < 0)
+        {
+            printf("Library watcher: inotify not available (%s)\n",strerror(errno));
+            return false;
+        }
+    }
+
+    for (const std::string& watchRoot : gWatchRoots)
+    {
+        if (isInFolder(root, watchRoot, true)) return true;
+    }
+    gWatchRoots.push_back(root);
+    addWatchTree(root);
+    return true;
+}
+
+void stopLibraryWatcher(void)
+{
+    DEBUG_PRINTF("   void stopLibraryWatcher(void)\n");
+    abortSync();
+    gSyncQueue.clear();
+    if (gWatchFd >= 0)
+    {
+        close(gWatchFd);
+        gWatchFd = -1;
+    }
+    gWatches.clear();
+    gWatchRoots.clear();
+    gWatchLimitReached = false;
+}
+
+bool pollLibraryWatcher(void)
+{
+    char buffer[WATCH_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event* event;
+    std::set<std::string> changedFolders;
+    std::set<std::string> newFolders;
+    std::set<std::string> removedFolders;
+    bool rescanAll = false;
+    bool changed = false;
+    ssize_t length;
+
+    if (gWatchFd < 0) return false;
+
+    while ((length = read(gWatchFd, buffer, sizeof(buffer))) > 0)
+    {
+        for (char* ptr = buffer; ptr < buffer + length; ptr += sizeof(struct inotify_event) + event->len)
+        {
+            event = (const struct inotify_event*) ptr;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                rescanAll = true;
+                continue;
+            }
+
+            auto it = gWatches.find(event->wd);
+            if (it == gWatches.end()) continue;
+            if (event->mask & IN_IGNORED)
+            {
+                gWatches.erase(it);
+                continue;
+            }
+            if (event->len == 0) continue;
+
+            std::string directory = it->second;
+            std::string path = directory + event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                path += "/";
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    newFolders.insert(path);
+                    removedFolders.erase(path);
+                }
+                else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                {
+                    removedFolders.insert(path);
+                    newFolders.erase(path);
+                }
+                changedFolders.insert(directory);
+            }
+            else if (event->mask & (IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO))
+            {
+                // a new file is picked up when it is completely written (IN_CLOSE_WRITE),
+                // a file written in place keeps the mtime of its folder
+                if (event->mask & IN_CLOSE_WRITE) invalidateLibraryFile(path);
+                changedFolders.insert(directory);
+            }
+        }
+    }
+
+    if (rescanAll)
+    {
+        printf("Library watcher: event queue overflow, searching all game folders\n");
+        abortSync();
+        gSyncQueue.clear();
+        for (const std::string& root : gWatchRoots)
+        {
+            queueSync(root, true, true);
+        }
+    }
+    else
+    {
+        if (!removedFolders.empty()) gWatchGeneration++;
+        for (const std::string& directory : removedFolders)
+        {
+            removeWatchTree(directory);
+            removeFolder(directory);
+            gFolderGeneration[directory] = gWatchGeneration;
+            changed = true;
+        }
+        for (const std::string& directory : newFolders)
+        {
+            if (hasParentIn(directory, newFolders)) continue;
+            // watch first, files arriving during the search are reported later
+            addWatch(directory);
+            queueSync(directory, true, false);
+        }
+        for (const std::string& directory : changedFolders)
+        {
+            if (newFolders.count(directory) || hasParentIn(directory, newFolders)) continue;
+            if (hasParentIn(directory, removedFolders)) continue;
+            if (!isDirectory(directory.c_str())) continue;
+            queueSync(directory, false, false);
+        }
+    }
+
+    if (gSyncRunning && collectSync())
+    {
+        finishSync();
+        changed = true;
+    }
+    startNextSync();
+    if (!changed) return false;
+
+    gGamesFound = (gGame.size() > 0);
+    if (gCurrentGame >= (int)gGame.size()) gCurrentGame = gGame.size() ? gGame.size() - 1 : 0;
+
+    // the validator is restarted once, after the last folder
+    if (!gSyncRunning && gSyncQueue.empty())
+    {
+        saveLibraryIndex();
+        printf("Library watcher: %lu games\n",gGame.size());
+        startValidator(gGame);
+    }
+    return true;
+}
+
+// lets a game search use the crawler, the folder is searched again afterwards
+void cancelLibraryRescan(void)
+{
+    DEBUG_PRINTF("   void cancelLibraryRescan(void)\n");
+    if (!gSyncRunning) return;
+    gSyncQueue.push_front(gSync);
+    abortSync();
+}
+
+bool libraryFolderChanged(const std::string& directory, int* generation)
+{
+    std::string folder = directory;
+    bool changed = false;
+
+    if (folder.empty() || (folder.back() != '/')) folder += "/";
+
+    if (gRescanGeneration > *generation)
+    {
+        changed = true;
+    }
+    else
+    {
+        auto it = gFolderGeneration.find(folder);
+        changed = ((it != gFolderGeneration.end()) && (it->second > *generation));
+    }
+    *generation = gWatchGeneration;
+    return changed;
+}
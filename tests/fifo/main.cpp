@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/Atomic.h"
+#include "Common/BlockingLoop.h"
+#include "Core/FifoPlayer/FifoDataFile.h"
+
+// Microbenchmark for the CPU -> GPU FIFO of Dolphin's dual core mode (VideoCommon/Fifo.cpp).
+//
+// The command stream of a FIFO log (.dff, recorded with the FIFO player) is replayed through
+// the same transport: the CPU thread writes 32-byte blocks into a ring, adds to the distance
+// and wakes the GPU thread, which runs in a Common::BlockingLoop. The GPU thread copies the
+// blocks out and publishes the read side as RunGpuLoop() does. Decoding is replaced by a pass
+// over the data, so only the synchronisation is measured.
+//
+// burst:  the stream as fast as possible, blocks per second and CPU time of both threads
+// paced:  60 frames per second, CPU time the idle GPU thread burns per frame
+//
+// Every run compares the old behaviour (one block per update, polling until the 1 kHz
+// throttle tick) with the batched one (GPUFifoBatch, GPUSpinTime).
+//
+// usage: ./FIFO <file.dff> [repeats] [batch] [spin time in us]
+
+#define RING_SIZE (1024 * 1024)
+#define BLOCK_SIZE 32
+#define PACED_FRAMES 120
+
+struct Config
+{
+    const char* name;
+    unsigned batch;
+    int spinUs;
+};
+
+struct Result
+{
+    double seconds;
+    double producerCpu;
+    double consumerCpu;
+    unsigned long long fullStalls;
+};
+
+// the ring, as the CP FIFO in emulated memory
+static u8 gRing[RING_SIZE];
+alignas(64) static volatile u32 gDistance;
+alignas(64) static volatile u32 gReadPointer;
+alignas(64) static u32 gWritePointer;
+static std::atomic<u64> gChecksum;
+
+static double threadCpuSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static Result run(const std::vector<std::vector<u8>>& frames, int repeats, bool paced, const Config& config)
+{
+    Common::BlockingLoop loop;
+    loop.SetMaxSpinTime(std::chrono::microseconds(config.spinUs));
+    std::atomic<bool> producerDone(false);
+    Result result = {};
+
+    gDistance = 0;
+    gReadPointer = 0;
+    gWritePointer = 0;
+    gChecksum = 0;
+
+    std::thread gpu([&] {
+        static u8 videoBuffer[BLOCK_SIZE * 64];
+        u64 checksum = 0;
+        loop.Run(
+            [&] {
+                while (Common::AtomicLoad(gDistance))
+                {
+                    // as RunGpuLoop()
+                    const u32 available = Common::AtomicLoad(gDistance) / BLOCK_SIZE;
+                    u32 readPointer = gReadPointer;
+                    u32 blocks = 0;
+                    do
+                    {
+                        u8* dst = videoBuffer + blocks * BLOCK_SIZE;
+                        memcpy(dst, gRing + readPointer, BLOCK_SIZE);
+                        for (int i = 0; i < BLOCK_SIZE; i++)
+                            checksum += dst[i];
+                        readPointer = (readPointer + BLOCK_SIZE) % RING_SIZE;
+                        blocks++;
+                    } while (blocks < config.batch && blocks < available);
+
+                    Common::AtomicStore(gReadPointer, readPointer);
+                    Common::AtomicAdd(gDistance, static_cast<u32>(-(s32)(blocks * BLOCK_SIZE)));
+                }
+                if (producerDone && !Common::AtomicLoad(gDistance))
+                    loop.Stop(Common::BlockingLoop::kNonBlock);
+            },
+            100);
+        gChecksum = checksum;
+        result.consumerCpu = threadCpuSeconds();
+    });
+
+    const double cpuStart = threadCpuSeconds();
+    const auto start = std::chrono::steady_clock::now();
+    auto lastTick = start;
+    const int frameCount = paced ? PACED_FRAMES : repeats * (int)frames.size();
+    for (int f = 0; f < frameCount; f++)
+    {
+        const std::vector<u8>& data = frames[f % frames.size()];
+        for (size_t offset = 0; offset < data.size(); offset += BLOCK_SIZE)
+        {
+            // the CPU thread waits on the high watermark
+            while (Common::AtomicLoad(gDistance) > RING_SIZE - 2 * BLOCK_SIZE)
+            {
+                result.fullStalls++;
+                std::this_thread::yield();
+            }
+            memcpy(gRing + gWritePointer, data.data() + offset, BLOCK_SIZE);
+            gWritePointer = (gWritePointer + BLOCK_SIZE) % RING_SIZE;
+            Common::AtomicAdd(gDistance, BLOCK_SIZE);
+            loop.Wakeup();
+
+            // as the throttle event of the emulated CPU
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastTick >= std::chrono::milliseconds(1))
+            {
+                loop.AllowSleep();
+                lastTick = now;
+            }
+        }
+        if (paced)
+        {
+            const auto frameEnd = start + std::chrono::microseconds((f + 1) * 1000000LL / 60);
+            while (std::chrono::steady_clock::now() < frameEnd)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                loop.AllowSleep();
+            }
+        }
+    }
+    producerDone = true;
+    loop.Wakeup();
+    gpu.join();
+
+    result.seconds = secondsSince(start);
+    result.producerCpu = threadCpuSeconds() - cpuStart;
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        printf("usage: %s <file.dff> [repeats] [batch] [spin time in us]\n", argv[0]);
+        return 1;
+    }
+    int repeats = (argc > 2) ? atoi(argv[2]) : 20;
+    int batch = (argc > 3) ? atoi(argv[3]) : 8;
+    int spinUs = (argc > 4) ? atoi(argv[4]) : 200;
+    if (repeats < 1) repeats = 1;
+    // as Fifo::Init()
+    if (batch < 1) batch = 1;
+    if (batch > 64) batch = 64;
+    if (spinUs < 0) spinUs = 0;
+    Config configs[] = {{"per block", 1, 0}, {"batched", (unsigned)batch, spinUs}};
+
+    std::unique_ptr<FifoDataFile> file = FifoDataFile::Load(argv[1], false);
+    if (!file || !file->GetFrameCount())
+    {
+        printf("Could not load %s\n", argv[1]);
+        return 1;
+    }
+
+    // whole blocks only, as written by the gather pipe
+    std::vector<std::vector<u8>> frames;
+    size_t bytes = 0;
+    for (u32 i = 0; i < file->GetFrameCount(); i++)
+    {
+        std::vector<u8> data = file->GetFrame(i).fifoData;
+        data.resize((data.size() + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE);
+        bytes += data.size();
+        frames.push_back(std::move(data));
+    }
+    printf("%s: %u frames, %.1f KiB of commands per replay\n\n", argv[1], file->GetFrameCount(), bytes / 1024.0);
+
+    printf("burst, %d replays\n", repeats);
+    printf("%-10s %12s %12s %12s %12s\n", "", "Mblocks/s", "CPU thread", "GPU thread", "ring full");
+    for (const Config& config : configs)
+    {
+        Result r = run(frames, repeats, false, config);
+        double blocks = (double)bytes * repeats / BLOCK_SIZE;
+        printf("%-10s %12.2f %10.3f s %10.3f s %12llu\n", config.name, blocks / r.seconds / 1e6,
+               r.producerCpu, r.consumerCpu, r.fullStalls);
+    }
+
+    printf("\npaced, %d frames at 60 fps\n", PACED_FRAMES);
+    printf("%-10s %16s\n", "", "GPU thread CPU");
+    for (const Config& config : configs)
+    {
+        Result r = run(frames, repeats, true, config);
+        printf("%-10s %11.3f ms/frame\n", config.name, r.consumerCpu * 1000.0 / PACED_FRAMES);
+    }
+    printf("\nchecksum %llu\n", (unsigned long long)gChecksum.load());
+    return 0;
+}
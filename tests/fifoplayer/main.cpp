@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL.h>
+#include "../../include/controller.h"
+
+#include "Core/Core.h"
+#include "Core/FifoPlayer/FifoDataFile.h"
+#include "Core/Host.h"
+#include "VideoCommon/PipelineTimings.h"
+
+// Replay benchmark for Dolphin's video pipeline, for the nightly runs.
+//
+// A FIFO log (.dff, recorded with the FIFO player) is replayed with the headless platform
+// through the Null and the Software backend, nothing is presented. The replay runs
+// unthrottled and loops; the first pass warms the caches and is not counted.
+// Reported is the CPU time per frame of the stages of VideoCommon/PipelineTimings.h:
+//
+// opcode_decoding   the whole command stream, includes the two below and the draws
+// vertex_loading    conversion of the vertices to the native format
+// texture_decoding  textures decoded on the CPU (the Software backend decodes texels while
+//                   rasterising, that time is only part of opcode_decoding)
+//
+// A frame is a frame presented by the renderer. With --json the results, per-frame times
+// included, are also written to a file. The exit code is not 0 if a backend failed, so a
+// nightly job notices.
+//
+// usage: ./FIFOPLAYER <file.dff> [passes] [--json <file>] [--backend Null|Software]
+
+int WINDOW_WIDTH = 1280;
+int WINDOW_HEIGHT = 750;
+bool marley_wiimote = false;
+int dolphin_main(int argc, char* argv[]);
+
+SDL_Joystick* gGamepad[MAX_GAMEPADS_PLUGGED];
+int devicesPerType[] = {CTRL_TYPE_STD_DEVICES,CTRL_TYPE_WIIMOTE_DEVICES};
+T_DesignatedControllers gDesignatedControllers[MAX_GAMEPADS];
+int gNumDesignatedControllers;
+std::string gBaseDir;
+SDL_Window* gWindow = nullptr;
+
+// per backend, a replay that stops presenting frames must not hang the nightly job
+#define TIMEOUT_SECONDS 600
+
+struct Backend
+{
+    const char* label;
+    const char* name;  // as for -v
+};
+
+static const Backend gBackends[] = {
+    {"Null", "Null"},
+    {"Software", "Software Renderer"},
+};
+
+struct StageSummary
+{
+    double mean;
+    double p50;
+    double p95;
+    double max;
+};
+
+struct Result
+{
+    const Backend* backend;
+    bool ok;
+    bool timedOut;
+    double wallSeconds;
+    std::vector<PipelineTimings::Frame> frames;
+    StageSummary stages[PipelineTimings::NUM_STAGES];
+};
+
+static double nsToMs(u64 ns)
+{
+    return ns / 1000000.0;
+}
+
+static StageSummary summarize(const std::vector<PipelineTimings::Frame>& frames, size_t stage)
+{
+    StageSummary summary = {0.0, 0.0, 0.0, 0.0};
+    if (frames.empty()) return summary;
+
+    std::vector<u64> values;
+    values.reserve(frames.size());
+    double sum = 0.0;
+    for (const PipelineTimings::Frame& frame : frames)
+    {
+        values.push_back(frame[stage]);
+        sum += nsToMs(frame[stage]);
+    }
+    std::sort(values.begin(), values.end());
+
+    summary.mean = sum / frames.size();
+    summary.p50 = nsToMs(values[(values.size() - 1) / 2]);
+    summary.p95 = nsToMs(values[(values.size() - 1) * 95 / 100]);
+    summary.max = nsToMs(values.back());
+    return summary;
+}
+
+// replays the log for warmup + counted frames, keeps the counted ones
+static Result replay(const std::string& file, const Backend& backend, u32 warmupFrames, u32 countedFrames)
+{
+    Result result;
+    result.backend = &backend;
+    result.timedOut = false;
+
+    char arg0[64], arg1[64], arg2[64], arg3[64], arg4[64], arg5[1024];
+    char* argv[6] = {arg0, arg1, arg2, arg3, arg4, arg5};
+    snprintf(arg0, sizeof(arg0), "dolphin-emu");
+    snprintf(arg1, sizeof(arg1), "-p");
+    snprintf(arg2, sizeof(arg2), "headless");
+    snprintf(arg3, sizeof(arg3), "-v");
+    snprintf(arg4, sizeof(arg4), "%s", backend.name);
+    snprintf(arg5, sizeof(arg5), "%s", file.c_str());
+
+    const u32 target = warmupFrames + countedFrames;
+    std::atomic<bool> done(false);
+    std::atomic<bool> reached(false);
+
+    // not saved, unlike the speed limit in Dolphin.ini
+    Core::SetIsThrottlerTempDisabled(true);
+    PipelineTimings::SetEnabled(true);
+    auto start = std::chrono::steady_clock::now();
+    std::thread watcher([&] {
+        bool stopRequested = false;
+        while (!done)
+        {
+            if (!stopRequested && (Core::GetState() == Core::State::Running))
+            {
+                bool timeout = std::chrono::steady_clock::now() - start > std::chrono::seconds(TIMEOUT_SECONDS);
+                if (PipelineTimings::GetFrameCount() >= target || timeout)
+                {
+                    reached = !timeout;
+                    result.timedOut = timeout;
+                    Host_Message(HostMessageID::WMUserStop);
+                    stopRequested = true;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    int ret = dolphin_main(6, argv);
+    done = true;
+    watcher.join();
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Core::SetIsThrottlerTempDisabled(false);
+
+    std::vector<PipelineTimings::Frame> frames = PipelineTimings::GetFrames();
+    PipelineTimings::SetEnabled(false);
+
+    result.ok = (ret == 0) && reached;
+    if (frames.size() > warmupFrames)
+        result.frames.assign(frames.begin() + warmupFrames, frames.end());
+    for (size_t i = 0; i < PipelineTimings::NUM_STAGES; i++)
+        result.stages[i] = summarize(result.frames, i);
+    return result;
+}
+
+static void printResult(const Result& result)
+{
+    printf("\n%s: %zu frames, %.1f s%s\n", result.backend->label, result.frames.size(), result.wallSeconds,
+           result.ok ? "" : (result.timedOut ? "  [timed out]" : "  [failed]"));
+    printf("%-18s %10s %10s %10s %10s  [ms per frame]\n", "", "mean", "p50", "p95", "max");
+    for (size_t i = 0; i < PipelineTimings::NUM_STAGES; i++)
+    {
+        const StageSummary& s = result.stages[i];
+        printf("%-18s %10.3f %10.3f %10.3f %10.3f\n",
+               PipelineTimings::GetStageName(static_cast<PipelineTimings::Stage>(i)), s.mean, s.p50, s.p95, s.max);
+    }
+}
+
+static void writeJsonString(FILE* out, const std::string& text)
+{
+    fputc('"', out);
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if ((unsigned char)c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+static bool writeJson(const std::string& path, const std::string& file, int passes, u32 framesPerPass,
+                      const std::vector<Result>& results)
+{
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out)
+    {
+        printf("Could not write %s\n", path.c_str());
+        return false;
+    }
+
+    fprintf(out, "{\"file\":");
+    writeJsonString(out, file);
+    fprintf(out, ",\"passes\":%d,\"frames_per_pass\":%u,\"unit\":\"ms\",\"stages\":[", passes, framesPerPass);
+    for (size_t i = 0; i < PipelineTimings::NUM_STAGES; i++)
+        fprintf(out, "%s\"%s\"", i ? "," : "", PipelineTimings::GetStageName(static_cast<PipelineTimings::Stage>(i)));
+    fprintf(out, "],\"backends\":[");
+
+    for (size_t r = 0; r < results.size(); r++)
+    {
+        const Result& result = results[r];
+        fprintf(out, "%s\n{\"backend\":\"%s\",\"status\":\"%s\",\"frames\":%zu,\"wall_s\":%.3f,\"summary\":{",
+                r ? "," : "", result.backend->label,
+                result.ok ? "ok" : (result.timedOut ? "timeout" : "failed"),
+                result.frames.size(), result.wallSeconds);
+        for (size_t i = 0; i < PipelineTimings::NUM_STAGES; i++)
+        {
+            const StageSummary& s = result.stages[i];
+            fprintf(out, "%s\"%s\":{\"mean\":%.4f,\"p50\":%.4f,\"p95\":%.4f,\"max\":%.4f}", i ? "," : "",
+                    PipelineTimings::GetStageName(static_cast<PipelineTimings::Stage>(i)), s.mean, s.p50, s.p95, s.max);
+        }
+        // one array per frame, in the order of "stages"
+        fprintf(out, "},\"per_frame\":[");
+        for (size_t f = 0; f < result.frames.size(); f++)
+        {
+            fprintf(out, "%s[", f ? "," : "");
+            for (size_t i = 0; i < PipelineTimings::NUM_STAGES; i++)
+                fprintf(out, "%s%.4f", i ? "," : "", nsToMs(result.frames[f][i]));
+            fprintf(out, "]");
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "\n]}\n");
+
+    bool ok = !ferror(out);
+    if (fclose(out) != 0)
+        ok = false;
+    if (!ok)
+        printf("Could not write %s\n", path.c_str());
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string file;
+    std::string jsonPath;
+    std::string only;
+    int passes = 3;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--json") && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if (!strcmp(argv[i], "--backend") && i + 1 < argc)
+            only = argv[++i];
+        else if (file.empty())
+            file = argv[i];
+        else
+            passes = atoi(argv[i]);
+    }
+    if (file.empty() || passes < 1)
+    {
+        printf("usage: %s <file.dff> [passes] [--json <file>] [--backend Null|Software]\n", argv[0]);
+        return 1;
+    }
+
+    std::unique_ptr<FifoDataFile> log = FifoDataFile::Load(file, false);
+    if (!log || log->GetFrameCount() == 0)
+    {
+        printf("Could not load FIFO log %s\n", file.c_str());
+        return 1;
+    }
+    u32 framesPerPass = log->GetFrameCount();
+    log.reset();
+
+    const char* homedir = getenv("HOME");
+    gBaseDir = std::string(homedir ? homedir : ".") + "/.marley/";
+
+    printf("%s: %u frames, %d passes (+1 warmup)\n", file.c_str(), framesPerPass, passes);
+
+    std::vector<Result> results;
+    bool ok = true;
+    for (const Backend& backend : gBackends)
+    {
+        if (!only.empty() && only != backend.label) continue;
+        Result result = replay(file, backend, framesPerPass, framesPerPass * passes);
+        if (!result.ok) ok = false;
+        results.push_back(result);
+    }
+    if (results.empty())
+    {
+        printf("Unknown backend %s\n", only.c_str());
+        return 1;
+    }
+
+    for (const Result& result : results)
+        printResult(result);
+    if (!jsonPath.empty())
+    {
+        if (writeJson(jsonPath, file, passes, framesPerPass, results))
+            printf("\nResults written to %s\n", jsonPath.c_str());
+        else
+            ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
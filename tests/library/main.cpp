@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <chrono>
+#include "../../include/library.h"
+
+// Benchmark for the game list post-processing of a search:
+// stripList() (cue file references) and finalizeList() (gGame, no duplicates).
+// The collection is synthetic: a third of the games are cue/bin pairs,
+// the remaining ones are iso files, 500 files per folder.
+//
+// usage: ./LIBRARY [max collection size] [--legacy]
+// --legacy also runs the previous nested-loop implementation
+// (slow beyond a few thousand files)
+
+using namespace std;
+
+std::vector<std::string> gGame;
+bool gGamesFound;
+string gBaseDir = "/tmp/";
+
+static void legacyStripList(list<string> *tmpList,list<string> *toBeRemoved)
+{
+    list<string>::iterator iteratorTmpList;
+    list<string>::iterator iteratorToBeRemoved;
+    string strRemove, strRemove_no_path, strList, strList_no_path;
+
+    iteratorToBeRemoved = toBeRemoved[0].begin();
+    for (int i=0;i<toBeRemoved[0].size();i++)
+    {
+        strRemove = *iteratorToBeRemoved;
+        iteratorToBeRemoved++;
+        iteratorTmpList = tmpList[0].begin();
+
+        strRemove_no_path = strRemove;
+        if(strRemove_no_path.find("/") != string::npos)
+        {
+            strRemove_no_path = strRemove.substr(strRemove_no_path.find_last_of("/") + 1);
+        }
+
+        for (int j=0;j<tmpList[0].size();j++)
+        {
+            strList = *iteratorTmpList;
+            strList_no_path = strList;
+            if(strList_no_path.find("/") != string::npos)
+            {
+                strList_no_path = strList_no_path.substr(strList_no_path.find_last_of("/") + 1);
+            }
+            if ( strRemove_no_path == strList_no_path )
+            {
+                tmpList[0].erase(iteratorTmpList++);
+            }
+            else
+            {
+                iteratorTmpList++;
+            }
+        }
+    }
+}
+
+static void legacyFinalizeList(list<string> *tmpList)
+{
+    for (const string& strList : tmpList[0])
+    {
+        bool found = false;
+        for (const string& element : gGame)
+        {
+            if (element == strList)
+            {
+                found = true;
+                break;
+            }
+        }
+        if (!found) gGame.push_back(strList);
+    }
+    gGamesFound = (gGame.size() > 0);
+}
+
+static void createCollection(int size, list<string> *tmpList, list<string> *toBeRemoved)
+{
+    tmpList->clear();
+    toBeRemoved->clear();
+    for (int i = 0; i < size; i++)
+    {
+        string folder = "/games/folder" + to_string(i / 500) + "/";
+        string name = "game" + to_string(i);
+        if (i % 3 == 0)
+        {
+            tmpList->push_back(folder + name + ".cue");
+            tmpList->push_back(folder + name + ".bin");
+            toBeRemoved->push_back(name + ".bin");
+        }
+        else
+        {
+            tmpList->push_back(folder + name + ".iso");
+        }
+    }
+}
+
+static double runPass(int size, bool legacy, size_t* games)
+{
+    list<string> tmpList;
+    list<string> toBeRemoved;
+
+    createCollection(size, &tmpList, &toBeRemoved);
+    gGame.clear();
+
+    auto start = chrono::steady_clock::now();
+    if (legacy)
+    {
+        legacyStripList(&tmpList, &toBeRemoved);
+        legacyFinalizeList(&tmpList);
+    }
+    else
+    {
+        stripList(&tmpList, &toBeRemoved);
+        finalizeList(&tmpList);
+    }
+    auto end = chrono::steady_clock::now();
+
+    *games = gGame.size();
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    int maxSize = 60000;
+    bool legacy = false;
+    size_t games, legacyGames;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--legacy")
+        {
+            legacy = true;
+        }
+        else
+        {
+            maxSize = atoi(argv[i]);
+        }
+    }
+
+    printf("%10s %10s %14s", "files", "games", "hashed [ms]");
+    if (legacy) printf(" %14s", "legacy [ms]");
+    printf("\n");
+
+    for (int size : {1000, 5000, 10000, 20000, 40000, 60000})
+    {
+        if (size > maxSize) break;
+        double duration = runPass(size, false, &games);
+        printf("%10d %10lu %14.2f", size, games, duration);
+        if (legacy)
+        {
+            double legacyDuration = runPass(size, true, &legacyGames);
+            printf(" %14.2f", legacyDuration);
+            if (legacyGames != games) printf("  MISMATCH (%lu)", legacyGames);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <time.h>
+#include "../../include/mdf2iso.h"
+
+// Benchmark for the MDF to cue/bin conversion (mdf2iso --cue).
+// The image is synthetic: SYNC MDF sectors of 2448 bytes (2352 bytes
+// data, 96 bytes subchannel), written to /tmp/mdf2iso_benchmark.mdf.
+//
+// usage: ./MDF2ISO [image size in MB] [--legacy]
+// --legacy also runs the previous sector-by-sector copy and
+// compares the results
+
+using namespace std;
+
+static const int SECTOR_SIZE = 2448;
+static const int SECTOR_DATA = 2352;
+static const string MDF_FILE = "/tmp/mdf2iso_benchmark.mdf";
+static const string BIN_FILE = "/tmp/mdf2iso_benchmark.bin";
+static const string LEGACY_FILE = "/tmp/mdf2iso_benchmark_legacy.bin";
+
+static bool createImage(long sectors)
+{
+    const unsigned char syncHeader[12] = {0x00,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0x00};
+    const unsigned char syncHeaderMdf[12] = {0x80,0xC0,0x80,0x80,0x80,0x80,0x80,0xC0,0x80,0x80,0x80,0x80};
+    vector<unsigned char> sector(SECTOR_SIZE);
+
+    FILE* file = fopen(MDF_FILE.c_str(), "wb");
+    if (!file) return false;
+    for (long i = 0; i < sectors; i++)
+    {
+        for (int j = 0; j < SECTOR_SIZE; j++)
+        {
+            sector[j] = (unsigned char) (i * 31 + j * 7);
+        }
+        memcpy(&sector[0], syncHeader, 12);
+        // mdftype() checks the bytes after the first 2352 bytes
+        if (i == 0) memcpy(&sector[SECTOR_DATA], syncHeaderMdf, 12);
+        fwrite(&sector[0], 1, SECTOR_SIZE, file);
+    }
+    fclose(file);
+    return true;
+}
+
+// previous implementation: a seek, a read and a write per sector
+static bool legacyConvert(long sectors)
+{
+    char buf[SECTOR_SIZE];
+    FILE* source = fopen(MDF_FILE.c_str(), "rb");
+    FILE* dest = fopen(LEGACY_FILE.c_str(), "wb");
+    bool ok = (source && dest);
+
+    for (long i = 0; ok && (i < sectors); i++)
+    {
+        ok = (fread(buf, 1, SECTOR_DATA, source) == SECTOR_DATA) &&
+             (fwrite(buf, 1, SECTOR_DATA, dest) == SECTOR_DATA);
+        fseek(source, SECTOR_SIZE - SECTOR_DATA, SEEK_CUR);
+    }
+    if (source) fclose(source);
+    if (dest) fclose(dest);
+    return ok;
+}
+
+static bool sameFiles(const string& a, const string& b)
+{
+    FILE* fileA = fopen(a.c_str(), "rb");
+    FILE* fileB = fopen(b.c_str(), "rb");
+    bool same = (fileA && fileB);
+    vector<char> bufferA(1 << 20), bufferB(1 << 20);
+
+    while (same)
+    {
+        size_t lengthA = fread(&bufferA[0], 1, bufferA.size(), fileA);
+        size_t lengthB = fread(&bufferB[0], 1, bufferB.size(), fileB);
+        same = (lengthA == lengthB) && (memcmp(&bufferA[0], &bufferB[0], lengthA) == 0);
+        if (lengthA == 0) break;
+    }
+    if (fileA) fclose(fileA);
+    if (fileB) fclose(fileB);
+    return same;
+}
+
+int main(int argc, char* argv[])
+{
+    long sizeMB = 700;
+    bool legacy = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--legacy")
+        {
+            legacy = true;
+        }
+        else
+        {
+            sizeMB = atol(argv[i]);
+        }
+    }
+
+    long sectors = sizeMB * 1024 * 1024 / SECTOR_SIZE;
+    if ((sectors < 2) || !createImage(sectors))
+    {
+        printf("Could not create %s\n", MDF_FILE.c_str());
+        return 1;
+    }
+
+    // the image is in the page cache now, this measures the copy, not the disk
+    auto start = chrono::steady_clock::now();
+    startMdf2Iso(MDF_FILE, "mdf2iso_benchmark.bin");
+    int percent;
+    while (getMdf2IsoProgress(&percent))
+    {
+        struct timespec interval = {0, 10000000};
+        nanosleep(&interval, nullptr);
+    }
+    int result = finishMdf2Iso();
+    auto end = chrono::steady_clock::now();
+    double duration = chrono::duration<double>(end - start).count();
+
+    printf("\n%10s %10s %14s %14s\n", "image [MB]", "sectors", "convert [s]", "[MB/s]");
+    printf("%10ld %10ld %14.3f %14.1f\n", sizeMB, sectors, duration, sizeMB / duration);
+    if (result != 0) printf("conversion FAILED\n");
+
+    if (legacy)
+    {
+        start = chrono::steady_clock::now();
+        bool ok = legacyConvert(sectors);
+        end = chrono::steady_clock::now();
+        double legacyDuration = chrono::duration<double>(end - start).count();
+        printf("%10s %10s %14.3f %14.1f\n", "legacy", "", legacyDuration, sizeMB / legacyDuration);
+        if (!ok || !sameFiles(BIN_FILE, LEGACY_FILE)) printf("MISMATCH\n");
+        remove(LEGACY_FILE.c_str());
+    }
+
+    remove(MDF_FILE.c_str());
+    remove(BIN_FILE.c_str());
+    remove("/tmp/mdf2iso_benchmark.cue");
+    return (result == 0) ? 0 : 1;
+}
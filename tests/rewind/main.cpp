@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <SDL.h>
+#include "../../include/controller.h"
+
+#include "Core/Core.h"
+#include "Core/Rewind.h"
+#include "UICommon/UICommon.h"
+
+// Benchmark for the in-memory rewind of Dolphin (Core/Rewind.h).
+//
+// The game runs for a number of frames with rewind enabled, then steps back a few
+// times. Reported are the time the emulation is paused for captures, averaged over all
+// frames (the target is below 2 ms per frame), the longest single pause, the size of
+// the ring and the time of a step back.
+//
+// usage: ./REWIND <game> [number of frames]
+
+int WINDOW_WIDTH = 1280;
+int WINDOW_HEIGHT = 750;
+bool marley_wiimote = false;
+extern bool dolphin_rewind;
+int dolphin_main(int argc, char* argv[]);
+
+SDL_Joystick* gGamepad[MAX_GAMEPADS_PLUGGED];
+int devicesPerType[] = {CTRL_TYPE_STD_DEVICES,CTRL_TYPE_WIIMOTE_DEVICES};
+T_DesignatedControllers gDesignatedControllers[MAX_GAMEPADS];
+int gNumDesignatedControllers;
+std::string gBaseDir;
+SDL_Window* gWindow = nullptr;
+
+#define STEPS_BACK 5
+
+static double milliseconds(Uint64 start)
+{
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        printf("usage: %s <game> [number of frames]\n", argv[0]);
+        return 1;
+    }
+    std::string game = argv[1];
+    int frames = (argc > 2) ? atoi(argv[2]) : 3600;
+
+    const char* homedir = getenv("HOME");
+    gBaseDir = std::string(homedir ? homedir : ".") + "/.marley/";
+
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_JOYSTICK | SDL_INIT_TIMER) < 0)
+    {
+        printf("SDL could not initialize! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    gWindow = SDL_CreateWindow("rewind benchmark", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                               WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN | SDL_WINDOW_OPENGL);
+    if (!gWindow)
+    {
+        printf("Could not create window. SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    char arg1[1024], arg2[1024];
+    char* args[2] = {arg1, arg2};
+    snprintf(arg1, sizeof(arg1), "dolphin-emu");
+    snprintf(arg2, sizeof(arg2), "%s", game.c_str());
+
+    std::atomic<bool> done(false);
+    std::atomic<int> stepsDone(0);
+    double stepMs = 0.0;
+    Rewind::Stats stats;
+
+    std::thread watcher([&] {
+        while (!done && ((Core::GetState() != Core::State::Running) ||
+                         (Core::GetPresentedFrameCount() < (u64)frames)))
+        {
+            SDL_Delay(10);
+        }
+        if (done) return;
+
+        // the ring is emptied by the steps back
+        stats = Rewind::GetStats();
+
+        for (int i = 0; i < STEPS_BACK; i++)
+        {
+            std::atomic<bool> stepped(false);
+            // StepBack() runs on the host thread, as from the hotkey
+            Core::QueueHostJob([&] {
+                Uint64 start = SDL_GetPerformanceCounter();
+                if (Rewind::StepBack())
+                {
+                    stepMs += milliseconds(start);
+                    stepsDone++;
+                }
+                stepped = true;
+            });
+            while (!stepped && !done) SDL_Delay(1);
+        }
+
+        SDL_Event quit;
+        quit.type = SDL_QUIT;
+        SDL_PushEvent(&quit);
+    });
+
+    dolphin_rewind = true;
+    dolphin_main(2, args);
+    done = true;
+    watcher.join();
+
+    if (!stats.frames)
+    {
+        printf("The game did not run for %d frames\n", frames);
+        return 1;
+    }
+
+    double perFrameMs = stats.capture_us / 1000.0 / stats.frames;
+    printf("frames:              %llu\n", (unsigned long long)stats.frames);
+    printf("captures:            %llu (%llu skipped, the worker was busy)\n",
+           (unsigned long long)stats.captures, (unsigned long long)stats.skipped_captures);
+    printf("capture per frame:   %.3f ms (target < 2 ms) %s\n", perFrameMs, perFrameMs < 2.0 ? "ok" : "too slow");
+    printf("longest capture:     %.1f ms\n", stats.max_capture_us / 1000.0);
+    printf("snapshots:           %u\n", stats.snapshots);
+    printf("state:               %.1f MiB\n", stats.state_bytes / 1048576.0);
+    printf("ring:                %.1f MiB\n", stats.ring_bytes / 1048576.0);
+    if (stats.snapshots > 1)
+        printf("delta ratio:         %.1f %%\n",
+               100.0 * stats.ring_bytes / ((double)stats.state_bytes * (stats.snapshots - 1)));
+    if (stepsDone)
+        printf("step back:           %.1f ms (%d steps)\n", stepMs / stepsDone, (int)stepsDone);
+
+    SDL_DestroyWindow(gWindow);
+    SDL_Quit();
+    return 0;
+}
@@ -0,0 +1,262 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "../../include/gui.h"
+#include "../../include/session.h"
+
+// Benchmark for the way back from a game to the launcher.
+// An emulator core is simulated with a GL context of its own on the
+// launcher window (as mednafen, dolphin, ppsspp and mupen64plus do).
+//
+// legacy:  restoreGUI() as before, the renderer is destroyed and
+//          created again, all launcher bitmaps are reloaded
+// session: endEmulatorSession(), renderer and textures stay resident
+// window:  endEmulatorSession() after a session with a window of its own (PCSX2)
+//
+// The screen_manager UI is simulated with a GL context on the launcher
+// window and the launcher bitmaps uploaded as textures (UI atlas, thumbnails).
+//
+// restart:  screen_manager_main() as before, it returns before the game and
+//           creates its context and textures anew afterwards
+// resident: endEmulatorSession(), the game ran in a window of its own
+//
+// Every variant includes the first frame after the game.
+//
+// usage: ./SESSION [number of runs]
+
+SDL_Window* gWindow;
+SDL_Renderer* gRenderer;
+SDL_Texture* gTextures[NUM_TEXTURES];
+int window_width = 1280, window_height = 720, window_x = 100, window_y = 100;
+
+static std::vector<std::string> gBitmaps;
+
+void setAppIcon(void) {}
+void restoreController(void) {}
+void setFullscreen(void) {}
+void setWindowed(void) {}
+
+static bool loadBitmaps(void)
+{
+    for (size_t i = 0; i < gBitmaps.size() && i < NUM_TEXTURES; i++)
+    {
+        SDL_Surface* surface = SDL_LoadBMP(gBitmaps[i].c_str());
+        if (!surface) return false;
+        gTextures[i] = SDL_CreateTextureFromSurface(gRenderer, surface);
+        SDL_FreeSurface(surface);
+    }
+    return true;
+}
+
+static void freeBitmaps(void)
+{
+    for (int i = 0; i < NUM_TEXTURES; i++)
+    {
+        if (gTextures[i]) SDL_DestroyTexture(gTextures[i]);
+        gTextures[i] = nullptr;
+    }
+}
+
+static bool createLauncherRenderer(void)
+{
+    gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED);
+    if (!gRenderer) return false;
+    SDL_SetRenderDrawBlendMode(gRenderer, SDL_BLENDMODE_BLEND);
+    return loadBitmaps();
+}
+
+void restartGUI(void)
+{
+    freeBitmaps();
+    SDL_DestroyRenderer(gRenderer);
+    createLauncherRenderer();
+}
+
+static void renderLauncher(void)
+{
+    SDL_RenderClear(gRenderer);
+    for (int i = 0; i < NUM_TEXTURES; i++)
+    {
+        if (gTextures[i]) SDL_RenderCopy(gRenderer, gTextures[i], nullptr, nullptr);
+    }
+    SDL_RenderPresent(gRenderer);
+}
+
+static void runCore(void)
+{
+    SDL_GLContext context = SDL_GL_CreateContext(gWindow);
+    SDL_GL_MakeCurrent(gWindow, context);
+    for (int frame = 0; frame < 10; frame++)
+    {
+        glClearColor(frame / 10.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        SDL_GL_SwapWindow(gWindow);
+    }
+    SDL_GL_DeleteContext(context);
+}
+
+static SDL_GLContext gScreenContext = nullptr;
+static std::vector<GLuint> gScreenTextures;
+
+static bool startScreenManager(void)
+{
+    gScreenContext = SDL_GL_CreateContext(gWindow);
+    if (!gScreenContext) return false;
+    SDL_GL_MakeCurrent(gWindow, gScreenContext);
+    for (const std::string& bitmap : gBitmaps)
+    {
+        SDL_Surface* surface = SDL_LoadBMP(bitmap.c_str());
+        if (!surface) return false;
+        SDL_Surface* rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ABGR8888, 0);
+        SDL_FreeSurface(surface);
+        if (!rgba) return false;
+
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, rgba->w, rgba->h, 0, GL_RGBA, GL_UNSIGNED_BYTE, rgba->pixels);
+        SDL_FreeSurface(rgba);
+        gScreenTextures.push_back(texture);
+    }
+    return true;
+}
+
+static void stopScreenManager(void)
+{
+    SDL_GL_MakeCurrent(gWindow, gScreenContext);
+    glDeleteTextures(gScreenTextures.size(), gScreenTextures.data());
+    gScreenTextures.clear();
+    SDL_GL_DeleteContext(gScreenContext);
+    gScreenContext = nullptr;
+}
+
+static void renderScreenManager(void)
+{
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_TEXTURE_2D);
+    for (GLuint texture : gScreenTextures)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glBegin(GL_QUADS);
+        glTexCoord2f(0.0f, 1.0f); glVertex2f(-1.0f, -1.0f);
+        glTexCoord2f(1.0f, 1.0f); glVertex2f( 1.0f, -1.0f);
+        glTexCoord2f(1.0f, 0.0f); glVertex2f( 1.0f,  1.0f);
+        glTexCoord2f(0.0f, 0.0f); glVertex2f(-1.0f,  1.0f);
+        glEnd();
+    }
+    SDL_GL_SwapWindow(gWindow);
+    glFinish();
+}
+
+static double milliseconds(Uint64 start)
+{
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+int main(int argc, char* argv[])
+{
+    int runs = (argc > 1) ? atoi(argv[1]) : 10;
+    double legacy = 0.0, session = 0.0, window = 0.0;
+    DIR* dir;
+    struct dirent* ent;
+
+    if ((dir = opendir("../../pictures")) != nullptr)
+    {
+        while ((ent = readdir(dir)) != nullptr)
+        {
+            std::string name = ent->d_name;
+            if ((name.length() > 4) && (name.substr(name.length() - 4) == ".bmp"))
+            {
+                gBitmaps.push_back("../../pictures/" + name);
+            }
+        }
+        closedir(dir);
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        printf("SDL could not initialize! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    gWindow = SDL_CreateWindow("session benchmark", window_x, window_y, window_width, window_height,
+                               SDL_WINDOW_SHOWN | SDL_WINDOW_OPENGL);
+    if (!gWindow || !createLauncherRenderer())
+    {
+        printf("Could not create window and renderer. SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    printf("%lu launcher bitmaps, %d runs\n", gBitmaps.size(), runs);
+
+    for (int i = 0; i < runs; i++)
+    {
+        Uint64 start;
+
+        runCore();
+        start = SDL_GetPerformanceCounter();
+        restartGUI();
+        renderLauncher();
+        legacy += milliseconds(start);
+
+        beginEmulatorSession(false);
+        runCore();
+        start = SDL_GetPerformanceCounter();
+        endEmulatorSession();
+        renderLauncher();
+        session += milliseconds(start);
+
+        beginEmulatorSession(true);
+        runCore();
+        start = SDL_GetPerformanceCounter();
+        endEmulatorSession();
+        renderLauncher();
+        window += milliseconds(start);
+    }
+
+    printf("%10s %10s %10s  [ms per return to the launcher]\n", "legacy", "session", "window");
+    printf("%10.2f %10.2f %10.2f\n", legacy / runs, session / runs, window / runs);
+
+    // the screen manager replaces the SDL launcher (STATE_CONFIG)
+    freeBitmaps();
+    SDL_DestroyRenderer(gRenderer);
+    gRenderer = nullptr;
+
+    double restart = 0.0, resident = 0.0;
+    if (!startScreenManager())
+    {
+        printf("Could not start the screen manager. SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    for (int i = 0; i < runs; i++)
+    {
+        Uint64 start;
+
+        stopScreenManager();
+        runCore();
+        start = SDL_GetPerformanceCounter();
+        startScreenManager();
+        renderScreenManager();
+        restart += milliseconds(start);
+
+        beginEmulatorSession(false);
+        runCore();
+        start = SDL_GetPerformanceCounter();
+        endEmulatorSession();
+        SDL_GL_MakeCurrent(gWindow, gScreenContext);
+        renderScreenManager();
+        resident += milliseconds(start);
+    }
+
+    printf("%10s %10s  [ms per return to the screen manager]\n", "restart", "resident");
+    printf("%10.2f %10.2f\n", restart / runs, resident / runs);
+
+    stopScreenManager();
+    SDL_DestroyWindow(gWindow);
+    SDL_Quit();
+    return 0;
+}
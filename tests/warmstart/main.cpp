@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <SDL.h>
+#include "../../include/controller.h"
+
+#include "Core/Core.h"
+#include "UICommon/UICommon.h"
+
+// Benchmark for repeated launches of the same Dolphin game, as from the launcher.
+// The launcher initializes UICommon at start-up (for the wiimotes), so does this benchmark.
+//
+// cold: dolphin_main() initializes UICommon again for every game
+// warm: dolphin_main() only reloads the settings (the default)
+//
+// Reported is the time from the call of dolphin_main() to the first frame presented,
+// the game is stopped right after. The first launch is not counted (disk cache).
+//
+// usage: ./WARMSTART <game> [number of runs]
+
+int WINDOW_WIDTH = 1280;
+int WINDOW_HEIGHT = 750;
+bool marley_wiimote = false;
+extern bool dolphin_warm_start;
+int dolphin_main(int argc, char* argv[]);
+
+SDL_Joystick* gGamepad[MAX_GAMEPADS_PLUGGED];
+int devicesPerType[] = {CTRL_TYPE_STD_DEVICES,CTRL_TYPE_WIIMOTE_DEVICES};
+T_DesignatedControllers gDesignatedControllers[MAX_GAMEPADS];
+int gNumDesignatedControllers;
+std::string gBaseDir;
+SDL_Window* gWindow = nullptr;
+
+static double milliseconds(Uint64 start)
+{
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// stops the game after its first frame, returns the time to the first frame in ms
+static double launch(const std::string& game)
+{
+    char arg1[1024], arg2[1024];
+    char* argv[2] = {arg1, arg2};
+    std::atomic<bool> done(false);
+    double firstFrame = -1.0;
+
+    snprintf(arg1, sizeof(arg1), "dolphin-emu");
+    snprintf(arg2, sizeof(arg2), "%s", game.c_str());
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    std::thread watcher([&] {
+        while (!done)
+        {
+            // the frame count of the previous game is reset in Core::Init()
+            if ((Core::GetState() == Core::State::Running) && (Core::GetPresentedFrameCount() > 0))
+            {
+                firstFrame = milliseconds(start);
+                SDL_Event quit;
+                quit.type = SDL_QUIT;
+                SDL_PushEvent(&quit);
+                return;
+            }
+            SDL_Delay(1);
+        }
+    });
+    dolphin_main(2, argv);
+    done = true;
+    watcher.join();
+    return firstFrame;
+}
+
+static double average(const std::string& game, int runs, bool warm)
+{
+    double sum = 0.0;
+    int frames = 0;
+
+    dolphin_warm_start = warm;
+    for (int i = 0; i < runs; i++)
+    {
+        double ms = launch(game);
+        printf("%s run %d: %.1f ms\n", warm ? "warm" : "cold", i, ms);
+        if (ms < 0.0) continue;
+        sum += ms;
+        frames++;
+    }
+    return frames ? sum / frames : -1.0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        printf("usage: %s <game> [number of runs]\n", argv[0]);
+        return 1;
+    }
+    std::string game = argv[1];
+    int runs = (argc > 2) ? atoi(argv[2]) : 5;
+
+    const char* homedir = getenv("HOME");
+    gBaseDir = std::string(homedir ? homedir : ".") + "/.marley/";
+
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_JOYSTICK | SDL_INIT_TIMER) < 0)
+    {
+        printf("SDL could not initialize! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    gWindow = SDL_CreateWindow("warm start benchmark", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                               WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN | SDL_WINDOW_OPENGL);
+    if (!gWindow)
+    {
+        printf("Could not create window. SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    // as initWii() in the launcher
+    UICommon::SetUserDirectory(gBaseDir + "dolphin-emu");
+    UICommon::CreateDirectories();
+    UICommon::Init();
+
+    // not counted, fills the disk cache
+    launch(game);
+
+    double cold = average(game, runs, false);
+    double warm = average(game, runs, true);
+
+    printf("%10s %10s  [ms to the first frame, %d runs]\n", "cold", "warm", runs);
+    printf("%10.1f %10.1f\n", cold, warm);
+
+    UICommon::Shutdown();
+    SDL_DestroyWindow(gWindow);
+    SDL_Quit();
+    return 0;
+}